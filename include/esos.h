@@ -47,7 +47,13 @@
 #include "all_generic.h"
 #include "esos_utils.h"
 #include "esos_task.h"          // defines ESOS tasks and semaphores
+#include "esos_pool.h"          // defines ESOS fixed-block memory pools
 #include "esos_mail.h"          // defines ESOS task mailboxes (eventually make MAILBOXes optional)
+#include "esos_topic.h"         // defines ESOS publish/subscribe topics on task mail
+#include "esos_schema.h"        // defines ESOS typed mail message schemas
+#include "esos_queue.h"         // defines ESOS typed fixed-size message queues
+#include "esos_pipe.h"          // defines ESOS byte-stream pipes
+#include "esos_format.h"        // defines ESOS allocation-free formatted output
 
 // PUT THESE HERE FOR NOW.  They belong somewhere else
 // in the long-run.
@@ -66,8 +72,15 @@
 */
 #if defined(ESOS_USE_SERIAL_PORT)
 #include    "esos_comm.h"
+#include    "esos_frame.h"       // framed binary protocol over a comm channel
 #endif      // USE_USB or USE_SERIAL
 
+/*
+*  deferred binary log.  (ESOS_LOG compiles to nothing unless the user
+*  defines ESOS_USE_LOG.)
+*/
+#include    "esos_log.h"
+
 #ifdef  ESOS_USE_IRQS
 /*
 *  user wants IRQ support, so prototype the required IRQ functions
@@ -372,6 +385,7 @@ typedef   uint8_t                   ESOS_TMR_HANDLE;
 
 void    user_init( void );
 ESOS_TASK_HANDLE   esos_RegisterTask( uint8_t (*pfn_TaskFcn)(struct stTask *pst_Task) );
+ESOS_TASK_HANDLE   esos_RegisterTaskWithMailbox( uint8_t (*pfn_TaskFcn)(struct stTask *pst_Task), uint16_t u16_MailboxLen );
 uint8_t   esos_UnregisterTask( uint8_t (*pfn_TaskFcn)(struct stTask *pst_Task) ) ;
 ESOS_TASK_HANDLE  esos_GetFreeChildTaskStruct();
 ESOS_TASK_HANDLE    esos_GetTaskHandle( uint8_t (*taskname)(ESOS_TASK_HANDLE pstTask) );
@@ -429,6 +443,7 @@ void    __esos_InitCommSystem(void);
  * intead of fcn access
  */
 extern uint8_t        __esos_u8UserTasksRegistered;
+extern struct stTask  __astUserTaskPool[MAX_NUM_USER_TASKS];
 extern uint32_t       __esos_u32UserFlags, __esos_u32SystemFlags;
 
 /**
@@ -442,6 +457,14 @@ extern uint32_t       __esos_u32UserFlags, __esos_u32SystemFlags;
  */
 #define esos_GetNumberRegisteredTasks()        (__esos_u8UserTasksRegistered)
 
+/**
+ * Evaluates to TRUE if the task handle points into the user task pool
+ * (i.e. it is a \ref ESOS_USER_TASK and not a child task).  Services
+ * that keep per-task state indexed by pool slot check this first.
+ * \hideinitializer
+ */
+#define __ESOS_IS_USER_TASK_HANDLE(pstTask)    (((pstTask) >= &__astUserTaskPool[0]) && ((pstTask) < &__astUserTaskPool[MAX_NUM_USER_TASKS]))
+
 /**
  * Returns the system tick value of a future time
  * \param deltaT the number of ticks in the future you'd like the
@@ -35,7 +35,12 @@
  *  This file contains macros, prototypes, and definitions for
  *  circular buffers used by many ESOS services.
  *
- *   \todo Reconcile circular buffer routines to be used in tasks and ISRs!
+ *  Two flavors of circular buffer are provided:
+ *    - \ref CBUFFER  general purpose buffer whose producer and consumer
+ *      are both ESOS tasks (task mailboxes, etc.)
+ *    - \ref SPSCBUFFER  lock-free single-producer/single-consumer ring
+ *      which can be shared by an ISR and a task <em>without</em>
+ *      disabling interrupts (communications buffers, DMA/ADC streams, etc.)
  */
 
 
@@ -47,6 +52,20 @@
 
 /* D E F I N E S ************************************************************/
 
+/**
+* Memory barrier used by the SPSC ring routines.  Guarantees that data
+* written into the ring is visible before the index that publishes it
+* (and vice-versa) to an ISR, DMA engine, or the other side of the ring.
+* \hideinitializer
+*/
+#if defined(__linux)
+#define __ESOS_CB_MEMORY_BARRIER()                          __sync_synchronize()
+#elif defined(__arm__)
+#define __ESOS_CB_MEMORY_BARRIER()                          __asm__ volatile ("dmb" ::: "memory")
+#else
+#define __ESOS_CB_MEMORY_BARRIER()                          __asm__ volatile ("" ::: "memory")
+#endif
+
 /* S T R U C T U R E S ******************************************************/
 
 /**
@@ -62,6 +81,40 @@ typedef struct __stCIRCBUFF {
 
 typedef CBUFFER*    CBUFF_HANDLE;
 
+/**
+* structure to contain a set of descriptors about a lock-free
+* single-producer/single-consumer (SPSC) circular buffer.
+*
+* The producer owns (and is the only writer of) u16_Head, while the
+* consumer owns (and is the only writer of) u16_Tail.  Both indices are
+* free-running, so the number of elements in use is simply their
+* difference.  Neither side performs a read-modify-write on a field
+* owned by the other side, so an ISR and a task can share the ring
+* without a critical section.
+*
+* \note u16_Length <em>MUST</em> be a power of two (no larger than 32768)
+**/
+typedef struct __stSPSCBUFF {
+  uint16_t          u16_Length;                       // maximum number of elements (power of two)
+  volatile uint16_t u16_Head;                         // free-running write index (producer only)
+  volatile uint16_t u16_Tail;                         // free-running read index (consumer only)
+  uint8_t*          pau8_Data;                        // ptr to data area
+} SPSCBUFFER;
+
+/**
+* structure describing bytes that lie, in place, in a SPSC ring.  The
+* bytes may wrap around the end of the ring storage, so they are given
+* as (at most) two contiguous spans.  Read them with
+* \ref __ESOS_SPSC_VIEW_BYTE or span by span.
+**/
+typedef struct __stSPSCVIEW {
+  uint8_t*          pu8_Span1;                        // the oldest bytes
+  uint16_t          u16_Len1;                         // number of bytes in pu8_Span1
+  uint8_t*          pu8_Span2;                        // the rest, from the start of the ring storage
+  uint16_t          u16_Len2;                         // number of bytes in pu8_Span2 (may be 0)
+  uint16_t          u16_Len;                          // total number of bytes in the view
+} SPSCVIEW;
+
 /* M A C R O S ************************************************************/
 #define __ESOS_CB_FLUSH(pstCB)                              (pstCB)->u16_Count = 0
 #define __ESOS_CB_IS_EMPTY(pstCB)                           ((pstCB)->u16_Count == 0)
@@ -72,11 +125,53 @@ typedef CBUFFER*    CBUFF_HANDLE;
 #define __ESOS_CB_GET_AVAILABLE(pstCB)                      (__ESOS_CB_GET_LENGTH(pstCB)-__ESOS_CB_GET_COUNT(pstCB))
 #define __ESOS_CB_IS_AVAILABLE_AT_LEAST(pstCB, x)           (__ESOS_CB_GET_AVAILABLE((pstCB))>=(x))
 #define __ESOS_CB_IS_AVAILABLE_EXACTLY(pstCB, x)            (__ESOS_CB_GET_AVAILABLE((pstCB))==(x))
+#define __ESOS_CB_DISCARD(pstCB, x)                                                     \
+  do {                                                                                  \
+    (pstCB)->u16_Start = ((pstCB)->u16_Start + (x)) % (pstCB)->u16_Length;              \
+    (pstCB)->u16_Count -= (x);                                                          \
+  } while(0)
 
 #define ESOS_TASK_WAIT_WHILE_CB_IS_EMPTY(pstCB)                   ESOS_TASK_WAIT_WHILE(__ESOS_CB_IS_EMPTY((pstCB)))
 #define ESOS_TASK_WAIT_WHILE_CB_IS_FULL(pstCB)                    ESOS_TASK_WAIT_WHILE(__ESOS_CB_IS_FULL((pstCB)))
 #define ESOS_TASK_WAIT_UNTIL_CB_HAS_AVAILABLE_AT_LEAST(pstCB,x)   ESOS_TASK_WAIT_UNTIL(__ESOS_CB_IS_AVAILABLE_AT_LEAST((pstCB),(x)))
 
+#define __ESOS_SPSC_INDEX(pstB, u16x)                       ((u16x) & ((pstB)->u16_Length-1))
+#define __ESOS_SPSC_GET_LENGTH(pstB)                        ((pstB)->u16_Length)
+#define __ESOS_SPSC_GET_COUNT(pstB)                         ((uint16_t)((pstB)->u16_Head - (pstB)->u16_Tail))
+#define __ESOS_SPSC_GET_AVAILABLE(pstB)                     (__ESOS_SPSC_GET_LENGTH(pstB)-__ESOS_SPSC_GET_COUNT(pstB))
+#define __ESOS_SPSC_IS_EMPTY(pstB)                          ((pstB)->u16_Head == (pstB)->u16_Tail)
+#define __ESOS_SPSC_IS_NOT_EMPTY(pstB)                      ((pstB)->u16_Head != (pstB)->u16_Tail)
+#define __ESOS_SPSC_IS_FULL(pstB)                           (__ESOS_SPSC_GET_COUNT(pstB) == __ESOS_SPSC_GET_LENGTH(pstB))
+#define __ESOS_SPSC_IS_AVAILABLE_AT_LEAST(pstB, x)          (__ESOS_SPSC_GET_AVAILABLE((pstB))>=(x))
+#define __ESOS_SPSC_PEEK(pstB, x)                           ((pstB)->pau8_Data[__ESOS_SPSC_INDEX((pstB), (pstB)->u16_Tail+(x))])
+#define __ESOS_SPSC_PEEK_LATEST(pstB)                       ((pstB)->pau8_Data[__ESOS_SPSC_INDEX((pstB), (pstB)->u16_Head-1)])
+// byte x of a SPSCVIEW
+#define __ESOS_SPSC_VIEW_BYTE(pstV, x)                      (((x) < (pstV)->u16_Len1) ? (pstV)->pu8_Span1[(x)] : (pstV)->pu8_Span2[(x)-(pstV)->u16_Len1])
+// returned by __esos_SPSC_ScanUINT8 when none of the bytes is found
+#define __ESOS_SPSC_NOT_FOUND                               0xFFFF
+/**
+* Publishes x bytes stored with \ref __esos_SPSC_PutUINT8Span to the consumer
+* \hideinitializer
+*/
+#define __ESOS_SPSC_COMMIT(pstB, x)                                                     \
+  do {                                                                                  \
+    __ESOS_CB_MEMORY_BARRIER();                                                         \
+    (pstB)->u16_Head += (x);                                                            \
+  } while(0)
+/**
+* Gives the space of the x oldest bytes back to the producer
+* \hideinitializer
+*/
+#define __ESOS_SPSC_RELEASE(pstB, x)                                                    \
+  do {                                                                                  \
+    __ESOS_CB_MEMORY_BARRIER();                                                         \
+    (pstB)->u16_Tail += (x);                                                            \
+  } while(0)
+
+#define ESOS_TASK_WAIT_WHILE_SPSC_IS_EMPTY(pstB)                  ESOS_TASK_WAIT_WHILE(__ESOS_SPSC_IS_EMPTY((pstB)))
+#define ESOS_TASK_WAIT_WHILE_SPSC_IS_FULL(pstB)                   ESOS_TASK_WAIT_WHILE(__ESOS_SPSC_IS_FULL((pstB)))
+#define ESOS_TASK_WAIT_UNTIL_SPSC_HAS_AVAILABLE_AT_LEAST(pstB,x)  ESOS_TASK_WAIT_UNTIL(__ESOS_SPSC_IS_AVAILABLE_AT_LEAST((pstB),(x)))
+
 
 /* E X T E R N S ************************************************************/
 
@@ -96,6 +191,21 @@ uint8_t __esos_CB_ReadUINT8(CBUFFER* pst_CBuffer);
 uint16_t __esos_CB_ReadUINT16(CBUFFER* pst_CBuffer);
 uint32_t __esos_CB_ReadUINT32(CBUFFER* pst_CBuffer);
 void __esos_CB_ReadUINT8Buffer(CBUFFER* pst_CBuffer, uint8_t* pu8_x, uint16_t u16_size );
+uint8_t __esos_CB_WriteUINT8Frame(CBUFFER* pst_CBuffer, uint8_t* pu8_x, uint16_t u16_size );
+void __esos_CB_RemoveUINT8Span(CBUFFER* pst_CBuffer, uint16_t u16_offset, uint16_t u16_size );
+void __esos_CB_PeekUINT8Buffer(CBUFFER* pst_CBuffer, uint16_t u16_offset, uint8_t* pu8_x, uint16_t u16_size );
+
+void __esos_SPSC_Init(SPSCBUFFER* pst_Ring, uint8_t* pau8_ptr, uint16_t u16_Length);
+void __esos_SPSC_Flush(SPSCBUFFER* pst_Ring);
+uint8_t __esos_SPSC_WriteUINT8(SPSCBUFFER* pst_Ring, uint8_t u8_x);
+uint16_t __esos_SPSC_WriteUINT8Buffer(SPSCBUFFER* pst_Ring, uint8_t* pu8_x, uint16_t u16_size);
+uint8_t __esos_SPSC_ReadUINT8(SPSCBUFFER* pst_Ring);
+uint16_t __esos_SPSC_ReadUINT8Buffer(SPSCBUFFER* pst_Ring, uint8_t* pu8_x, uint16_t u16_size);
+uint16_t __esos_SPSC_MoveUINT8Buffer(SPSCBUFFER* pst_To, SPSCBUFFER* pst_From, uint16_t u16_size);
+uint16_t __esos_SPSC_ScanUINT8(SPSCBUFFER* pst_Ring, uint16_t u16_offset, const uint8_t* pau8_Set, uint8_t u8_SetLen);
+void __esos_SPSC_GetView(SPSCBUFFER* pst_Ring, uint16_t u16_size, SPSCVIEW* pst_View);
+void __esos_SPSC_PutUINT8Span(SPSCBUFFER* pst_Ring, uint16_t u16_offset, uint8_t* pu8_x, uint16_t u16_size);
+void __esos_SPSC_GetUINT8Span(SPSCBUFFER* pst_Ring, uint16_t u16_offset, uint8_t* pu8_x, uint16_t u16_size);
 
 /**
 void __esos_CB_Init(MAILBOX* pst_Mailbox);
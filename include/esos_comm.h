@@ -43,31 +43,118 @@
 /* I N C L U D E S **********************************************************/
 #include    "esos.h"
 
+/* S T R U C T U R E S ******************************************************/
+// most delimiters a search of the "in" ring can go on with
+#define   __ESOS_COMM_MAX_SCAN_SET        3
+
+/**
+* structure to describe one communications channel:  its "in" and "out"
+* rings, the child tasks that move data through them for the calling
+* task, the stream locks and the hardware backend that drains "out"
+**/
+typedef struct __stCOMMCHANNEL {
+  SPSCBUFFER              st_Tx;            // "out" ring:  data leaving the MCU
+  SPSCBUFFER              st_Rx;            // "in" ring:  data arriving at the MCU
+  volatile struct stTask  st_ChildTx;       // child task for the "out" stream
+  volatile struct stTask  st_ChildRx;       // child task for the "in" stream
+  volatile uint8_t        u8_Flags;         // "in"/"out" stream locks
+  void                    (*pfn_StartTx)(struct __stCOMMCHANNEL* pst_Chan);   // backend:  start draining st_Tx
+  // working state of the child tasks.  (It lives here, not in static
+  // locals, so child tasks on different channels can run at once.)
+  uint8_t*                pu8_Out;          // next byte to send
+  uint16_t                u16_OutLeft;      // number of bytes left to send
+  uint8_t                 au8_OutScratch[11];   // number-to-text conversions
+  uint16_t                u16_InCount;      // number of bytes received so far
+  uint16_t                u16_InScanEnd;    // "in" ring index up to which records were looked for
+  uint8_t                 au8_InScanSet[__ESOS_COMM_MAX_SCAN_SET];  // ... and the delimiters looked for
+  uint8_t                 u8_InScanSetLen;  // number of bytes in au8_InScanSet (0:  no search to go on with)
+  uint16_t                u16_OutNeed;      // room the formatted text waiting to go out needs
+} ESOS_COMM_CHANNEL;
+
+/**
+* handle to a communications channel
+**/
+typedef ESOS_COMM_CHANNEL*    ESOS_COMM_HANDLE;
+
 /* P R O T O T Y P E S ******************************************************/
 void __esos_InitCommSystem(void);
 uint8_t __esos_u8_GetMSBHexCharFromUint8(uint8_t u8_x);
 uint8_t __esos_u8_GetLSBHexCharFromUint8(uint8_t u8_x);
-ESOS_CHILD_TASK( __esos_OutChar, uint8_t u8_c);
-ESOS_CHILD_TASK( __esos_OutUint8AsDecString, uint8_t u8_x);
-ESOS_CHILD_TASK( __esos_OutUint8AsHexString, uint8_t u8_x);
-ESOS_CHILD_TASK( __esos_OutUint32AsHexString, uint32_t u32_x);
-ESOS_CHILD_TASK( __esos_OutCharBuffer, uint8_t* pu8_out, uint8_t u8_len);
-ESOS_CHILD_TASK( __esos_getBuffer, uint8_t* pau8_buff, uint8_t u8_size);
-ESOS_CHILD_TASK( __esos_getString, char* pau8_buff);
-ESOS_CHILD_TASK( __esos_OutString, char* psz_out );
+void __esos_CommStartTx(ESOS_COMM_HANDLE h_Chan);
+ESOS_CHILD_TASK( __esos_OutChar, ESOS_COMM_HANDLE h_Chan, uint8_t u8_c);
+ESOS_CHILD_TASK( __esos_OutUint8AsDecString, ESOS_COMM_HANDLE h_Chan, uint8_t u8_x);
+ESOS_CHILD_TASK( __esos_OutUint8AsHexString, ESOS_COMM_HANDLE h_Chan, uint8_t u8_x);
+ESOS_CHILD_TASK( __esos_OutUint32AsHexString, ESOS_COMM_HANDLE h_Chan, uint32_t u32_x);
+ESOS_CHILD_TASK( __esos_OutCharBuffer, ESOS_COMM_HANDLE h_Chan, uint8_t* pu8_out, uint16_t u16_len);
+ESOS_CHILD_TASK( __esos_getBuffer, ESOS_COMM_HANDLE h_Chan, uint8_t* pau8_buff, uint16_t u16_size);
+ESOS_CHILD_TASK( __esos_getString, ESOS_COMM_HANDLE h_Chan, char* pau8_buff);
+ESOS_CHILD_TASK( __esos_OutString, ESOS_COMM_HANDLE h_Chan, char* psz_out );
 void __esos_unsafe_PutUint8(uint8_t u8_c);
 void __esos_unsafe_PutString(char* psz_in);
 uint8_t __esos_unsafe_GetUint8(void);
+#ifdef ESOS_USE_DMA_TX
+// DMA TX engine (hardware independent part)
+void __esos_DmaTxNext(void);
+void __esos_DmaTxKick(void);
+void __esos_DmaTxComplete(void);
+// provided by the hardware layer:  start sending u16_Len bytes at pu8_Data
+//   and call __esos_DmaTxComplete() (from its ISR) when they are sent
+void __esos_hw_dma_tx_start(uint8_t* pu8_Data, uint16_t u16_Len);
+#endif
+#ifdef ESOS_USE_DMA_RX
+// DMA RX engine (hardware independent part)
+void __esos_DmaRxUpdate(uint16_t u16_Remaining);
+// provided by the hardware layer:  start circular DMA reception into
+//   the u16_Len byte ring at pu8_Data, and call __esos_DmaRxUpdate()
+//   on half-transfer, transfer-complete and UART idle-line events
+void __esos_hw_dma_rx_start(uint8_t* pu8_Data, uint16_t u16_Len);
+#endif
+#ifdef ESOS_USE_COMM_OUTQ
+ESOS_USER_TASK( __esos_CommOutQDrain );
+#endif
 
 /* D E F I N E S ************************************************************/
 #define ESOS_COMM_SYS_USB       0x80
 #define ESOS_COMM_SYS_SERIAL    0x00
 #define ESOS_COMM_SYS_SERIAL_REV  (ESOS_COMM_SYS_SERIAL + 0x01)
 // size of buffer to catch data incoming to MCU (based on USB terminology)
-#define ESOS_SERIAL_OUT_EP_SIZE    64
+//   (comm buffers are SPSC rings, so sizes MUST be a power of two, and
+//   no larger than 32768.)  Both may be set per build, e.g. with
+//   -DESOS_SERIAL_OUT_EP_SIZE=1024.  Other channels get their sizes
+//   from ESOS_DECLARE_COMM_CHANNEL.
+#ifndef ESOS_SERIAL_OUT_EP_SIZE
+#define ESOS_SERIAL_OUT_EP_SIZE    256
+#endif
 // size of buffer to hold data leaving the MCU (based on USB terminology)
-#define ESOS_SERIAL_IN_EP_SIZE     64
+#ifndef ESOS_SERIAL_IN_EP_SIZE
+#define ESOS_SERIAL_IN_EP_SIZE     256
+#endif
+#if (ESOS_SERIAL_OUT_EP_SIZE & (ESOS_SERIAL_OUT_EP_SIZE-1)) || (ESOS_SERIAL_OUT_EP_SIZE > 32768)
+#error ESOS_SERIAL_OUT_EP_SIZE must be a power of two no larger than 32768
+#endif
+#if (ESOS_SERIAL_IN_EP_SIZE & (ESOS_SERIAL_IN_EP_SIZE-1)) || (ESOS_SERIAL_IN_EP_SIZE > 32768)
+#error ESOS_SERIAL_IN_EP_SIZE must be a power of two no larger than 32768
+#endif
 #define DEFAULT_BAUDRATE      57600
+#ifdef ESOS_USE_COMM_OUTQ
+// size of the shared console output queue (a power of two no larger
+//   than 32768).  Each record in it takes 2 bytes more than its data.
+#ifndef ESOS_COMM_OUTQ_SIZE
+#define ESOS_COMM_OUTQ_SIZE        512
+#endif
+#define __ESOS_COMM_OUTQ_REC_HDR_LEN    2
+// longest record the console output queue can ever hold
+#define ESOS_COMM_OUTQ_MAX_RECORD_LEN   (ESOS_COMM_OUTQ_SIZE-__ESOS_COMM_OUTQ_REC_HDR_LEN)
+// returned (instead of TRUE/FALSE) for a record that can never fit in the queue
+#define ESOS_COMM_OUTQ_TOO_LONG         0xFF
+#endif
+// returned by esos_ChannelFormat() (instead of TRUE/FALSE) for text that
+//   can never fit in the channel's "out" ring
+#define ESOS_COMM_FORMAT_TOO_LONG       0xFE
+
+// bits in ESOS_COMM_CHANNEL.u8_Flags
+#define   __ESOS_COMM_TX_IS_BUSY          ESOS_BIT0
+#define   __ESOS_COMM_RX_IS_BUSY          ESOS_BIT1
 
 /***
  *** A few defines to help make data transfer easier
@@ -86,6 +173,158 @@ uint8_t __esos_unsafe_GetUint8(void);
 
 /* M A C R O S ************************************************************/
 
+/*
+ * COMMUNICATIONS CHANNELS
+ *
+ * Each channel is an independent comm stream with its own buffers,
+ * child tasks, locks and hardware backend.  The "console" channel
+ * (\ref ESOS_COMM_CONSOLE) is created by ESOS on the UART (or USB)
+ * and is what all of the ..._COMM macros below use.  Other channels
+ * are declared with \ref ESOS_DECLARE_COMM_CHANNEL, given a backend in
+ * \ref ESOS_INIT_COMM_CHANNEL, and used with the ..._CHANNEL macros.
+ *
+ * A backend is a function void f(ESOS_COMM_HANDLE h_Chan) that is
+ * called whenever new data is put in h_Chan->st_Tx.  It (or the ISR it
+ * starts) is the consumer of h_Chan->st_Tx, and is the producer of
+ * h_Chan->st_Rx.
+ *
+ * \note The channel argument of the macros below is evaluated more
+ * than once.
+ */
+
+/**
+* The ESOS console channel
+* \hideinitializer
+*/
+#define ESOS_COMM_CONSOLE                     (&__st_CommConsole)
+
+// TRUE if x is a usable comm ring length:  a power of two no larger than 32768
+#define __ESOS_COMM_IS_RING_LEN(x)            (((x) > 0) && ((x) <= 32768) && (((x) & ((x)-1)) == 0))
+
+/**
+* Declares a comm channel (an ESOS_COMM_CHANNEL structure named name)
+* along with u16_txlen bytes of "out" and u16_rxlen bytes of "in" ring
+* storage.  The lengths <em>MUST</em> be powers of two, no larger than
+* 32768 (other lengths do not compile).  The channel
+* must be initialized with \ref ESOS_INIT_COMM_CHANNEL before use.
+* \hideinitializer
+*/
+#define ESOS_DECLARE_COMM_CHANNEL(name, u16_txlen, u16_rxlen)               \
+          typedef char __esos_comm_##name##_ring_sizes                      \
+                 [(__ESOS_COMM_IS_RING_LEN(u16_txlen) && __ESOS_COMM_IS_RING_LEN(u16_rxlen)) ? 1 : -1]; \
+          uint8_t             __au8_##name##_Tx[(u16_txlen)];               \
+          uint8_t             __au8_##name##_Rx[(u16_rxlen)];               \
+          ESOS_COMM_CHANNEL   name
+
+/**
+* Initializes a comm channel declared by \ref ESOS_DECLARE_COMM_CHANNEL
+* and connects it to its hardware backend pfnStartTx.  The lengths must
+* match the declaration.
+* \hideinitializer
+*/
+#define ESOS_INIT_COMM_CHANNEL(name, u16_txlen, u16_rxlen, pfnStartTx)      \
+          esos_InitCommChannel(&(name), __au8_##name##_Tx, (u16_txlen), __au8_##name##_Rx, (u16_rxlen), (pfnStartTx))
+
+#define GET_ESOS_CHANNEL_IN_DATA_LEN(hChan)               __ESOS_SPSC_GET_COUNT( &(hChan)->st_Rx )
+#define IS_ESOS_CHANNEL_GOT_EXACTLY_DATA_BYTES(hChan, x)  (GET_ESOS_CHANNEL_IN_DATA_LEN((hChan)) == (x))
+#define IS_ESOS_CHANNEL_GOT_AT_LEAST_DATA_BYTES(hChan, x) (GET_ESOS_CHANNEL_IN_DATA_LEN((hChan)) >= (x))
+#define FLUSH_ESOS_CHANNEL_IN_DATA(hChan)                 __esos_SPSC_Flush( &(hChan)->st_Rx )
+#define IS_ESOS_CHANNEL_GOT_IN_DATA(hChan)                __ESOS_SPSC_IS_NOT_EMPTY( &(hChan)->st_Rx )
+#define PEEK_ESOS_CHANNEL_IN_DATA(hChan, x)               __ESOS_SPSC_PEEK( &(hChan)->st_Rx, (x) )
+#define PEEK_ESOS_CHANNEL_IN_LATEST_DATA(hChan)           __ESOS_SPSC_PEEK_LATEST( &(hChan)->st_Rx )
+#define IS_ESOS_CHANNEL_READY_OUT_DATA(hChan)             (!__ESOS_SPSC_IS_FULL( &(hChan)->st_Tx ))
+
+/**
+ * Causes the current task to wait (block) until the "in" stream of channel
+ * hChan is available for use, and then marks it in use by the current task.
+ * \sa ESOS_TASK_WAIT_ON_AVAILABLE_IN_COMM()
+ * \hideinitializer
+ */
+#define   ESOS_TASK_WAIT_ON_AVAILABLE_IN_CHANNEL(hChan)                                        \
+            ESOS_TASK_WAIT_WHILE( (hChan)->u8_Flags & __ESOS_COMM_RX_IS_BUSY );                 \
+            (hChan)->u8_Flags |= __ESOS_COMM_RX_IS_BUSY
+
+/**
+ * Causes the current task to wait (block) until the "out" stream of channel
+ * hChan is available for use, and then marks it in use by the current task.
+ * \sa ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM()
+ * \hideinitializer
+ */
+#define   ESOS_TASK_WAIT_ON_AVAILABLE_OUT_CHANNEL(hChan)                                       \
+            ESOS_TASK_WAIT_WHILE( (hChan)->u8_Flags & __ESOS_COMM_TX_IS_BUSY );                 \
+            (hChan)->u8_Flags |= __ESOS_COMM_TX_IS_BUSY
+
+#define   ESOS_TASK_SIGNAL_AVAILABLE_IN_CHANNEL(hChan)    ((hChan)->u8_Flags &= ~__ESOS_COMM_RX_IS_BUSY)
+#define   ESOS_TASK_SIGNAL_AVAILABLE_OUT_CHANNEL(hChan)   ((hChan)->u8_Flags &= ~__ESOS_COMM_TX_IS_BUSY)
+
+/*
+ * The channel versions of the ESOS_TASK_WAIT_ON_GET_xxx and
+ * ESOS_TASK_WAIT_ON_SEND_xxx macros.  They behave exactly like the
+ * console versions (documented below), on channel hChan.
+ */
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_UINT8( hChan, u8_in )                                  \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildRx, __esos_getBuffer, (hChan), &(u8_in), 1 )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_U8BUFFER( hChan, pau8_in, u16_size )                   \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildRx, __esos_getBuffer, (hChan), (pau8_in), (u16_size) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_UINT16( hChan, u16_in )                                \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildRx, __esos_getBuffer, (hChan), (uint8_t*) &(u16_in), 2 )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_UINT32( hChan, u32_in )                                \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildRx, __esos_getBuffer, (hChan), (uint8_t*) &(u32_in), 4 )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_STRING( hChan, pau8_in )                               \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildRx, __esos_getString, (hChan), (pau8_in) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT8( hChan, u8_out )                                \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildTx, __esos_OutChar, (hChan), (u8_out) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT8_AS_HEX_STRING( hChan, u8_out )                  \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildTx, __esos_OutUint8AsHexString, (hChan), (u8_out) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT8_AS_DEC_STRING( hChan, u8_out )                  \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildTx, __esos_OutUint8AsDecString, (hChan), (u8_out) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT32_AS_HEX_STRING( hChan, u32_out )                \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildTx, __esos_OutUint32AsHexString, (hChan), (u32_out) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_STRING( hChan, psz_out )                              \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildTx, __esos_OutString, (hChan), (psz_out) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_U8BUFFER( hChan, pau8_out, u16_size )                 \
+            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&(hChan)->st_ChildTx, __esos_OutCharBuffer, (hChan), (pau8_out), (u16_size) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_FORMATTED( hChan, psz_fmt, ... )                       \
+            ESOS_TASK_WAIT_UNTIL( esos_ChannelFormat( (hChan), (psz_fmt), ##__VA_ARGS__ ) )
+
+/**
+* Waits until the "in" ring of channel hChan holds a whole record ended
+* by the byte u8_delim, and describes it (delimiter included) in the
+* SPSCVIEW *pstView.  Nothing is copied:  the record is parsed where it
+* lies in the ring, and then given back with
+* \ref ESOS_CHANNEL_RELEASE_IN_VIEW.  Each time the task wakes, only the
+* bytes that arrived since it last looked are searched.
+*
+* \note If the ring fills up with no delimiter in it, the view is the
+* whole ring, and does not end with u8_delim.
+* \note The calling task must have the "in" stream of the channel.
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_RECORD( hChan, u8_delim, pstView )                     \
+            ESOS_TASK_WAIT_UNTIL( esos_ChannelGetRecord( (hChan), (u8_delim), (pstView) ) )
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_LINE( hChan, pstView )                                 \
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_RECORD( (hChan), '\n', (pstView) )
+/**
+* Waits until the "in" ring of channel hChan holds u16_size bytes, and
+* describes them in the SPSCVIEW *pstView, in place.  (For records whose
+* length is known, e.g. from a header peeked at first.)  u16_size must
+* not be larger than the ring.
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_CHANNEL_GET_SIZED( hChan, u16_size, pstView )                      \
+            ESOS_TASK_WAIT_UNTIL( esos_ChannelGetSized( (hChan), (u16_size), (pstView) ) )
+/**
+* Gives the space of the bytes in a view back to the "in" ring of
+* channel hChan, all at once.  The view may not be used after this.
+* \hideinitializer
+*/
+#define   ESOS_CHANNEL_RELEASE_IN_VIEW( hChan, pstView )                                       \
+            __ESOS_SPSC_RELEASE( &(hChan)->st_Rx, (pstView)->u16_Len )
+
+/*
+ * THE CONSOLE CHANNEL
+ */
+
 /*
  * Evaluates to the number of bytes in the ESOS "in" communications buffer
  *
@@ -109,7 +348,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \retval N   number of bytes current contained in the "in" buffer
 * \hideinitializer
 */
-#define GET_ESOS_COMM_IN_DATA_LEN()   ((__st_RxBuffer.u16_Head>=__st_RxBuffer.u16_Tail)?(__st_RxBuffer.u16_Head-__st_RxBuffer.u16_Tail):(__st_RxBuffer.u16_Length-__st_RxBuffer.u16_Tail+__st_RxBuffer.u16_Head))
+#define GET_ESOS_COMM_IN_DATA_LEN()   GET_ESOS_CHANNEL_IN_DATA_LEN( ESOS_COMM_CONSOLE )
 
 /**
 * Evaluates to the booelan to determine if "in" communications buffer has
@@ -144,7 +383,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 *
 * \hideinitializer
 */
-#define FLUSH_ESOS_COMM_IN_DATA()             (__st_RxBuffer.u16_Head = __st_RxBuffer.u16_Tail)
+#define FLUSH_ESOS_COMM_IN_DATA()             FLUSH_ESOS_CHANNEL_IN_DATA( ESOS_COMM_CONSOLE )
 
 /**
 * Evaluates to the booelan to determine if "in" communications buffer
@@ -155,7 +394,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 *
 * \hideinitializer
 */
-#define IS_ESOS_COMM_GOT_IN_DATA()            (__st_RxBuffer.u16_Head != __st_RxBuffer.u16_Tail)
+#define IS_ESOS_COMM_GOT_IN_DATA()            IS_ESOS_CHANNEL_GOT_IN_DATA( ESOS_COMM_CONSOLE )
 
 // should use PEEK... It is unsafe since IRQs can occur at anytime....
 /**
@@ -167,15 +406,15 @@ uint8_t __esos_unsafe_GetUint8(void);
 *
 * \note Use sparingly. This macro may be deprecated at some point.
 *
-* \note ESOS communication systems built upon interrupts (most of them) will make
-*  this macro unsafe since the macro could be interrupted.
+* \note The "in" buffer is a lock-free SPSC ring, so peeking from a task is
+*  safe even though the ISR may be adding data at the same time.
 *
 * \param x    byte in FIFO to "peek"
 * \retval data   peeked data byte
 *
 * \hideinitializer
 */
-#define PEEK_ESOS_COMM_IN_DATA(x)             ( __st_RxBuffer.pau8_Data[((__st_RxBuffer.u16_Tail+1+x)% ESOS_SERIAL_OUT_EP_SIZE)] )
+#define PEEK_ESOS_COMM_IN_DATA(x)             PEEK_ESOS_CHANNEL_IN_DATA( ESOS_COMM_CONSOLE, (x) )
 
 /**
 * Evaluates to a "peek" of the most recent data byte written to the "in" communications buffer
@@ -186,14 +425,14 @@ uint8_t __esos_unsafe_GetUint8(void);
 *
 * \note Use sparingly. This macro may be deprecated at some point.
 *
-* \note ESOS communication systems built upon interrupts (most of them) will make
-*  this macro unsafe since the macro could be interrupted.
+* \note The "in" buffer is a lock-free SPSC ring, so peeking from a task is
+*  safe even though the ISR may be adding data at the same time.
 *
 * \retval data   peeked data byte
 *
 * \hideinitializer
 */
-#define PEEK_ESOS_COMM_IN_LATEST_DATA()       ( __st_RxBuffer.pau8_Data[__st_RxBuffer.u16_Head] )
+#define PEEK_ESOS_COMM_IN_LATEST_DATA()       PEEK_ESOS_CHANNEL_IN_LATEST_DATA( ESOS_COMM_CONSOLE )
 
 /**
 * Evaluates to boolean to that determines whether the "out" system can accept anymore
@@ -204,7 +443,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 *
 * \hideinitializer
 */
-#define IS_ESOS_COMM_READY_OUT_DATA()             (__st_TxBuffer.u16_Head != __st_TxBuffer.u16_Tail)
+#define IS_ESOS_COMM_READY_OUT_DATA()             IS_ESOS_CHANNEL_READY_OUT_DATA( ESOS_COMM_CONSOLE )
 
 // communications commands used by ESOS tasks
 /**
@@ -213,9 +452,7 @@ uint8_t __esos_unsafe_GetUint8(void);
  * \sa ESOS_TASK_SIGNAL_AVAILABLE_IN_COMM()
  * \hideinitializer
  */
-#define   ESOS_TASK_WAIT_ON_AVAILABLE_IN_COMM()                                                \
-            ESOS_TASK_WAIT_WHILE( __esos_IsSystemFlagSet( __ESOS_SYS_COMM_RX_IS_BUSY ) );      \
-            __esos_SetSystemFlag( __ESOS_SYS_COMM_RX_IS_BUSY )
+#define   ESOS_TASK_WAIT_ON_AVAILABLE_IN_COMM()         ESOS_TASK_WAIT_ON_AVAILABLE_IN_CHANNEL( ESOS_COMM_CONSOLE )
 
 /**
  * Causes the current task to wait (block) until the ESOS "out" stream is available for
@@ -224,9 +461,7 @@ uint8_t __esos_unsafe_GetUint8(void);
  * \sa ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM()
  * \hideinitializer
  */
-#define   ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM()                                                \
-            ESOS_TASK_WAIT_WHILE( __esos_IsSystemFlagSet( __ESOS_SYS_COMM_TX_IS_BUSY ) );       \
-            __esos_SetSystemFlag( __ESOS_SYS_COMM_TX_IS_BUSY )
+#define   ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM()        ESOS_TASK_WAIT_ON_AVAILABLE_OUT_CHANNEL( ESOS_COMM_CONSOLE )
 
 /**
  * Signals to other requesting tasks that the current task is making the ESOS "in" stream
@@ -235,7 +470,7 @@ uint8_t __esos_unsafe_GetUint8(void);
  * \sa ESOS_TASK_WAIT_ON_AVAILABLE_IN_COMM()
  * \hideinitializer
  */
-#define   ESOS_TASK_SIGNAL_AVAILABLE_IN_COMM()         __esos_ClearSystemFlag( __ESOS_SYS_COMM_RX_IS_BUSY )
+#define   ESOS_TASK_SIGNAL_AVAILABLE_IN_COMM()         ESOS_TASK_SIGNAL_AVAILABLE_IN_CHANNEL( ESOS_COMM_CONSOLE )
 
 /**
  * Signals to other requesting tasks that the current task is making the ESOS "out" stream
@@ -243,7 +478,7 @@ uint8_t __esos_unsafe_GetUint8(void);
  * \sa ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM()
  * \hideinitializer
  */
-#define   ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM()         __esos_ClearSystemFlag( __ESOS_SYS_COMM_TX_IS_BUSY )
+#define   ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM()         ESOS_TASK_SIGNAL_AVAILABLE_OUT_CHANNEL( ESOS_COMM_CONSOLE )
 
 /**
  * Signals to other requesting tasks that the ESOS "in" stream is being released or
@@ -282,7 +517,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_GET_UINT8( u8_in )                                    \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskRx, __esos_getBuffer, &(u8_in), 1 )
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_UINT8( ESOS_COMM_CONSOLE, u8_in )
 
 /**
 * Create, spawn and wait on a child task to get an array of bytes (uint8s) from the ESOS "in" communications buffer
@@ -293,13 +528,16 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \note This macro does not evaluate to anything.  Data is returned in the argument variable because
 *  of the way ESOS tasks, child tasks, and macros are used.
 *
+* \note u16_size may be larger than the "in" buffer.  The data is taken
+*  out of the buffer as it arrives.
+*
 * \param pau8_in    pointer to array <em>in which</em> bytes should be returned
-* \param u8_size    number of bytes to read from "in" stream
+* \param u16_size   number of bytes to read from "in" stream
 * \sa ESOS_TASK_SPAWN_AND_WAIT
 * \hideinitializer
 */
-#define   ESOS_TASK_WAIT_ON_GET_U8BUFFER( pau8_in, u8_size)                                                \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE) &__stChildTaskRx, __esos_getBuffer, (pau8_in), (u8_size) )
+#define   ESOS_TASK_WAIT_ON_GET_U8BUFFER( pau8_in, u16_size)                                               \
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_U8BUFFER( ESOS_COMM_CONSOLE, pau8_in, u16_size )
 
 /**
 * Create, spawn and wait on a child task to get a double-byte value (uint16) from the ESOS "in" communications buffer
@@ -315,7 +553,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_GET_UINT16( u16_in )                                    \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskRx, __esos_getBuffer, (uint8_t*) &(u16_in), 2 )
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_UINT16( ESOS_COMM_CONSOLE, u16_in )
 
 /**
 * Create, spawn and wait on a child task to get a quad-byte value (uint32) from the ESOS "in" communications buffer
@@ -331,7 +569,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_GET_UINT32( u32_in )                                    \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskRx, __esos_getBuffer, (uint8_t*) &(u32_in), 4 )
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_UINT32( ESOS_COMM_CONSOLE, u32_in )
 
 
 
@@ -354,7 +592,41 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_GET_STRING( pau8_in )                                                \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskRx, __esos_getString, (pau8_in) )
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_STRING( ESOS_COMM_CONSOLE, pau8_in )
+
+/**
+* Waits until the ESOS "in" communications buffer holds a whole record ended by u8_delim,
+* and describes it in place (no copy) in the SPSCVIEW *pstView
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_GET_RECORD
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_GET_RECORD( u8_delim, pstView )                                      \
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_RECORD( ESOS_COMM_CONSOLE, (u8_delim), (pstView) )
+
+/**
+* Waits until the ESOS "in" communications buffer holds a whole line (ended by a newline),
+* and describes it in place (no copy) in the SPSCVIEW *pstView
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_GET_RECORD
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_GET_LINE( pstView )                                                  \
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_LINE( ESOS_COMM_CONSOLE, (pstView) )
+
+/**
+* Waits until the ESOS "in" communications buffer holds u16_size bytes, and describes them
+* in place (no copy) in the SPSCVIEW *pstView
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_GET_SIZED
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_GET_SIZED( u16_size, pstView )                                       \
+            ESOS_TASK_WAIT_ON_CHANNEL_GET_SIZED( ESOS_COMM_CONSOLE, (u16_size), (pstView) )
+
+/**
+* Gives the space of the bytes in a view back to the ESOS "in" communications buffer
+* \sa ESOS_CHANNEL_RELEASE_IN_VIEW
+* \hideinitializer
+*/
+#define   ESOS_COMM_RELEASE_IN_VIEW( pstView )      ESOS_CHANNEL_RELEASE_IN_VIEW( ESOS_COMM_CONSOLE, (pstView) )
 
 /**
 * Create, spawn and wait on a child task to put a byte (uint8) to the ESOS "out" communications buffer
@@ -365,7 +637,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_SEND_UINT8( u8_out)         \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE) &__stChildTaskTx, __esos_OutChar, (u8_out) )
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT8( ESOS_COMM_CONSOLE, u8_out )
 
 /**
 * Create, spawn and wait on a child task to put a byte (uint8) to the ESOS "out" communications buffer as a human-readable
@@ -377,7 +649,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_SEND_UINT8_AS_HEX_STRING( u8_out)         \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskTx, __esos_OutUint8AsHexString, (u8_out) )
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT8_AS_HEX_STRING( ESOS_COMM_CONSOLE, u8_out )
 
 
 /**
@@ -390,7 +662,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_SEND_UINT8_AS_DEC_STRING( u8_out)           \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskTx, __esos_OutUint8AsDecString,(u8_out))
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT8_AS_DEC_STRING( ESOS_COMM_CONSOLE, u8_out )
 /**
 * Create, spawn and wait on a child task to put a 32-bit value (uint32) to the ESOS "out" communications buffer as a human-readable
 * hexadecimal string.  Results will look like "0x0123BEEF"
@@ -401,7 +673,7 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_SEND_UINT32_AS_HEX_STRING( u32_out)         \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskTx, __esos_OutUint32AsHexString, (u32_out) )
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT32_AS_HEX_STRING( ESOS_COMM_CONSOLE, u32_out )
 
 /**
 * Create, spawn and wait on a child task to put a zero-terminated string to the ESOS "out" communications buffer.
@@ -412,28 +684,100 @@ uint8_t __esos_unsafe_GetUint8(void);
 * \hideinitializer
 */
 #define   ESOS_TASK_WAIT_ON_SEND_STRING( psz_out)         \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskTx, __esos_OutString, (psz_out) )
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_STRING( ESOS_COMM_CONSOLE, psz_out )
 
 /**
 * Create, spawn and wait on a child task to put an array of bytes (uint8s) to the ESOS "out" communications buffer
 *
 * \note This call will block the current task until the data is absorbed by the ESOS communications subsystem
+* \note u16_size may be larger than the "out" buffer.  The array is then
+*  streamed through the buffer in chunks, as the hardware drains it.  Hold
+*  the "out" stream (\ref ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM) around a
+*  frame sent in several calls so that no other task's output lands
+*  inside it.
 * \param pau8_out   pointer to beginning of array of bytes to send to "out" stream
-* \param u8_size   number of bytes to send
+* \param u16_size   number of bytes to send
 * \sa ESOS_TASK_SPAWN_AND_WAIT
 * \hideinitializer
 */
-#define   ESOS_TASK_WAIT_ON_SEND_U8BUFFER( pau8_out, u8_size)         \
-            ESOS_TASK_SPAWN_AND_WAIT( (ESOS_TASK_HANDLE)&__stChildTaskTx, __esos_OutCharBuffer, (pau8_out), (u8_size) )
+#define   ESOS_TASK_WAIT_ON_SEND_U8BUFFER( pau8_out, u16_size)        \
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_U8BUFFER( ESOS_COMM_CONSOLE, pau8_out, u16_size )
 
+/**
+* Waits until there is room in the ESOS "out" communications buffer, and
+* then formats text (printf-style, see esos_format.h) straight into it.
+* No libc printf, heap or intermediate buffer is used.
+*
+* \note The text goes in all at once.  While the task waits for room
+*  only the needed length is checked, the text is not formatted again.
+*  Text longer than the whole "out" buffer is dropped (not sent), and
+*  the task goes on.
+* \note The arguments are evaluated again when the text is finally
+*  written, so (like the other macros) they should not be locals.
+* \param psz_fmt    the format string, followed by its arguments
+* \sa esos_ChannelFormat
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_SEND_FORMATTED( psz_fmt, ... )             \
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_FORMATTED( ESOS_COMM_CONSOLE, psz_fmt, ##__VA_ARGS__ )
 
-/* S T R U C T U R E S ******************************************************/
 
 
+#ifdef ESOS_USE_COMM_OUTQ
+/*
+ * THE CONSOLE OUTPUT QUEUE
+ *
+ * With ESOS_USE_COMM_OUTQ defined, tasks can hand complete records
+ * (lines of text, binary frames) to a shared output queue instead of
+ * taking the console's "out" stream.  A system task drains the queue
+ * into the console, one whole record at a time, so records from
+ * different tasks are never mixed.  Producers only wait when the queue
+ * itself is full.  A record longer than ESOS_COMM_OUTQ_MAX_RECORD_LEN
+ * bytes can never fit.  It is rejected (the calls return
+ * ESOS_COMM_OUTQ_TOO_LONG) and the WAIT macros return without sending it.
+ */
+/**
+* Blocks the current task until the u16_size bytes at pau8_out have been
+* added to the console output queue as one record.  The bytes are copied
+* when the wait ends, so the buffer may be reused right away.  (Since
+* tasks lose their local variables when they block, it should be a static.)
+* \sa esos_CommQueueOutput
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_QUEUED_SEND_U8BUFFER( pau8_out, u16_size )                          \
+            ESOS_TASK_WAIT_UNTIL( esos_CommQueueOutput( (uint8_t*)(pau8_out), (u16_size) ) )
+
+/**
+* Blocks the current task until the zero-terminated string psz_out has
+* been added to the console output queue as one record.
+* \sa esos_CommQueueOutputString
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_QUEUED_SEND_STRING( psz_out )                                       \
+            ESOS_TASK_WAIT_UNTIL( esos_CommQueueOutputString( (char*)(psz_out) ) )
+
+/**
+* Blocks the current task until text formatted printf-style (see
+* esos_format.h) has been added to the console output queue as one record.
+* \sa esos_CommQueueFormat
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_QUEUED_SEND_FORMATTED( psz_fmt, ... )                               \
+            ESOS_TASK_WAIT_UNTIL( esos_CommQueueFormat( (psz_fmt), ##__VA_ARGS__ ) )
+#endif
+
 /* E X T E R N S ************************************************************/
+extern SPSCBUFFER*                      __pst_CB_Tx;
+extern SPSCBUFFER*                      __pst_CB_Rx;
 extern volatile uint8_t                 __esos_comm_tx_buff[ESOS_SERIAL_IN_EP_SIZE];
 extern volatile uint8_t                 __esos_comm_rx_buff[ESOS_SERIAL_OUT_EP_SIZE];
-extern volatile struct stTask           __stChildTaskTx, __stChildTaskRx;
+extern ESOS_COMM_CHANNEL                __st_CommConsole;
+#ifdef ESOS_USE_DMA_RX
+extern volatile uint16_t                __u16_DmaRxOverruns;
+#endif
+#ifdef ESOS_USE_COMM_OUTQ
+extern SPSCBUFFER                       __st_CommOutQ;
+#endif
 
 /* P U B L I C  P R O T O T Y P E S *****************************************/
 /**
@@ -445,20 +789,42 @@ uint8_t esos_GetCommSystemVersion(void);
 
 /**
 * Returns the size of the ESOS communication systems "out" buffers
-* \retval uint8_t   Number of bytes
+* \retval uint16_t  Number of bytes
 * \hideinitializer
 */
-uint8_t esos_GetCommSystemMaxOutDataLen(void);
+uint16_t esos_GetCommSystemMaxOutDataLen(void);
 
 /**
 * Returns the size of the ESOS communication systems "in" buffers
-* \retval uint8_t   Number of bytes
+* \retval uint16_t  Number of bytes
 * \hideinitializer
 */
-uint8_t esos_GetCommSystemMaxInDataLen(void);
+uint16_t esos_GetCommSystemMaxInDataLen(void);
 
 void  __esos_InitCommSystem(void);
 
+/**
+* Initializes a comm channel (use \ref ESOS_INIT_COMM_CHANNEL instead)
+* \param h_Chan        the channel
+* \param pau8_Tx       storage for the "out" ring
+* \param u16_TxLen     length of the "out" ring (a power of two)
+* \param pau8_Rx       storage for the "in" ring
+* \param u16_RxLen     length of the "in" ring (a power of two)
+* \param pfn_StartTx   hardware backend:  called when there is new data in the "out" ring
+*/
+void esos_InitCommChannel(ESOS_COMM_HANDLE h_Chan, uint8_t* pau8_Tx, uint16_t u16_TxLen,
+                          uint8_t* pau8_Rx, uint16_t u16_RxLen, void (*pfn_StartTx)(ESOS_COMM_HANDLE h_Chan));
+uint8_t esos_ChannelFormat(ESOS_COMM_HANDLE h_Chan, const char* psz_Fmt, ...);
+uint8_t esos_ChannelGetRecord(ESOS_COMM_HANDLE h_Chan, uint8_t u8_Delim, SPSCVIEW* pst_View);
+uint8_t esos_ChannelGetSized(ESOS_COMM_HANDLE h_Chan, uint16_t u16_Size, SPSCVIEW* pst_View);
+uint16_t __esos_CommScanIn(ESOS_COMM_HANDLE h_Chan, const uint8_t* pau8_Set, uint8_t u8_SetLen, uint16_t u16_Max);
+
+#ifdef ESOS_USE_COMM_OUTQ
+uint8_t esos_CommQueueOutput(uint8_t* pu8_Data, uint16_t u16_Len);
+uint8_t esos_CommQueueOutputString(char* psz_Out);
+uint8_t esos_CommQueueFormat(const char* psz_Fmt, ...);
+#endif
+
 /* prototypes of the unsafe comm functions provided by ESOS */
 void __esos_unsafe_PutUint8(uint8_t u8_c);
 void __esos_unsafe_PutString(char* psz_in);
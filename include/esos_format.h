@@ -0,0 +1,100 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Format_Service
+ * @{
+ */
+
+/** \file
+ *  This file contains macros, prototypes, and definitions for the
+ *  ESOS formatted output engine.
+ *
+ *  The engine is a compact printf-style formatter that needs no
+ *  intermediate buffer, no heap and no libc printf.  It writes the
+ *  text straight into its destination:  a plain character buffer
+ *  (\ref esos_FormatString) or the free space of a \ref SPSCBUFFER ring
+ *  (such as a comm channel's "out" ring, see esos_comm.h).  Decimal
+ *  numbers are converted two digits at a time from a digit-pair table.
+ *
+ *  Conversions are written %[flags][width][.precision][length]type.
+ *  - flags      '-' left-justify, '0' pad with zeros, '+' and ' ' sign of
+ *               positive numbers, '#' 0x/0X in front of hex numbers
+ *  - width      digits, or '*' to take it from the argument list
+ *  - precision  digits, or '*'.  The minimum number of digits for
+ *               integers, the maximum number of characters for 's', and
+ *               the number of decimals for 'q'
+ *  - length     'hh' 8-bit, 'h' 16-bit, (none) int, 'l' long, 'll' 64-bit
+ *  - type       'd'/'i' signed decimal, 'u' unsigned decimal, 'x'/'X'
+ *               hex, 'c' character, 's' string, '%' a percent sign, and
+ *               'q' fixed-point:  a signed integer counted in units of
+ *               10^-precision, e.g. ("%.3q", 12345) gives "12.345"
+ *
+ *  Floating point is not supported.  Precisions for 'q' above 9 are
+ *  treated as 9.
+ */
+
+#ifndef   ESOS_FORMAT_H
+#define ESOS_FORMAT_H
+
+/* I N C L U D E S **********************************************************/
+#include    "esos.h"
+#include    "esos_cb.h"
+#include    <stdarg.h>
+
+/* S T R U C T U R E S ******************************************************/
+/**
+* Where the formatter writes.  Position n of the output goes to
+* pau8_Data[(u16_Start+n) & u16_Mask], as long as n < u16_Room.  (A flat
+* buffer has a mask of 0xFFFF and a start of 0.)  Output that does not
+* fit is still counted in u16_Len.
+**/
+typedef struct __stFMTSINK {
+  uint8_t*          pau8_Data;        // ptr to the destination storage
+  uint16_t          u16_Mask;         // index mask (ring length - 1)
+  uint16_t          u16_Start;        // index of output position 0
+  uint16_t          u16_Room;         // number of bytes that may be written
+  uint16_t          u16_Len;          // length of the output so far
+} ESOS_FMT_SINK;
+
+/* D E F I N E S ************************************************************/
+// returned by the ring formatters when the output does not fit
+#define ESOS_FORMAT_NO_ROOM       0xFFFF
+
+/* P U B L I C  P R O T O T Y P E S *****************************************/
+uint16_t    esos_FormatString(char* pc_Buf, uint16_t u16_Size, const char* psz_Fmt, ...);
+uint16_t    esos_VFormatString(char* pc_Buf, uint16_t u16_Size, const char* psz_Fmt, va_list ap);
+uint16_t    esos_FormatToRing(SPSCBUFFER* pst_Ring, uint16_t u16_Offset, const char* psz_Fmt, ...);
+uint16_t    esos_VFormatToRing(SPSCBUFFER* pst_Ring, uint16_t u16_Offset, const char* psz_Fmt, va_list ap);
+
+/* P R I V A T E    P R O T O T Y P E S ***********************************/
+void        __esos_VFormat(ESOS_FMT_SINK* pst_Sink, const char* psz_Fmt, va_list ap);
+
+/** @} */
+
+#endif    // ESOS_FORMAT_H
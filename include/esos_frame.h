@@ -0,0 +1,168 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Frame_Service
+ * @{
+ */
+
+/** \file
+ *  This file contains macros, prototypes, and definitions for the
+ *  ESOS framed binary protocol over a comm channel.
+ *
+ *  A frame carries a one-byte type and up to a few hundred bytes of
+ *  binary data.  On the wire it is
+ *    COBS( [type][data...][CRC, 16-bit little-endian] ) 0x00
+ *  The CRC is the CRC-16/CCITT (\ref esos_buffer_crc16) of the type and
+ *  the data.  COBS (Consistent Overhead Byte Stuffing) removes every
+ *  zero byte from the frame for a cost of one byte in 254, so the zero
+ *  that ends a frame never shows up inside one.  A receiver that starts
+ *  listening part way through a frame (or sees a bad CRC) loses only
+ *  that frame and picks up again at the next zero.
+ *
+ *  Frames are sent with \ref esos_ChannelSendFrame, which encodes the
+ *  frame straight into the channel's "out" ring.  They are received by
+ *  an \ref ESOS_FRAME_DECODER.  It decodes bytes as they come, straight
+ *  out of the channel's "in" ring, into a buffer given by the user.
+ *  Each good frame goes to the handler in the decoder's table for its
+ *  type.  Handlers are plain functions called from the task that runs
+ *  the decoder, so they must not block.  (Hand long jobs off to a task
+ *  with mail, for instance.)
+ *
+ *  tools/esos_frame.py builds and reads the frames on the host.
+ */
+
+#ifndef   ESOS_FRAME_H
+#define ESOS_FRAME_H
+
+/* I N C L U D E S **********************************************************/
+#include    "esos.h"
+#include    "esos_cb.h"
+#include    "esos_comm.h"
+
+/* S T R U C T U R E S ******************************************************/
+/**
+* Function called with each good frame of its type.  pau8_Data points
+* into the decoder's buffer and is only good until the handler returns.
+**/
+typedef void (*ESOS_FRAME_HANDLER_FN)(uint8_t u8_Type, uint8_t* pau8_Data, uint16_t u16_Len);
+
+/**
+* One entry of a decoder's handler table
+**/
+typedef struct __stFRAMEHANDLER {
+  uint8_t                   u8_Type;          // frame type
+  ESOS_FRAME_HANDLER_FN     pfn_Handler;      // its handler
+} ESOS_FRAME_HANDLER;
+
+/**
+* State of a frame decoder.  Set it up with \ref esos_InitFrameDecoder.
+**/
+typedef struct __stFRAMEDECODER {
+  uint8_t*                  pau8_Buf;         // decoded frame:  type, data and CRC
+  uint16_t                  u16_Size;         // size of pau8_Buf
+  uint16_t                  u16_Len;          // number of bytes decoded so far
+  uint8_t                   u8_Code;          // COBS code of the current block (0 = none yet)
+  uint8_t                   u8_Left;          // bytes left in the current block
+  uint8_t                   u8_Flags;         // decoder state
+  uint8_t                   u8_NumHandlers;   // number of entries in pst_Handlers
+  const ESOS_FRAME_HANDLER* pst_Handlers;     // handler table
+  ESOS_FRAME_HANDLER_FN     pfn_Default;      // called for types not in the table (may be NULLPTR)
+  // statistics
+  uint16_t                  u16_Frames;       // good frames
+  uint16_t                  u16_Errors;       // frames lost to bad CRC, bad COBS or overflow
+} ESOS_FRAME_DECODER;
+
+/* D E F I N E S ************************************************************/
+// bytes the type and CRC add to the data of a frame
+#define ESOS_FRAME_OVERHEAD             3
+/**
+* Largest number of bytes a frame with u16_DataLen bytes of data takes
+* on the wire (COBS code bytes and the closing zero included)
+* \hideinitializer
+*/
+#define ESOS_FRAME_WIRE_LEN(u16_DataLen)  ((u16_DataLen)+ESOS_FRAME_OVERHEAD+((u16_DataLen)+ESOS_FRAME_OVERHEAD)/254+2)
+
+/* M A C R O S ************************************************************/
+/**
+* Waits for data in the "in" ring of channel hChan, then decodes all of
+* it and calls the handlers of the frames it completes.  The calling
+* task must have the "in" stream of the channel
+* (\ref ESOS_TASK_WAIT_ON_AVAILABLE_IN_CHANNEL), and normally keeps it.
+*
+* \param hChan      the channel
+* \param pstDec     pointer to the \ref ESOS_FRAME_DECODER
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_CHANNEL_FRAMES(hChan, pstDec)                                  \
+            do {                                                                           \
+              ESOS_TASK_WAIT_WHILE( __ESOS_SPSC_IS_EMPTY( &(hChan)->st_Rx ) );            \
+              esos_FrameDecode( (pstDec), &(hChan)->st_Rx );                               \
+            } while(0)
+
+/**
+* Waits for data from the console and decodes it.
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_FRAMES
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_FRAMES(pstDec)          ESOS_TASK_WAIT_ON_CHANNEL_FRAMES( ESOS_COMM_CONSOLE, (pstDec) )
+
+/**
+* Waits until the whole frame fits in the "out" ring of channel hChan,
+* then sends it.  The calling task must have the "out" stream of the
+* channel (\ref ESOS_TASK_WAIT_ON_AVAILABLE_OUT_CHANNEL).
+*
+* \param hChan      the channel
+* \param u8_Type    frame type
+* \param pau8_Data  the data.  (It is read again each time the task
+* wakes, so make it a static.)
+* \param u16_Len    number of bytes of data
+* \note The frame (see \ref ESOS_FRAME_WIRE_LEN) must fit in the ring.
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_CHANNEL_SEND_FRAME(hChan, u8_Type, pau8_Data, u16_Len)         \
+            ESOS_TASK_WAIT_UNTIL( esos_ChannelSendFrame( (hChan), (u8_Type), (pau8_Data), (u16_Len) ) )
+
+/**
+* Sends a frame to the console.
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_SEND_FRAME
+* \hideinitializer
+*/
+#define   ESOS_TASK_WAIT_ON_SEND_FRAME(u8_Type, pau8_Data, u16_Len)                        \
+            ESOS_TASK_WAIT_ON_CHANNEL_SEND_FRAME( ESOS_COMM_CONSOLE, (u8_Type), (pau8_Data), (u16_Len) )
+
+/* P U B L I C  P R O T O T Y P E S *****************************************/
+void        esos_InitFrameDecoder(ESOS_FRAME_DECODER* pst_Dec, uint8_t* pau8_Buf, uint16_t u16_Size,
+                                  const ESOS_FRAME_HANDLER* pst_Handlers, uint8_t u8_NumHandlers,
+                                  ESOS_FRAME_HANDLER_FN pfn_Default);
+uint16_t    esos_FrameDecode(ESOS_FRAME_DECODER* pst_Dec, SPSCBUFFER* pst_Ring);
+uint8_t     esos_ChannelSendFrame(ESOS_COMM_HANDLE h_Chan, uint8_t u8_Type, uint8_t* pau8_Data, uint16_t u16_Len);
+
+/** @} */
+
+#endif    // ESOS_FRAME_H
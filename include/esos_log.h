@@ -0,0 +1,152 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Log_Service
+ * @{
+ */
+
+/** \file
+ *  This file contains macros, prototypes, and definitions for the
+ *  ESOS deferred binary log.
+ *
+ *  \ref ESOS_LOG takes a printf-style format string (see esos_format.h)
+ *  but does <em>not</em> format anything on the target.  Each format
+ *  string is placed in its own linker section ("esos_log") and a log
+ *  record carries only the string's offset in that section, the system
+ *  tick since the previous record, and the raw argument values.  The
+ *  records go into a lock-free ring and a system task sends them out
+ *  the log channel (\ref ESOS_COMM_CONSOLE unless changed with
+ *  \ref esos_SetLogChannel) when it is free.  The host-side tool
+ *  tools/esos_logdecode.py reads the format strings out of the ELF file
+ *  of the build and turns the records back into text.
+ *
+ *  A record is laid out as
+ *    [0xFF][length][format id, 16-bit little-endian][tick delta][arguments...]
+ *  where length counts every byte of the record after itself.  The tick
+ *  delta and integer arguments are LEB128 varints, with signed ones
+ *  ('d', 'i', 'q') zigzag-encoded first.  A 'c' argument is one byte and
+ *  an 's' argument is a varint length followed by the characters (a
+ *  NULLPTR string is sent as "(null)", as esos_format.h prints it).  A '*'
+ *  width or precision is sent as an integer argument.
+ *
+ *  The 0xFF sync byte never starts text (it is neither ASCII nor UTF-8),
+ *  so the decoder looks for records only there, and passes other bytes
+ *  written to the same channel through as text.  A record that does not
+ *  check out is passed through too, and the decoder picks up again at
+ *  the next sync byte.
+ *
+ *  \ref ESOS_LOG never blocks and may be used from a task or an ISR.
+ *  When the ring is full the record is dropped and counted.  The count
+ *  is sent as a record of its own once the ring drains.
+ *
+ *  Logging is turned on by defining ESOS_USE_LOG.  Without it, the
+ *  \ref ESOS_LOG statements compile to nothing.
+ */
+
+#ifndef   ESOS_LOG_H
+#define ESOS_LOG_H
+
+/* I N C L U D E S **********************************************************/
+#include    "esos.h"
+
+#ifdef    ESOS_USE_LOG
+#include    "esos_cb.h"
+#include    "esos_comm.h"
+
+/* D E F I N E S ************************************************************/
+// size of the ring holding the log records.  MUST be a power of two.
+#ifndef ESOS_LOG_RING_SIZE
+#define ESOS_LOG_RING_SIZE              256
+#endif
+// longest record ESOS_LOG can build.  (Records are built on the stack
+// of the caller, and longer strings are cut short to fit.)
+#ifndef ESOS_LOG_MAX_RECORD_LEN
+#define ESOS_LOG_MAX_RECORD_LEN         64
+#endif
+
+#if (ESOS_LOG_RING_SIZE & (ESOS_LOG_RING_SIZE-1)) || (ESOS_LOG_RING_SIZE > 32768)
+#error "ESOS_LOG_RING_SIZE must be a power of two no larger than 32768"
+#endif
+#if (ESOS_LOG_MAX_RECORD_LEN < 9) || (ESOS_LOG_MAX_RECORD_LEN > 256) || (ESOS_LOG_MAX_RECORD_LEN > ESOS_LOG_RING_SIZE)
+#error "ESOS_LOG_MAX_RECORD_LEN must be in 9..256 and fit in the log ring"
+#endif
+
+// first byte of every log record
+#define ESOS_LOG_SYNC                   0xFF
+
+// the linker section holding the format strings
+#define __ESOS_LOG_SECTION              __attribute__((section("esos_log"), used))
+
+/**
+* Logs a message with printf-style arguments.  Only the format string's
+* id and the raw argument values are recorded; the text is rebuilt on
+* the host.
+*
+* \param psz_Fmt    the format string.  It <em>MUST</em> be a string literal.
+* \note Never blocks, so it may be used from an ISR.
+* \note The value of each argument is taken when the record is made, but
+* 's' strings are copied, so they need not outlive the call.
+* \hideinitializer
+*/
+#define ESOS_LOG(psz_Fmt, ...)                                                          \
+  do {                                                                                  \
+    static const char __ac_LogFmt[] __ESOS_LOG_SECTION = psz_Fmt;                       \
+    __esos_Log( __ac_LogFmt, ##__VA_ARGS__ );                                           \
+  } while(0)
+
+/**
+* Waits until the log ring is empty, i.e. every record made so far has
+* been handed to the log channel.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_LOG_FLUSHED()                 ESOS_TASK_WAIT_UNTIL( __ESOS_SPSC_IS_EMPTY( &__st_LogRing ) )
+
+/* E X T E R N S ************************************************************/
+extern SPSCBUFFER           __st_LogRing;
+extern volatile uint16_t    __u16_LogDropped;
+
+/* P U B L I C  P R O T O T Y P E S *****************************************/
+void        esos_SetLogChannel(ESOS_COMM_HANDLE h_Chan);
+uint16_t    esos_GetLogDropped(void);
+
+/* P R I V A T E    P R O T O T Y P E S ***********************************/
+void        __esos_InitLog(void);
+uint8_t     __esos_Log(const char* psz_Fmt, ...);
+ESOS_USER_TASK( __esos_LogDrain );
+
+#else     // ESOS_USE_LOG
+
+#define ESOS_LOG(psz_Fmt, ...)          do { } while(0)
+#define ESOS_TASK_WAIT_ON_LOG_FLUSHED() do { } while(0)
+
+#endif    // ESOS_USE_LOG
+
+/** @} */
+
+#endif    // ESOS_LOG_H
@@ -47,12 +47,37 @@
 /* I N C L U D E S **********************************************************/
 #include    "esos.h"
 #include    "esos_cb.h"
+#include    "esos_pool.h"
 
 // TODO  we have included esos.h but for some reason the MAX_NUM_USER_TASKS
 //  define is not being found in the declaration of mailboxes below??????
 
 /* S T R U C T U R E S ******************************************************/
 
+#ifdef ESOS_USE_MAIL_STATS
+/**
+* Number of bins in the mail latency histogram.  Bin 0 counts messages
+* read in the same tick they were posted.  Bin N counts latencies of
+* 2^(N-1) to 2^N-1 ticks.  The last bin also counts everything longer.
+**/
+#ifndef ESOS_MAIL_STATS_NUM_BINS
+#define ESOS_MAIL_STATS_NUM_BINS        16
+#endif
+
+/**
+* structure to hold the usage statistics of a task mailbox
+**/
+typedef struct __stMAILSTATS {
+  uint16_t          u16_NumBytes;                     // bytes in mailbox now (snapshots only)
+  uint16_t          u16_NumMsgs;                      // messages in mailbox now (snapshots only)
+  uint16_t          u16_MaxBytes;                     // most bytes ever in mailbox at once
+  uint32_t          u32_NumSent;                      // messages delivered into mailbox
+  uint32_t          u32_NumRead;                      // messages read out of mailbox
+  uint32_t          u32_NumRejected;                  // sends refused (mailbox full or malformed message)
+  uint32_t          au32_Latency[ESOS_MAIL_STATS_NUM_BINS];  // postmark-to-read latency histogram
+} MAILSTATS;
+#endif    // ESOS_USE_MAIL_STATS
+
 /**
 * structure to contain a set of descriptors about the buffers used
 * to implement ESOS task mailboxes
@@ -60,8 +85,16 @@
 typedef struct __stMAILBOX {
   CBUFFER*          pst_CBuffer;                      // ptr to structure that describes mailbox circular buffer
   struct stTask*    pst_Task;                         // ptr to ESOS_TASK_HANDLE that owns mailbox
+#ifdef ESOS_USE_MAIL_STATS
+  MAILSTATS         st_Stats;                         // usage statistics
+#endif
 } MAILBOX;
 
+/**
+* handle to a block in the pool of zero-copy mail blocks
+**/
+typedef ESOS_POOL_BLOCK   ESOS_MAILBLOCK_HANDLE;
+
 /**
 * structure to contain a mail message "envelope" -- a set of descriptors
 * about a mail message and the contents within
@@ -75,13 +108,39 @@ typedef struct __stMAILMSG {
 }  MAILMSG;
 */
 
-#define __MAIL_MSG_MAX_DATA_LEN   16    // can be no BIGGER than 16 bytes
+/**
+* Largest data payload (in bytes) that a single mail message can carry.
+* Applications that need larger messages can define ESOS_MAIL_MAX_DATA_LEN
+* (as a multiple of 4, at most 65524, so a message still fits in a 16-bit
+* mailbox) before ESOS is compiled.
+*
+* RAM cost: every MAILMESSAGE the application declares grows by the same
+* amount, and the default task mailbox (MAX_SIZE_TASK_MAILBOX) holds five
+* of the largest messages, so each task registered with the default
+* mailbox takes 5*(9+ESOS_MAIL_MAX_DATA_LEN) bytes of the mailbox arena.
+*
+* The arena (ESOS_MAILBOX_ARENA_SIZE) and each mailbox must stay within
+* 65535 bytes.  With the default sizes (an arena with a default mailbox
+* for each of the MAX_NUM_USER_TASKS tasks) that allows at most 400 bytes
+* of payload.  Beyond that, also define a smaller ESOS_MAILBOX_ARENA_SIZE,
+* and beyond 13096 bytes a smaller MAX_SIZE_TASK_MAILBOX, too.
+**/
+#ifndef ESOS_MAIL_MAX_DATA_LEN
+#define ESOS_MAIL_MAX_DATA_LEN    16
+#endif
+
+#if (ESOS_MAIL_MAX_DATA_LEN < 4) || (ESOS_MAIL_MAX_DATA_LEN % 4) || (ESOS_MAIL_MAX_DATA_LEN > 65524)
+#error "ESOS_MAIL_MAX_DATA_LEN must be a multiple of 4 in 4..65524"
+#endif
+
+#define __MAIL_MSG_MAX_DATA_LEN   ESOS_MAIL_MAX_DATA_LEN
 
 typedef struct __stMAILMESSAGE {
   uint8_t                 u8_flags;     // various bits to help us decode message
   uint16_t                            u16_FromTaskID;     // an unique? 16-bit ID number identifying the sender task
-  uint8_t                 u8_DataLength;    // how many bytes in data payload
+  uint16_t                u16_DataLength;   // how many elements (of type given by flags) in data payload
   uint32_t                u32_Postmark;     // ESOS tick timestamp on message
+  uint16_t                u16_CallID;       // RPC call ID (RPC requests and replies only)
   union {
     uint8_t           au8_Contents[__MAIL_MSG_MAX_DATA_LEN];        // message contents
     uint16_t          au16_Contents[__MAIL_MSG_MAX_DATA_LEN/2];     // message contents
@@ -90,6 +149,28 @@ typedef struct __stMAILMESSAGE {
   };
 }  MAILMESSAGE;
 
+/**
+* structure to track a task's outstanding RPC call
+**/
+typedef struct __stMAILRPCCALL {
+  uint16_t                u16_CallID;       // ID of the outstanding call (0 if none)
+  MAILMESSAGE*            pst_Reply;        // where the reply goes
+  uint8_t                 u8_Sent;          // TRUE once the request is in the server's mailbox
+  uint8_t                 u8_GotReply;      // TRUE once the reply has been delivered
+} MAILRPCCALL;
+
+/**
+* structure to describe which mail messages a task wants to receive.
+* Only the fields named in u8_Fields (ESOS_MAILFILTER_xxx bits) are checked.
+**/
+typedef struct __stMAILFILTER {
+  uint8_t                 u8_Fields;        // which criteria below to apply
+  uint16_t                u16_FromTaskID;   // sender task ID must equal this
+  uint8_t                 u8_FlagsMask;     // message flags AND'ed with this mask...
+  uint8_t                 u8_FlagsValue;    // ...must equal this value
+  uint8_t                 u8_Type;          // first payload byte must equal this
+} MAILFILTER;
+
 /* D E F I N E S ************************************************************/
 // DEFINEs user can NOT change
 #define ESOS_MAILMESSAGE_STRING         0x0
@@ -97,13 +178,70 @@ typedef struct __stMAILMESSAGE {
 #define ESOS_MAILMESSAGE_UINT16         0x2
 #define ESOS_MAILMESSAGE_UINT32         0x4
 #define ESOS_MAILMESSAGE_REQUEST_ACK        0x8
+#define ESOS_MAILMESSAGE_BLOCK          0x10
+#define ESOS_MAILMESSAGE_TOPIC          0x20
+#define ESOS_MAILMESSAGE_RPC_REQUEST    0x40
+#define ESOS_MAILMESSAGE_RPC_REPLY      0x80
+
+/**
+* Sender task ID given to messages posted by interrupt service routines.
+* Real task IDs are never 0.
+**/
+#define ESOS_MAIL_FROM_ISR              0
+
+/**
+* Number and size (in bytes) of the mail blocks used for zero-copy
+* messages.  Applications may override these before ESOS is compiled.
+* Mail blocks come from an ordinary ESOS pool, so its high-water and
+* failure statistics are available through __st_MailBlockPool.  Each
+* block carries a reference count so it can be shared by the
+* subscribers of a topic (see esos_topic.h).
+* \sa esos_AllocMailBlock
+**/
+#ifndef ESOS_MAIL_NUM_BLOCKS
+#define ESOS_MAIL_NUM_BLOCKS            8
+#endif
+#ifndef ESOS_MAIL_BLOCK_SIZE
+#define ESOS_MAIL_BLOCK_SIZE            64
+#endif
+
+// bits for MAILFILTER u8_Fields
+#define ESOS_MAILFILTER_FROM            0x01
+#define ESOS_MAILFILTER_FLAGS           0x02
+#define ESOS_MAILFILTER_TYPE            0x04
+
+// returned when no mailbox message passes a filter
+#define __MAIL_MSG_NOT_FOUND            0xFFFF
+
+// handle value meaning "no mail block"
+#define ESOS_MAIL_NULL_BLOCK            ESOS_POOL_NULL_BLOCK
 
 // verify these against the MAILMESSAGE struct above
-#define __MAIL_MSG_HEADER_LEN     (1+2+1+4)
+//   header is: flags (1), data length (2), from task ID (2), postmark (4)
+#define __MAIL_MSG_HEADER_LEN     (1+2+2+4)
 #define __MAIL_MSG_MAX_LEN      (__MAIL_MSG_HEADER_LEN+__MAIL_MSG_MAX_DATA_LEN)
 
-// size of each task's mailbox (in bytes)
-#define MAX_SIZE_TASK_MAILBOX     5*__MAIL_MSG_MAX_LEN
+// default size of each task's mailbox (in bytes)
+//   tasks needing a different size can be registered with
+//   esos_RegisterTaskWithMailbox() or given their own storage
+//   with esos_SetTaskMailbox()
+#ifndef MAX_SIZE_TASK_MAILBOX
+#define MAX_SIZE_TASK_MAILBOX     (5*__MAIL_MSG_MAX_LEN)
+#endif
+
+// size of the arena (in bytes) that all task mailboxes are carved from
+//   by default, every user task slot can have a default-sized mailbox.
+//   Applications with fewer tasks (or smaller mailboxes) can shrink it
+#ifndef ESOS_MAILBOX_ARENA_SIZE
+#define ESOS_MAILBOX_ARENA_SIZE   (MAX_NUM_USER_TASKS*MAX_SIZE_TASK_MAILBOX)
+#endif
+
+#if (MAX_SIZE_TASK_MAILBOX > 65535)
+#error "MAX_SIZE_TASK_MAILBOX must be no larger than 65535:  with a large ESOS_MAIL_MAX_DATA_LEN, define a smaller MAX_SIZE_TASK_MAILBOX"
+#endif
+#if (ESOS_MAILBOX_ARENA_SIZE > 65535)
+#error "ESOS_MAILBOX_ARENA_SIZE must be no larger than 65535:  with a large ESOS_MAIL_MAX_DATA_LEN, define a smaller ESOS_MAILBOX_ARENA_SIZE or MAX_SIZE_TASK_MAILBOX"
+#endif
 
 /* M A C R O S ************************************************************/
 
@@ -147,6 +285,25 @@ typedef struct __stMAILMESSAGE {
  */
 #define ESOS_TASK_WAIT_FOR_MAIL()             ESOS_TASK_WAIT_UNTIL(ESOS_TASK_IVE_GOT_MAIL())
 
+/**
+ * Puts the current task to sleep until it is woken (see \ref ESOS_WAKE_TASK)
+ * or mail arrives.
+ *
+ * Unlike a mailbox check followed by \ref ESOS_TASK_SLEEP, this cannot
+ * miss a wake-up from \ref ESOS_ISR_SEND_MESSAGE.  The mailbox is checked
+ * again every time the task is scheduled, so mail that arrived before
+ * the task went to sleep (or a wake-up lost to a flag update in another
+ * context) still ends the sleep.
+ *
+ * \hideinitializer
+ */
+#define ESOS_TASK_SLEEP_ON_MAIL()                                                     \
+  do {                                                                                \
+    __ESOS_SET_TASK_SLEEPING_FLAG(__pstSelf);                                         \
+    ESOS_TASK_WAIT_WHILE( ESOS_IS_TASK_SLEEPING(__pstSelf) && !ESOS_TASK_IVE_GOT_MAIL() ); \
+    __ESOS_CLEAR_TASK_SLEEPING_FLAG(__pstSelf);                                       \
+  } while(0)
+
 
 /**
 * Block current task until the specified task's mailbox
@@ -159,7 +316,7 @@ typedef struct __stMAILMESSAGE {
 *
 * \hideinitializer
 */
-#define ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_AT_LEAST(pstTask, x)       ESOS_TASK_WAIT_UNTIL(ESOS_TASK_MAILBOX_GOT_AT_LEAST_DATA_BYTES((pstTask), ((x)+__MAIL_MSG_HEADER_LEN)))
+#define ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_AT_LEAST(pstTask, x)       ESOS_TASK_WAIT_UNTIL(ESOS_TASK_MAILBOX_GOT_AT_LEAST_DATA_BYTES((pstTask), (x)))
 
 /**
 * Block the current task until the specified recipient task mailbox
@@ -167,26 +324,40 @@ typedef struct __stMAILMESSAGE {
 *
 * \param pstTask  pointer to task structure (ESOS_TASK_HANDLE)
 * \param pstMsg   message for which room must be found
-* \retval TRUE   if task's mailbox has  x bytes <em>or more</em>;
-* \retval FALSE   otherwise
 *
+* \sa ESOS_TASK_MAILBOX_HAS_ROOM_MESSAGE
 * \hideinitializer
-* \todo BRAIN-DEAD implementation.  needs to properly parse the message
-*      header and computer the data payload size.  A bit harder than it
-*      first appears
 */
 #define ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_ROOM_MESSAGE(pstTask, pstMsg)       \
-             ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_AT_LEAST(pstTask, __MAIL_MSG_MAX_DATA_LEN )
+             ESOS_TASK_WAIT_UNTIL(ESOS_TASK_MAILBOX_HAS_ROOM_MESSAGE((pstTask), (pstMsg)))
+
+/**
+* Evaluates to the boolean to determine if the specified task's mailbox
+* has room for the entire message (header and data payload)
+*
+* \param pstTask  pointer to task structure (ESOS_TASK_HANDLE)
+* \param pstMsg   message for which room must be found
+* \retval TRUE   if the message will fit in the task's mailbox
+* \retval FALSE   otherwise
+*
+* \hideinitializer
+*/
+#define ESOS_TASK_MAILBOX_HAS_ROOM_MESSAGE(pstTask, pstMsg)                     \
+             __ESOS_CB_IS_AVAILABLE_AT_LEAST((pstTask)->pst_Mailbox->pst_CBuffer, __esos_GetMailMessageFrameLength((pstMsg)))
 
 
 /**
-* Evaluates to the number of bytes available in the mailbox association
-* with an arbitrary task pstTask
+* Evaluates to the number of data payload bytes available in the mailbox
+* associated with an arbitrary task pstTask, i.e. the mailbox free space
+* less the room needed for one message header (0 if there is not even
+* room for a header)
 * \param pstTask  pointer to task structure
-* \retval N   number of bytes available for writing in task's mailbox
+* \retval N   number of payload bytes available for writing in task's mailbox
 * \hideinitializer
 */
-#define ESOS_TASK_MAILBOX_GET_AVAILABLE_LEN(pstTask)        ((__ESOS_CB_GET_AVAILABLE((pstTask)->pst_Mailbox->pst_CBuffer))-__MAIL_MSG_HEADER_LEN)
+#define ESOS_TASK_MAILBOX_GET_AVAILABLE_LEN(pstTask)                            \
+            ((__ESOS_CB_GET_AVAILABLE((pstTask)->pst_Mailbox->pst_CBuffer) > __MAIL_MSG_HEADER_LEN) ? \
+             (uint16_t) (__ESOS_CB_GET_AVAILABLE((pstTask)->pst_Mailbox->pst_CBuffer)-__MAIL_MSG_HEADER_LEN) : 0)
 /**
 * Evaluates to the booelan to determine if the specified task's mailbox
 * has  <em>exactly</em> x bytes available for holding messages
@@ -198,7 +369,8 @@ typedef struct __stMAILMESSAGE {
 *
 * \hideinitializer
 */
-#define ESOS_TASK_MAILBOX_GOT_EXACTLY_DATA_BYTES(pstTask,x)     (ESOS_TASK_MAILBOX_GET_AVAILABLE_LEN((pstTask)) == ((x)+__MAIL_MSG_HEADER_LEN))
+#define ESOS_TASK_MAILBOX_GOT_EXACTLY_DATA_BYTES(pstTask,x)                    \
+            (__ESOS_CB_GET_AVAILABLE((pstTask)->pst_Mailbox->pst_CBuffer) == (uint32_t) (x)+__MAIL_MSG_HEADER_LEN)
 
 /**
 * Evaluates to the booelan to determine if the specified task's mailbox
@@ -211,11 +383,12 @@ typedef struct __stMAILMESSAGE {
 *
 * \hideinitializer
 */
-#define ESOS_TASK_MAILBOX_GOT_AT_LEAST_DATA_BYTES(pstTask, x)   (ESOS_TASK_MAILBOX_GET_AVAILABLE_LEN((pstTask)) >= ((x)+__MAIL_MSG_HEADER_LEN))
+#define ESOS_TASK_MAILBOX_GOT_AT_LEAST_DATA_BYTES(pstTask, x)                  \
+            (__ESOS_CB_GET_AVAILABLE((pstTask)->pst_Mailbox->pst_CBuffer) >= (uint32_t) (x)+__MAIL_MSG_HEADER_LEN)
 
 /**
 * Flushes the specified task's mailbox contents.  All unread data in the mailbox
-* will be lost.
+* will be lost.  Zero-copy messages give up their mail block references.
 *
 * \param pstTask  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be flushed
 * \note Use this function only if you want to reset some task's mailbox back
@@ -225,22 +398,272 @@ typedef struct __stMAILMESSAGE {
 *
 * \hideinitializer
 */
-#define ESOS_TASK_FLUSH_TASK_MAILBOX(pstTask)             __ESOS_CB_FLUSH((pstTask)->pst_Mailbox->pst_CBuffer)
+#define ESOS_TASK_FLUSH_TASK_MAILBOX(pstTask)             __esos_FlushMailbox((pstTask)->pst_Mailbox)
+
+/**
+* Evaluates to the total size (in bytes) of the specified task's mailbox
+*
+* \param pstTask  pointer to task structure (ESOS_TASK_HANDLE)
+* \retval N   size of the task's mailbox storage
+* \sa esos_SetTaskMailbox
+* \hideinitializer
+*/
+#define ESOS_TASK_MAILBOX_GET_LENGTH(pstTask)             __ESOS_CB_GET_LENGTH((pstTask)->pst_Mailbox->pst_CBuffer)
+
+#ifdef ESOS_USE_MAIL_STATS
+/**
+* Copies a consistent snapshot of the specified task's mailbox statistics,
+* including the number of bytes and messages in the mailbox right now.
+*
+* \param pstTask   pointer to task structure (ESOS_TASK_HANDLE)
+* \param pstStats  pointer to MAILSTATS structure to receive the snapshot
+* \sa esos_GetTaskMailStats
+* \hideinitializer
+*/
+#define ESOS_TASK_GET_MAIL_STATS(pstTask, pstStats)       esos_GetTaskMailStats((pstTask),(pstStats))
+
+/**
+* Zeroes the specified task's mailbox statistics
+*
+* \param pstTask   pointer to task structure (ESOS_TASK_HANDLE)
+* \hideinitializer
+*/
+#define ESOS_TASK_RESET_MAIL_STATS(pstTask)               esos_ResetTaskMailStats((pstTask))
+#endif    // ESOS_USE_MAIL_STATS
 
+/**
+* Sends a message to the specified task's mailbox.  The message is either
+* delivered in its entirety or not at all.
+*
+* \param pst_ToTask  pointer to task structure (ESOS_TASK_HANDLE) of the recipient
+* \param pst_Msg     pointer to the message to send
+* \retval TRUE       if the message was delivered
+* \retval FALSE      if the recipient's mailbox did not have room for the message
+*
+* \sa ESOS_TASK_WAIT_ON_SEND_MESSAGE
+* \hideinitializer
+*/
 #define ESOS_TASK_SEND_MESSAGE(pst_ToTask, pst_Msg)           __esos_SendMailMessage((pst_ToTask),(pst_Msg))
 
+/**
+* Sends a message to the specified task's mailbox from an interrupt
+* service routine.  Never blocks; a message that does not fit is dropped.
+* The recipient is woken if it is sleeping.  A recipient that sleeps
+* waiting for ISR mail should use \ref ESOS_TASK_SLEEP_ON_MAIL, which
+* cannot miss the wake-up.
+*
+* \param pst_ToTask  pointer to task structure (ESOS_TASK_HANDLE) of the recipient
+* \param pst_Msg     pointer to the message to send
+* \retval TRUE       if the message was delivered
+* \retval FALSE      if the recipient's mailbox did not have room for the message
+*
+* \sa esos_SendMailMessageFromISR
+* \hideinitializer
+*/
+#define ESOS_ISR_SEND_MESSAGE(pst_ToTask, pst_Msg)            esos_SendMailMessageFromISR((pst_ToTask),(pst_Msg))
+
+/**
+* Blocks the current task until the specified task's mailbox has room
+* for the message, and then sends it.
+*
+* \param pst_ToTask  pointer to task structure (ESOS_TASK_HANDLE) of the recipient
+* \param pst_Msg     pointer to the message to send
+*
+* \sa ESOS_TASK_SEND_MESSAGE
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_SEND_MESSAGE(pst_ToTask, pst_Msg)                         \
+        do{                                                                         \
+          ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_ROOM_MESSAGE((pst_ToTask),(pst_Msg)); \
+          ESOS_TASK_SEND_MESSAGE((pst_ToTask),(pst_Msg));                           \
+        } while(0)
+
+/**
+* Sends a batch of messages to the specified task's mailbox.  Messages are
+* sent in order until one does not fit.
+*
+* \param pst_ToTask  pointer to task structure (ESOS_TASK_HANDLE) of the recipient
+* \param pst_Msgs    pointer to an array of messages to send
+* \param u8_n        number of messages in the array
+* \retval N          number of messages (from the start of the array) delivered
+*
+* \hideinitializer
+*/
+#define ESOS_TASK_SEND_MESSAGES(pst_ToTask, pst_Msgs, u8_n)   __esos_SendMailMessages((pst_ToTask),(pst_Msgs),(u8_n))
+
+/**
+* Blocks the current task until the specified task's mailbox has room
+* for the entire batch of messages, and then sends them all.
+*
+* \param pst_ToTask  pointer to task structure (ESOS_TASK_HANDLE) of the recipient
+* \param pst_Msgs    pointer to an array of messages to send
+* \param u8_n        number of messages in the array
+* \note The batch must fit in the recipient's mailbox, or this will block forever.
+*
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_SEND_MESSAGES(pst_ToTask, pst_Msgs, u8_n)                   \
+        do{                                                                         \
+          ESOS_TASK_WAIT_UNTIL(__ESOS_CB_IS_AVAILABLE_AT_LEAST((pst_ToTask)->pst_Mailbox->pst_CBuffer,  \
+                                 __esos_GetMailMessagesFrameLength((pst_Msgs),(u8_n))));  \
+          ESOS_TASK_SEND_MESSAGES((pst_ToTask),(pst_Msgs),(u8_n));                  \
+        } while(0)
+
 #define ESOS_TASK_SEND_MESSAGE_WAIT_DELIVERY(pst_ToTask, pstMsg)    ESOS_TASK_WAIT_ON_DELIVERY((pst_ToTask), (pstMsg))
 
-#define ESOS_TASK_WAIT_ON_DELIVERY(pst_ToTask, pstMsg)                               \
+/**
+* Sends a message to a task (waiting for room in its mailbox) and then
+* blocks the current task until the recipient has read it.  The
+* progress of the send is kept in the current task's flags, so the
+* whole wait is a single ESOS_TASK_WAIT_UNTIL.
+*
+* \param pst_ToTask  pointer to task structure (ESOS_TASK_HANDLE) of the recipient
+* \param pstMsg      pointer to the message to send
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_DELIVERY(pst_ToTask, pstMsg)                                     \
         do{                                                                                 \
-            (pstMsg)->u8_flags |= ESOS_MAILMESSAGE_REQUEST_ACK;                             \
-      ESOS_TASK_SEND_MESSAGE((pst_ToTask),(pstMsg));                    \
-      __ESOS_SET_TASK_MAILNACK_FLAG((__pstSelf));                   \
-      ESOS_TASK_WAIT_WHILE( ESOS_TASK_IS_WAITING_MAIL_DELIVERY( __pstSelf ) );    \
-    } while(0)
+          (pstMsg)->u8_flags |= ESOS_MAILMESSAGE_REQUEST_ACK;                               \
+          __ESOS_CLEAR_TASK_MAILSENT_FLAG(__pstSelf);                                       \
+          ESOS_TASK_WAIT_UNTIL( __esos_PollMailDelivery(__pstSelf, (pst_ToTask), (pstMsg)) ); \
+        } while(0)
 
+/**
+* Reads the oldest message from the current task's mailbox.
+*
+* \param pst_Msg     pointer to the message structure to fill
+* \retval TRUE       if a message was read
+* \retval FALSE      if the mailbox was empty
+* \hideinitializer
+*/
 #define ESOS_TASK_GET_NEXT_MESSAGE(pst_Msg)                           __esos_ReadMailMessage(__pstSelf, (pst_Msg))
 
+/**
+* Copies the oldest message in the current task's mailbox without removing it.
+*
+* \param pst_Msg     pointer to the message structure to fill
+* \retval TRUE       if a message was copied
+* \retval FALSE      if the mailbox was empty
+* \hideinitializer
+*/
+#define ESOS_TASK_PEEK_NEXT_MESSAGE(pst_Msg)                          __esos_PeekMailMessage(__pstSelf, (pst_Msg))
+
+/**
+* Reads the oldest message in the current task's mailbox that passes the
+* filter.  Other messages stay in the mailbox, in order.
+*
+* \param pst_Filter  pointer to the MAILFILTER to apply
+* \param pst_Msg     pointer to the message structure to fill
+* \retval TRUE       if a matching message was read
+* \retval FALSE      if no message in the mailbox passes the filter
+* \hideinitializer
+*/
+#define ESOS_TASK_GET_MATCHING_MESSAGE(pst_Filter, pst_Msg)           __esos_ReadMatchingMailMessage(__pstSelf, (pst_Filter), (pst_Msg))
+
+/**
+* Determines if the current task has a message that passes the filter
+* \param pst_Filter  pointer to the MAILFILTER to apply
+* \hideinitializer
+*/
+#define ESOS_TASK_IVE_GOT_MATCHING_MAIL(pst_Filter)                   \
+             (__esos_FindMailMessage(__pstSelf, (pst_Filter), &__st_MailFilterScratch) != __MAIL_MSG_NOT_FOUND)
+
+/**
+* Blocks the current task until a message that passes the filter has arrived
+* \param pst_Filter  pointer to the MAILFILTER to apply
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_FOR_MATCHING_MAIL(pst_Filter)                  ESOS_TASK_WAIT_UNTIL(ESOS_TASK_IVE_GOT_MATCHING_MAIL((pst_Filter)))
+
+/**
+* Sets up a MAILFILTER that passes every message
+* \hideinitializer
+*/
+#define ESOS_MAILFILTER_CLEAR(stFilter)               (stFilter).u8_Fields = 0
+/**
+* Adds "sent by task hTask" to a MAILFILTER
+* \hideinitializer
+*/
+#define ESOS_MAILFILTER_SET_FROM(stFilter, hTask)                   \
+  do{                                                               \
+    (stFilter).u8_Fields |= ESOS_MAILFILTER_FROM;                    \
+    (stFilter).u16_FromTaskID = (hTask)->u16_taskID;                \
+  } while(0)
+/**
+* Adds "(flags & mask) == value" to a MAILFILTER
+* \hideinitializer
+*/
+#define ESOS_MAILFILTER_SET_FLAGS(stFilter, mask, value)            \
+  do{                                                               \
+    (stFilter).u8_Fields |= ESOS_MAILFILTER_FLAGS;                   \
+    (stFilter).u8_FlagsMask = (mask);                               \
+    (stFilter).u8_FlagsValue = (value);                             \
+  } while(0)
+/**
+* Adds "first payload byte == type" to a MAILFILTER
+* \hideinitializer
+*/
+#define ESOS_MAILFILTER_SET_TYPE(stFilter, type)                    \
+  do{                                                               \
+    (stFilter).u8_Fields |= ESOS_MAILFILTER_TYPE;                    \
+    (stFilter).u8_Type = (type);                                    \
+  } while(0)
+
+/**
+* Makes a remote procedure call: sends the request to the specified task
+* and blocks until the reply arrives or u32_timeout ticks pass.  The
+* request is given a fresh call ID, and only the reply to this very call
+* is accepted.  The reply is delivered straight into pst_Reply and never
+* passes through the current task's mailbox.  Use
+* \ref ESOS_TASK_RPC_GOT_REPLY afterwards to find out how the call went.
+* Only user tasks can make RPC calls.  In a child task, the call ends at
+* once without a reply.
+*
+* \param pst_ToTask  pointer to task structure (ESOS_TASK_HANDLE) of the server
+* \param pst_Req     pointer to the request message
+* \param pst_Reply   pointer to the message structure that receives the reply.
+*                    Should be a static, since the current task blocks.
+* \param u32_timeout most ticks to wait (for mailbox room and the reply)
+*
+* \sa ESOS_TASK_SEND_RPC_REPLY
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_RPC_CALL(pst_ToTask, pst_Req, pst_Reply, u32_timeout)                      \
+        do{                                                                                         \
+          __esos_BeginRpcCall(__pstSelf, (pst_Req), (pst_Reply));                                   \
+          __pstSelf->u32_savedTick = esos_GetSystemTick();                                          \
+          __pstSelf->u32_waitLen = (u32_timeout);                                                   \
+          ESOS_TASK_WAIT_UNTIL( __esos_PollRpcCall(__pstSelf, (pst_ToTask), (pst_Req)) );           \
+          __esos_EndRpcCall(__pstSelf);                                                             \
+        } while(0)
+
+/**
+* Evaluates to TRUE if the current task's last RPC call got its reply,
+* FALSE if it timed out
+* \hideinitializer
+*/
+#define ESOS_TASK_RPC_GOT_REPLY()                   (__ESOS_IS_USER_TASK_HANDLE(__pstSelf) && __astRpcCalls[__pstSelf - __astUserTaskPool].u8_GotReply)
+
+/**
+* Answers the RPC request pstReq with the reply pstReply.  Evaluates to
+* TRUE if the caller got the reply, FALSE if it had already given up.
+* \hideinitializer
+*/
+#define ESOS_TASK_SEND_RPC_REPLY(pstReq, pstReply)                    \
+             ( ESOS_SET_PMSG_FROMTASK((pstReply), __pstSelf), esos_SendRpcReply((pstReq), (pstReply)) )
+
+/**
+* Reads all messages waiting in the current task's mailbox, up to u8_max
+* of them, into an array in one pass.  Lets a task clear a backlog without
+* a trip through the scheduler for every message.
+*
+* \param pst_Msgs    pointer to an array of at least u8_max messages
+* \param u8_max      most messages to read
+* \retval N          number of messages read
+* \hideinitializer
+*/
+#define ESOS_TASK_GET_MESSAGES(pst_Msgs, u8_max)                     __esos_ReadMailMessages(__pstSelf, (pst_Msgs), (u8_max))
+
 #define ESOS_TASK_GET_LAST_MESSAGE(pst_Msg)                                 \
         do {                                                                \
             while ( ESOS_TASK_IVE_GOT_MAIL() ) {                            \
@@ -248,6 +671,26 @@ typedef struct __stMAILMESSAGE {
             }                                                               \
         }while(0)
 
+/**
+* Blocks the current task until a mail block can be allocated from the
+* mail block pool.
+*
+* \param hBlock  variable (ESOS_MAILBLOCK_HANDLE) that receives the handle to
+*                the allocated block.  Since tasks lose their local
+*                variables when they block, this should be a static.
+* \sa esos_AllocMailBlock
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_AVAILABLE_MAIL_BLOCK(hBlock)      \
+             ESOS_TASK_WAIT_UNTIL( ((hBlock)=esos_AllocMailBlock()) != ESOS_MAIL_NULL_BLOCK )
+
+/**
+* Evaluates to a pointer to the data in the mail block with handle hBlock
+* \param hBlock  handle (ESOS_MAILBLOCK_HANDLE) of an allocated mail block
+* \hideinitializer
+*/
+#define ESOS_MAIL_BLOCK_PTR(hBlock)                 ESOS_POOL_BLOCK_PTR(&__st_MailBlockPool, (hBlock))
+
 /********************
 *** QUICKIE MACROS
 ********************/
@@ -255,18 +698,22 @@ typedef struct __stMAILMESSAGE {
 
 #define ESOS_SET_MSG_FLAGS(stMsg, flags)          stMsg.u8_flags=(flags)
 #define ESOS_SET_MSG_FROMTASK(stMsg, pstFromTask)   stMsg.u16_FromTaskID=pstFromTask->u16_taskID
-#define ESOS_SET_MSG_DATA_LENGTH(stMsg, len)      stMsg.u8_DataLength=(len)
+#define ESOS_SET_MSG_DATA_LENGTH(stMsg, len)      stMsg.u16_DataLength=(len)
 #define ESOS_GET_MSG_FLAGS(stMsg)                 (stMsg.u8_flags)
 #define ESOS_GET_MSG_FROMTASK(stMsg)              (stMsg.u16_FromTaskID)
-#define ESOS_GET_MSG_DATA_LENGTH(stMsg)           (stMsg.u8_DataLength)
+#define ESOS_GET_MSG_DATA_LENGTH(stMsg)           (stMsg.u16_DataLength)
 #define ESOS_GET_MSG_POSTMARK(stMsg)              (stMsg.u32_Postmark)
+#define ESOS_IS_MSG_RPC_REQUEST(stMsg)            (stMsg.u8_flags & ESOS_MAILMESSAGE_RPC_REQUEST)
+#define ESOS_IS_MSG_BLOCK(stMsg)                  (stMsg.u8_flags & ESOS_MAILMESSAGE_BLOCK)
+#define ESOS_GET_MSG_BLOCK(stMsg)                 ((ESOS_MAILBLOCK_HANDLE) stMsg.au8_Contents[0])
+#define ESOS_GET_MSG_BLOCK_PTR(stMsg)             ESOS_MAIL_BLOCK_PTR(ESOS_GET_MSG_BLOCK(stMsg))
 
 #define ESOS_SET_PMSG_FLAGS(pstMsg, flags)            pstMsg->u8_flags=(flags)
 #define ESOS_SET_PMSG_FROMTASK(pstMsg, pstFromTask)   pstMsg->u16_FromTaskID=pstFromTask->u16_taskID
-#define ESOS_SET_PMSG_DATA_LENGTH(pstMsg, len)      pstMsg->u8_DataLength=(len)
+#define ESOS_SET_PMSG_DATA_LENGTH(pstMsg, len)      pstMsg->u16_DataLength=(len)
 #define ESOS_GET_PMSG_FLAGS(pstMsg)                 (pstMsg->u8_flags)
 #define ESOS_GET_PMSG_FROMTASK(pstMsg)              (pstMsg->u16_FromTaskID)
-#define ESOS_GET_PMSG_DATA_LENGTH(pstMsg)           (pstMsg->u8_DataLength)
+#define ESOS_GET_PMSG_DATA_LENGTH(pstMsg)           (pstMsg->u16_DataLength)
 #define ESOS_GET_PMSG_POSTMARK(pstMsg)              (pstMsg->u32_Postmark)
 
 #define ESOS_TASK_MAKE_MSG_EMPTY(stMsg)               \
@@ -362,6 +809,22 @@ typedef struct __stMAILMESSAGE {
      stMsg.au16_Contents[3] = (u16x3);                        \
   } while(0)
 
+/**
+* Makes a zero-copy message that hands the mail block hBlock to the
+* recipient.  Only the block handle is copied into the recipient's mailbox.
+* The data length of the message is the number of valid bytes in the block.
+* Once the message is sent, the recipient owns the block and must release
+* it with \ref esos_ReleaseMailBlock after consuming its contents.
+* \hideinitializer
+*/
+#define ESOS_TASK_MAKE_MSG_BLOCK(stMsg, hBlock, u16len)      \
+  do{                                                       \
+     ESOS_SET_MSG_FLAGS(stMsg, ESOS_MAILMESSAGE_BLOCK);     \
+     ESOS_SET_MSG_FROMTASK(stMsg, __pstSelf);               \
+     ESOS_SET_MSG_DATA_LENGTH(stMsg, (u16len));             \
+     stMsg.au8_Contents[0] = (hBlock);                      \
+  } while(0)
+
 #define ESOS_TASK_MAKE_MSG_UINT32(stMsg, u32x)              \
   do{                                                       \
      ESOS_SET_MSG_FLAGS(stMsg, ESOS_MAILMESSAGE_UINT32);      \
@@ -384,24 +847,45 @@ typedef struct __stMAILMESSAGE {
   do{                                                     \
     printf("MESSAGE u8_flags =            %02X\n",ESOS_GET_MSG_FLAGS(stMsg) );  \
     printf("        u16_FromTaskID =      %d\n",ESOS_GET_MSG_FROMTASK(stMsg) ); \
-    printf("        u8_DataLength =       %d\n",ESOS_GET_MSG_DATA_LENGTH(stMsg) );  \
+    printf("        u16_DataLength =      %d\n",ESOS_GET_MSG_DATA_LENGTH(stMsg) );  \
     printf("        u32_PostMark =        %d\n",ESOS_GET_MSG_POSTMARK(stMsg) ); \
     printf("          first byte  =       %d\n",stMsg.au8_Contents[0]); \
   } while(0)
 
 /* E X T E R N S ************************************************************/
 extern    MAILBOX         __astMailbox[MAX_NUM_USER_TASKS];
-extern    uint8_t         __au8_MBData[MAX_NUM_USER_TASKS][MAX_SIZE_TASK_MAILBOX];
+extern    uint8_t         __au8_MBArena[ESOS_MAILBOX_ARENA_SIZE];
 extern    uint8_t         __u8_esos_mail_routines_dummy_uint8;
+extern    POOL            __st_MailBlockPool;
+extern    MAILMESSAGE     __st_MailFilterScratch;
+extern    MAILRPCCALL     __astRpcCalls[MAX_NUM_USER_TASKS];
 
 /* P U B L I C  P R O T O T Y P E S *****************************************/
+uint8_t esos_SetTaskMailbox(struct stTask* pst_Task, uint8_t* pau8_Storage, uint16_t u16_Len);
+uint16_t esos_GetMailboxArenaSize(void);
+uint16_t esos_GetMailboxArenaUsed(void);
+uint16_t esos_GetMailboxArenaFree(void);
+uint8_t esos_SendRpcReply(MAILMESSAGE* pst_Request, MAILMESSAGE* pst_Reply );
+uint8_t esos_SendMailMessageFromISR(struct stTask* pst_RcvrTask, MAILMESSAGE* pst_Msg );
+#ifdef ESOS_USE_MAIL_STATS
+void esos_GetTaskMailStats(struct stTask* pst_Task, MAILSTATS* pst_Stats );
+void esos_ResetTaskMailStats(struct stTask* pst_Task );
+void __esos_RecordMailRead(MAILBOX* pst_Mailbox, MAILMESSAGE* pst_Message );
+#endif
+ESOS_MAILBLOCK_HANDLE esos_AllocMailBlock(void);
+uint8_t esos_RetainMailBlock(ESOS_MAILBLOCK_HANDLE h_Block);
+uint8_t esos_ReleaseMailBlock(ESOS_MAILBLOCK_HANDLE h_Block);
+uint8_t esos_GetNumFreeMailBlocks(void);
 
 /* P R I V A T E    P R O T O T Y P E S ***********************************/
 
 /**
 *
 */
-void __esos_InitMailbox(MAILBOX* pst_Mailbox, uint8_t* pau8_ptr);
+void __esos_InitMailbox(MAILBOX* pst_Mailbox, uint8_t* pau8_ptr, uint16_t u16_Len);
+void __esos_InitMailBlocks(void);
+void __esos_InitMailboxArena(void);
+uint8_t __esos_AttachTaskMailbox(MAILBOX* pst_Mailbox, uint8_t u8_Slot, uint16_t u16_Len);
 
 //void __esos_WriteMailboxUINT8(MAILBOX* pst_Mailbox, uint8_t u8_x );
 #define __esos_WriteMailboxUINT8(pstMB, u8x)          __esos_CB_WriteUINT8((pstMB)->pst_CBuffer, (u8x) )
@@ -418,8 +902,28 @@ void __esos_InitMailbox(MAILBOX* pst_Mailbox, uint8_t* pau8_ptr);
 * \hideinitializer
 */
 void __esos_SendMailUint8(struct stTask* pst_Task, MAILBOX* pst_Mailbox, uint8_t* pau8_data, uint8_t u8_len );
-void __esos_ReadMailMessage(struct stTask* pst_Task, MAILMESSAGE* pst_Message );
-void __esos_SendMailMessage(struct stTask* pst_RcvrTask, MAILMESSAGE* pst_Msg );
+uint8_t __esos_ReadMailMessage(struct stTask* pst_Task, MAILMESSAGE* pst_Message );
+uint8_t __esos_PeekMailMessage(struct stTask* pst_Task, MAILMESSAGE* pst_Message );
+uint16_t __esos_FindMailMessage(struct stTask* pst_Task, MAILFILTER* pst_Filter, MAILMESSAGE* pst_Header );
+uint8_t __esos_ReadMatchingMailMessage(struct stTask* pst_Task, MAILFILTER* pst_Filter, MAILMESSAGE* pst_Message );
+uint16_t __esos_ParseMailHeader(CBUFFER* pst_CB, uint16_t u16_Offset, MAILMESSAGE* pst_Message );
+void __esos_AckMailMessage(MAILMESSAGE* pst_Message );
+uint16_t __esos_GetMailMessageHeaderLength(MAILMESSAGE* pst_Msg );
+void __esos_DiscardMailFrame(CBUFFER* pst_CB, uint16_t u16_Offset, uint16_t u16_Len );
+void __esos_FlushMailbox(MAILBOX* pst_Mailbox );
+void __esos_InitRpcCalls(void);
+MAILRPCCALL* __esos_GetRpcCall(struct stTask* pst_Task );
+void __esos_BeginRpcCall(struct stTask* pst_Task, MAILMESSAGE* pst_Request, MAILMESSAGE* pst_Reply );
+uint8_t __esos_PollRpcCall(struct stTask* pst_Task, struct stTask* pst_ToTask, MAILMESSAGE* pst_Request );
+uint8_t __esos_EndRpcCall(struct stTask* pst_Task );
+uint8_t __esos_SendMailMessage(struct stTask* pst_RcvrTask, MAILMESSAGE* pst_Msg );
+uint8_t __esos_PollMailDelivery(struct stTask* pst_Task, struct stTask* pst_ToTask, MAILMESSAGE* pst_Msg );
+uint8_t __esos_PostMailMessage(MAILBOX* pst_Mailbox, MAILMESSAGE* pst_Msg, uint32_t u32_Postmark );
+uint8_t __esos_ReadMailMessages(struct stTask* pst_Task, MAILMESSAGE* pst_Msgs, uint8_t u8_Max );
+uint8_t __esos_SendMailMessages(struct stTask* pst_RcvrTask, MAILMESSAGE* pst_Msgs, uint8_t u8_Count );
+uint16_t __esos_GetMailMessagesFrameLength(MAILMESSAGE* pst_Msgs, uint8_t u8_Count );
+uint16_t __esos_GetMailMessagePayloadLength(MAILMESSAGE* pst_Msg );
+uint16_t __esos_GetMailMessageFrameLength(MAILMESSAGE* pst_Msg );
 
 /** @} */
 
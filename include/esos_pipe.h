@@ -0,0 +1,201 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Pipe_Service
+ * @{
+ */
+
+/** \file
+ *  This file contains macros, prototypes, and definitions for the
+ *  ESOS byte-stream pipes.
+ *
+ *  A pipe is a bounded stream of bytes from one producer to one
+ *  consumer, e.g. a sampler feeding a logger or the comm RX feeding a
+ *  parser.  Pipes are built on the lock-free \ref SPSCBUFFER ring, so the
+ *  producer or the consumer may be an ISR.  Data is moved with block
+ *  copies, never one byte per call.  Vectored writes publish all of
+ *  their pieces to the reader at once.
+ *
+ *  A pipe can wake its reader when the data in it reaches a high
+ *  watermark, and wake its writer when the data drops to a low
+ *  watermark.  The tasks to wake are given with \ref esos_SetPipeTasks.
+ *  They should sleep with \ref ESOS_TASK_SLEEP_ON_PIPE_HIGH_WATER or
+ *  \ref ESOS_TASK_SLEEP_ON_PIPE_LOW_WATER, which re-check the watermark.
+ *  A task that checks the pipe and then calls \ref ESOS_TASK_SLEEP can
+ *  go to sleep just after the wake-up and miss it.
+ *
+ *  The pipe storage length <em>MUST</em> be a power of two.
+ */
+
+#ifndef   ESOS_PIPE_H
+#define ESOS_PIPE_H
+
+/* I N C L U D E S **********************************************************/
+#include    "esos.h"
+#include    "esos_cb.h"
+
+/* S T R U C T U R E S ******************************************************/
+/**
+* structure to describe one piece of a vectored pipe read or write
+**/
+typedef struct __stIOVEC {
+  uint8_t*              pu8_Base;         // ptr to the piece's data
+  uint16_t              u16_Len;          // number of bytes in the piece
+} ESOS_IOVEC;
+
+/**
+* structure to contain a set of descriptors about a pipe
+**/
+typedef struct __stPIPE {
+  SPSCBUFFER            st_Ring;          // the bytes in the pipe
+  uint16_t              u16_LowWater;     // wake the writer when this many bytes or fewer are left
+  uint16_t              u16_HighWater;    // wake the reader when this many bytes or more are waiting
+  struct stTask*        pst_Reader;       // task to wake at the high watermark (or NULLPTR)
+  struct stTask*        pst_Writer;       // task to wake at the low watermark (or NULLPTR)
+} PIPE;
+
+/* M A C R O S ************************************************************/
+/**
+* Declares a pipe (a PIPE structure named name) along with its storage
+* of u16_len bytes.  u16_len <em>MUST</em> be a power of two.  The pipe
+* must be initialized with \ref ESOS_INIT_PIPE before use.
+* \hideinitializer
+*/
+#define ESOS_DECLARE_PIPE(name, u16_len)                                    \
+          uint8_t     __au8_##name##_Data[(u16_len)];                       \
+          PIPE        name
+
+/**
+* Initializes a pipe declared by \ref ESOS_DECLARE_PIPE.  The length must
+* match the declaration.
+* \hideinitializer
+*/
+#define ESOS_INIT_PIPE(name, u16_len)                                       \
+          esos_InitPipe(&(name), __au8_##name##_Data, (u16_len))
+
+#define ESOS_PIPE_GET_LENGTH(pstPipe)         __ESOS_SPSC_GET_LENGTH(&(pstPipe)->st_Ring)
+#define ESOS_PIPE_GET_COUNT(pstPipe)          __ESOS_SPSC_GET_COUNT(&(pstPipe)->st_Ring)
+#define ESOS_PIPE_GET_AVAILABLE(pstPipe)      __ESOS_SPSC_GET_AVAILABLE(&(pstPipe)->st_Ring)
+#define ESOS_PIPE_IS_EMPTY(pstPipe)           __ESOS_SPSC_IS_EMPTY(&(pstPipe)->st_Ring)
+#define ESOS_PIPE_IS_FULL(pstPipe)            __ESOS_SPSC_IS_FULL(&(pstPipe)->st_Ring)
+
+/**
+* Blocks the current task until pipe pstPipe holds at least x bytes
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_PIPE_DATA(pstPipe, x)                             \
+          ESOS_TASK_WAIT_UNTIL( ESOS_PIPE_GET_COUNT((pstPipe)) >= (x) )
+
+/**
+* Blocks the current task until pipe pstPipe has room for at least x bytes
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_PIPE_SPACE(pstPipe, x)                            \
+          ESOS_TASK_WAIT_UNTIL( ESOS_PIPE_GET_AVAILABLE((pstPipe)) >= (x) )
+
+/**
+* Blocks the current task until the u16_len bytes at pu8_x have all been
+* written to pipe pstPipe.  They are written (and seen by the reader) at
+* once, so u16_len must not be larger than the pipe.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_PIPE_WRITE(pstPipe, pu8_x, u16_len)               \
+          ESOS_TASK_WAIT_UNTIL( esos_PipeWriteAll((pstPipe), (pu8_x), (u16_len)) )
+
+/**
+* Blocks the current task until u16_len bytes have been read from pipe
+* pstPipe into pu8_x.  u16_len must not be larger than the pipe.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_PIPE_READ(pstPipe, pu8_x, u16_len)                \
+          ESOS_TASK_WAIT_UNTIL( esos_PipeReadAll((pstPipe), (pu8_x), (u16_len)) )
+
+/**
+* Blocks the current task until pipe pstPipe reaches its high watermark
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_PIPE_HIGH_WATER(pstPipe)                          \
+          ESOS_TASK_WAIT_UNTIL( ESOS_PIPE_GET_COUNT((pstPipe)) >= (pstPipe)->u16_HighWater )
+
+/**
+* Blocks the current task until pipe pstPipe drains to its low watermark
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_PIPE_LOW_WATER(pstPipe)                           \
+          ESOS_TASK_WAIT_UNTIL( ESOS_PIPE_GET_COUNT((pstPipe)) <= (pstPipe)->u16_LowWater )
+
+/**
+* Puts the current task to sleep until it is woken (see \ref ESOS_WAKE_TASK)
+* or pipe pstPipe fills to its high watermark.  The watermark is checked
+* again every time the task is scheduled, so a wake-up from the writer
+* cannot be missed.
+* \hideinitializer
+*/
+#define ESOS_TASK_SLEEP_ON_PIPE_HIGH_WATER(pstPipe)                         \
+  do {                                                                      \
+    __ESOS_SET_TASK_SLEEPING_FLAG(__pstSelf);                               \
+    ESOS_TASK_WAIT_WHILE( ESOS_IS_TASK_SLEEPING(__pstSelf) &&               \
+                          (ESOS_PIPE_GET_COUNT((pstPipe)) < (pstPipe)->u16_HighWater) ); \
+    __ESOS_CLEAR_TASK_SLEEPING_FLAG(__pstSelf);                             \
+  } while(0)
+
+/**
+* Puts the current task to sleep until it is woken (see \ref ESOS_WAKE_TASK)
+* or pipe pstPipe drains to its low watermark.  The watermark is checked
+* again every time the task is scheduled, so a wake-up from the reader
+* cannot be missed.
+* \hideinitializer
+*/
+#define ESOS_TASK_SLEEP_ON_PIPE_LOW_WATER(pstPipe)                          \
+  do {                                                                      \
+    __ESOS_SET_TASK_SLEEPING_FLAG(__pstSelf);                               \
+    ESOS_TASK_WAIT_WHILE( ESOS_IS_TASK_SLEEPING(__pstSelf) &&               \
+                          (ESOS_PIPE_GET_COUNT((pstPipe)) > (pstPipe)->u16_LowWater) ); \
+    __ESOS_CLEAR_TASK_SLEEPING_FLAG(__pstSelf);                             \
+  } while(0)
+
+/* P U B L I C  P R O T O T Y P E S *****************************************/
+void        esos_InitPipe(PIPE* pst_Pipe, uint8_t* pau8_Data, uint16_t u16_Len);
+void        esos_SetPipeWatermarks(PIPE* pst_Pipe, uint16_t u16_LowWater, uint16_t u16_HighWater);
+void        esos_SetPipeTasks(PIPE* pst_Pipe, struct stTask* pst_Reader, struct stTask* pst_Writer);
+uint16_t    esos_PipeWrite(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len);
+uint16_t    esos_PipeWritev(PIPE* pst_Pipe, ESOS_IOVEC* pst_Vec, uint8_t u8_NumVec);
+uint8_t     esos_PipeWriteAll(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len);
+uint16_t    esos_PipeRead(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len);
+uint16_t    esos_PipeReadv(PIPE* pst_Pipe, ESOS_IOVEC* pst_Vec, uint8_t u8_NumVec);
+uint8_t     esos_PipeReadAll(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len);
+void        esos_FlushPipe(PIPE* pst_Pipe);
+
+/* P R I V A T E    P R O T O T Y P E S ***********************************/
+void        __esos_PipeWakeReader(PIPE* pst_Pipe);
+void        __esos_PipeWakeWriter(PIPE* pst_Pipe);
+
+/** @} */
+
+#endif    // ESOS_PIPE_H
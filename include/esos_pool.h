@@ -0,0 +1,163 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Pool_Service
+ * @{
+ */
+
+/** \file
+ *  This file contains macros, prototypes, and definitions for the
+ *  ESOS fixed-block memory pools.
+ *
+ *  A pool is a set of equal-sized blocks carved out of static storage.
+ *  Free blocks are kept on a list threaded through a small array of
+ *  block indices, so allocating and releasing a block are both O(1)
+ *  and never fail in unpredictable ways.  Blocks are named by their
+ *  (8-bit) index within the pool, which is cheap to pass around in
+ *  mail messages and queues.
+ *
+ *  Several pools of different block sizes can be grouped into a
+ *  POOLSET.  Requests to a POOLSET are served from the smallest block
+ *  size class that fits and still has a free block.
+ *
+ *  Allocating and releasing blocks is done with interrupts masked,
+ *  so blocks may be passed between ISRs and tasks.
+ */
+
+#ifndef   ESOS_POOL_H
+#define ESOS_POOL_H
+
+/* I N C L U D E S **********************************************************/
+#include    "esos.h"
+
+/* D E F I N E S ************************************************************/
+// handle value meaning "no pool block"
+#define ESOS_POOL_NULL_BLOCK            0xFF
+// a pool can have no more blocks than this
+#define ESOS_POOL_MAX_BLOCKS            0xFE
+// free list link of a block that is allocated (never a valid block index)
+#define __ESOS_POOL_BLOCK_IN_USE        0xFE
+
+/* S T R U C T U R E S ******************************************************/
+/**
+* handle to a block in a pool (the index of the block within the pool)
+**/
+typedef uint8_t   ESOS_POOL_BLOCK;
+
+/**
+* structure to contain a set of descriptors about a fixed-block pool
+**/
+typedef struct __stPOOL {
+  uint8_t*              pau8_Data;        // ptr to storage for all blocks
+  uint8_t*              pau8_Next;        // ptr to free list links (one per block, __ESOS_POOL_BLOCK_IN_USE if allocated)
+  uint16_t              u16_BlockSize;    // size of each block (in bytes)
+  uint8_t               u8_NumBlocks;     // number of blocks in pool
+  volatile uint8_t      u8_Free;          // index of first free block
+  volatile uint8_t      u8_NumFree;       // number of free blocks
+  uint8_t               u8_MinFree;       // fewest free blocks ever seen
+  uint16_t              u16_NumFails;     // number of failed allocations
+} POOL;
+
+/**
+* structure to group pools of different block sizes.  The pools must be
+* listed in order of increasing block size.
+**/
+typedef struct __stPOOLSET {
+  POOL**                ppst_Pools;       // ptr to array of pool ptrs
+  uint8_t               u8_NumPools;      // number of pools in the set
+} POOLSET;
+
+/* M A C R O S ************************************************************/
+/**
+* Declares a pool (a POOL structure named name) along with the storage
+* for its u8_num blocks of u16_size bytes each.  The pool must be
+* initialized with \ref ESOS_INIT_POOL before use.
+* \hideinitializer
+*/
+#define ESOS_DECLARE_POOL(name, u16_size, u8_num)                           \
+          uint8_t     __au8_##name##_Data[(uint32_t)(u16_size)*(u8_num)];   \
+          uint8_t     __au8_##name##_Next[(u8_num)];                        \
+          POOL        name
+
+/**
+* Initializes a pool declared by \ref ESOS_DECLARE_POOL.  The size and
+* number of blocks must match the declaration.
+* \hideinitializer
+*/
+#define ESOS_INIT_POOL(name, u16_size, u8_num)                              \
+          esos_InitPool(&(name), __au8_##name##_Data, __au8_##name##_Next, (u16_size), (u8_num))
+
+/**
+* Evaluates to a pointer to the data of the block with handle h in pool pstPool
+* \hideinitializer
+*/
+#define ESOS_POOL_BLOCK_PTR(pstPool, h)       (&((pstPool)->pau8_Data[(uint32_t)(h)*(pstPool)->u16_BlockSize]))
+#define ESOS_POOL_GET_BLOCK_SIZE(pstPool)     ((pstPool)->u16_BlockSize)
+#define ESOS_POOL_GET_NUM_BLOCKS(pstPool)     ((pstPool)->u8_NumBlocks)
+#define ESOS_POOL_GET_NUM_FREE(pstPool)       ((pstPool)->u8_NumFree)
+#define ESOS_POOL_IS_EMPTY(pstPool)           ((pstPool)->u8_NumFree == 0)
+/**
+* Evaluates to the largest number of blocks ever allocated at once from pool pstPool
+* \hideinitializer
+*/
+#define ESOS_POOL_GET_HIGH_WATER(pstPool)     ((pstPool)->u8_NumBlocks - (pstPool)->u8_MinFree)
+/**
+* Evaluates to the number of allocations from pool pstPool that failed
+* because the pool was empty
+* \hideinitializer
+*/
+#define ESOS_POOL_GET_NUM_FAILS(pstPool)      ((pstPool)->u16_NumFails)
+
+/**
+* Blocks the current task until a block can be allocated from pool pstPool
+*
+* \param pstPool  pointer to the pool
+* \param h        variable (ESOS_POOL_BLOCK) that receives the block handle.
+*                 Since tasks lose their local variables when they block,
+*                 this should be a static.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_POOL_BLOCK(pstPool, h)                            \
+          ESOS_TASK_WAIT_UNTIL( ((h)=esos_AllocPoolBlock((pstPool))) != ESOS_POOL_NULL_BLOCK )
+
+/* P U B L I C  P R O T O T Y P E S *****************************************/
+void              esos_InitPool(POOL* pst_Pool, uint8_t* pau8_Data, uint8_t* pau8_Next, uint16_t u16_BlockSize, uint8_t u8_NumBlocks);
+ESOS_POOL_BLOCK   esos_AllocPoolBlock(POOL* pst_Pool);
+uint8_t           esos_ReleasePoolBlock(POOL* pst_Pool, ESOS_POOL_BLOCK h_Block);
+ESOS_POOL_BLOCK   esos_GetPoolBlockFromPtr(POOL* pst_Pool, uint8_t* pu8_Block);
+void              esos_ResetPoolStats(POOL* pst_Pool);
+uint8_t*          esos_AllocPoolSetBlock(POOLSET* pst_Set, uint16_t u16_Size);
+uint8_t           esos_ReleasePoolSetBlock(POOLSET* pst_Set, uint8_t* pu8_Block);
+
+/* P R I V A T E    P R O T O T Y P E S ***********************************/
+ESOS_POOL_BLOCK   __esos_TakePoolBlock(POOL* pst_Pool);
+
+/** @} */
+
+#endif    // ESOS_POOL_H
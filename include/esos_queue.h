@@ -0,0 +1,175 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Queue_Service
+ * @{
+ */
+
+/** \file
+ *  This file contains macros, prototypes, and definitions for the
+ *  ESOS typed message queues.
+ *
+ *  A queue holds up to a fixed number of fixed-size elements (usually
+ *  a struct) in static storage.  Elements are copied as whole blocks of
+ *  memory, with no headers, type flags or per-byte encoding, so queues
+ *  are the fast path for producer/consumer pipelines.  Mail remains the
+ *  channel for small, self-describing messages between arbitrary tasks.
+ *
+ *  Besides copying elements in and out, a producer can reserve the next
+ *  free slot, fill it in place and commit it, and a consumer can peek
+ *  at the oldest element in place and release it when done.
+ *
+ *  \ref esos_QueueSend and \ref esos_QueueReceive copy the element with
+ *  interrupts masked, so any number of tasks and ISRs may send to and
+ *  receive from the same queue.  The in-place calls leave the slot
+ *  unlocked while it is filled or read, so a queue used with them must
+ *  have exactly one producer context (if esos_QueueReserve is used) or
+ *  one consumer context (if esos_QueuePeek is used):  a single task, or
+ *  a single ISR, and no one else sends (or receives) on that queue.
+ */
+
+#ifndef   ESOS_QUEUE_H
+#define ESOS_QUEUE_H
+
+/* I N C L U D E S **********************************************************/
+#include    "esos.h"
+
+/* S T R U C T U R E S ******************************************************/
+/**
+* structure to contain a set of descriptors about a typed queue
+**/
+typedef struct __stQUEUE {
+  uint8_t*              pau8_Data;        // ptr to storage for all elements
+  uint16_t              u16_ElemSize;     // size of each element (in bytes)
+  uint16_t              u16_Capacity;     // number of element slots
+  uint16_t              u16_Head;         // slot the next element goes into
+  uint16_t              u16_Tail;         // slot of the oldest element
+  volatile uint16_t     u16_Count;        // number of elements in queue
+} QUEUE;
+
+/* M A C R O S ************************************************************/
+/**
+* Declares a queue (a QUEUE structure named name) along with the storage
+* for u16_num elements of type type.  The queue must be initialized with
+* \ref ESOS_INIT_QUEUE before use.
+* \hideinitializer
+*/
+#define ESOS_DECLARE_QUEUE(name, type, u16_num)                             \
+          type        __a_##name##_Data[(u16_num)];                         \
+          QUEUE       name
+
+/**
+* Initializes a queue declared by \ref ESOS_DECLARE_QUEUE.  The type and
+* number of elements must match the declaration.
+* \hideinitializer
+*/
+#define ESOS_INIT_QUEUE(name, type, u16_num)                                \
+          esos_InitQueue(&(name), (uint8_t*) __a_##name##_Data, sizeof(type), (u16_num))
+
+#define ESOS_QUEUE_GET_ELEM_SIZE(pstQ)        ((pstQ)->u16_ElemSize)
+#define ESOS_QUEUE_GET_CAPACITY(pstQ)         ((pstQ)->u16_Capacity)
+#define ESOS_QUEUE_GET_COUNT(pstQ)            ((pstQ)->u16_Count)
+#define ESOS_QUEUE_GET_AVAILABLE(pstQ)        ((pstQ)->u16_Capacity - (pstQ)->u16_Count)
+#define ESOS_QUEUE_IS_EMPTY(pstQ)             ((pstQ)->u16_Count == 0)
+#define ESOS_QUEUE_IS_FULL(pstQ)              ((pstQ)->u16_Count == (pstQ)->u16_Capacity)
+
+/**
+* Blocks the current task until queue pstQ has room for an element
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_QUEUE_SPACE(pstQ)   ESOS_TASK_WAIT_WHILE( ESOS_QUEUE_IS_FULL((pstQ)) )
+
+/**
+* Blocks the current task until queue pstQ holds an element
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_QUEUE_DATA(pstQ)    ESOS_TASK_WAIT_WHILE( ESOS_QUEUE_IS_EMPTY((pstQ)) )
+
+/**
+* Blocks the current task until the element at pv has been copied into
+* queue pstQ
+*
+* \param pstQ   pointer to the queue
+* \param pv     pointer to the element to send.  Since tasks lose their
+*               local variables when they block, this should point to a static.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_QUEUE_SEND(pstQ, pv)                              \
+          ESOS_TASK_WAIT_UNTIL( esos_QueueSend((pstQ), (pv)) )
+
+/**
+* Blocks the current task until an element has been copied out of queue
+* pstQ into the storage at pv
+*
+* \param pstQ   pointer to the queue
+* \param pv     pointer to storage for the element.  Should point to a static.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_QUEUE_RECEIVE(pstQ, pv)                           \
+          ESOS_TASK_WAIT_UNTIL( esos_QueueReceive((pstQ), (pv)) )
+
+/**
+* Blocks the current task until a free slot of queue pstQ can be reserved.
+* Fill the slot in place, then hand it to the consumer with
+* \ref esos_QueueCommit.
+*
+* \param pstQ   pointer to the queue
+* \param p      pointer variable that receives the address of the slot.
+*               Should be a static.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_QUEUE_RESERVE(pstQ, p)                            \
+          ESOS_TASK_WAIT_UNTIL( ((p)=esos_QueueReserve((pstQ))) != NULLPTR )
+
+/**
+* Blocks the current task until queue pstQ holds an element, and points
+* p at the oldest element in place.  Give the slot back with
+* \ref esos_QueueRelease when done with it.
+*
+* \param pstQ   pointer to the queue
+* \param p      pointer variable that receives the address of the element.
+*               Should be a static.
+* \hideinitializer
+*/
+#define ESOS_TASK_WAIT_ON_QUEUE_PEEK(pstQ, p)                               \
+          ESOS_TASK_WAIT_UNTIL( ((p)=esos_QueuePeek((pstQ))) != NULLPTR )
+
+/* P U B L I C  P R O T O T Y P E S *****************************************/
+void        esos_InitQueue(QUEUE* pst_Queue, uint8_t* pau8_Data, uint16_t u16_ElemSize, uint16_t u16_Capacity);
+void        esos_FlushQueue(QUEUE* pst_Queue);
+void*       esos_QueueReserve(QUEUE* pst_Queue);
+void        esos_QueueCommit(QUEUE* pst_Queue);
+void*       esos_QueuePeek(QUEUE* pst_Queue);
+void        esos_QueueRelease(QUEUE* pst_Queue);
+uint8_t     esos_QueueSend(QUEUE* pst_Queue, const void* pv_Elem);
+uint8_t     esos_QueueReceive(QUEUE* pst_Queue, void* pv_Elem);
+
+/** @} */
+
+#endif    // ESOS_QUEUE_H
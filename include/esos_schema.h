@@ -0,0 +1,148 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Mail_Schema
+ * @{
+ */
+
+/** \file
+ *  This file contains macros that generate typed mail messages from a
+ *  schema.
+ *
+ *  A schema is an X-macro that lists the fields of a message, in order,
+ *  as F(type, name) entries.  Producers and consumers share the one
+ *  definition:
+ *
+ *  \code
+ *  #define SENSOR_FIELDS(F)        \
+ *    F(uint16_t, u16_Temp)         \
+ *    F(uint16_t, u16_Humidity)     \
+ *    F(uint32_t, u32_Time)
+ *  ESOS_MSG_SCHEMA(SENSOR, 0x53, SENSOR_FIELDS)
+ *  \endcode
+ *
+ *  ESOS_MSG_SCHEMA generates:
+ *    - a struct type SENSOR with one member per field
+ *    - SENSOR_ID (the schema's ID) and SENSOR_WIRE_SIZE (the packed
+ *      size of the fields, in bytes)
+ *    - esos_PackSENSOR() and esos_UnpackSENSOR(), which copy the fields
+ *      into and out of a MAILMESSAGE one after the other.  They are
+ *      straight-line code, with no branching on field types.
+ *    - a compile-time check that the message fits in a MAILMESSAGE
+ *
+ *  On the wire, a schema message is an ESOS_MAILMESSAGE_UINT8 message.
+ *  Its first byte is the schema ID, so the message can be picked out
+ *  with ESOS_MAILFILTER_SET_TYPE.  The fields follow with no padding,
+ *  in native (little-endian) byte order.  Fields must be scalar types.
+ *
+ *  Each schema must be expanded once in every file that uses it,
+ *  usually by putting it in a header shared by producers and consumers.
+ */
+
+#ifndef   ESOS_SCHEMA_H
+#define ESOS_SCHEMA_H
+
+/* I N C L U D E S **********************************************************/
+#include    <string.h>
+#include    "esos.h"
+#include    "esos_mail.h"
+
+/* M A C R O S ************************************************************/
+// per-field expansions used by ESOS_MSG_SCHEMA
+#define __ESOS_SCHEMA_MEMBER(type, name)      type name;
+#define __ESOS_SCHEMA_SIZE(type, name)        + sizeof(type)
+#define __ESOS_SCHEMA_PACK(type, name)                                      \
+          memcpy(pu8_Wire, &pst_X->name, sizeof(type)); pu8_Wire += sizeof(type);
+#define __ESOS_SCHEMA_UNPACK(type, name)                                    \
+          memcpy(&pst_X->name, pu8_Wire, sizeof(type)); pu8_Wire += sizeof(type);
+
+/**
+* Generates the struct type, constants, size check, and pack/unpack
+* functions for a message schema.
+*
+* \param name     name of the schema (and of the generated struct type)
+* \param u8_id    schema ID, sent as the first byte of the message
+* \param FIELDS   X-macro that lists the fields as F(type, name) entries
+* \hideinitializer
+*/
+#define ESOS_MSG_SCHEMA(name, u8_id, FIELDS)                                \
+  typedef struct __st##name { FIELDS(__ESOS_SCHEMA_MEMBER) } name;         \
+  enum { name##_ID = (u8_id), name##_WIRE_SIZE = 0 FIELDS(__ESOS_SCHEMA_SIZE) }; \
+  typedef char __esos_schema_##name##_fits_in_message                      \
+                 [(1+name##_WIRE_SIZE <= __MAIL_MSG_MAX_DATA_LEN) ? 1 : -1]; \
+  static inline void esos_Pack##name(MAILMESSAGE* pst_Msg, const name* pst_X) { \
+    uint8_t*    pu8_Wire = &pst_Msg->au8_Contents[1];                      \
+    pst_Msg->u8_flags = ESOS_MAILMESSAGE_UINT8;                             \
+    pst_Msg->u16_DataLength = 1+name##_WIRE_SIZE;                           \
+    pst_Msg->au8_Contents[0] = name##_ID;                                   \
+    FIELDS(__ESOS_SCHEMA_PACK)                                              \
+    (void) pu8_Wire;                                                        \
+  }                                                                         \
+  static inline uint8_t esos_IsMsg##name(const MAILMESSAGE* pst_Msg) {      \
+    return ((pst_Msg->u8_flags & (ESOS_MAILMESSAGE_UINT8|ESOS_MAILMESSAGE_UINT16|  \
+                 ESOS_MAILMESSAGE_UINT32|ESOS_MAILMESSAGE_BLOCK)) == ESOS_MAILMESSAGE_UINT8) && \
+           (pst_Msg->u16_DataLength == 1+name##_WIRE_SIZE) &&               \
+           (pst_Msg->au8_Contents[0] == name##_ID);                         \
+  }                                                                         \
+  static inline uint8_t esos_Unpack##name(const MAILMESSAGE* pst_Msg, name* pst_X) { \
+    const uint8_t*  pu8_Wire = &pst_Msg->au8_Contents[1];                  \
+    if (!esos_IsMsg##name(pst_Msg)) return FALSE;                           \
+    FIELDS(__ESOS_SCHEMA_UNPACK)                                            \
+    (void) pu8_Wire;                                                        \
+    return TRUE;                                                            \
+  }
+
+/**
+* Makes stMsg a message of schema name from the current task, with the
+* fields taken from the struct at pst_X
+* \hideinitializer
+*/
+#define ESOS_TASK_MAKE_MSG_SCHEMA(stMsg, name, pst_X)                       \
+  do{                                                                       \
+     esos_Pack##name(&(stMsg), (pst_X));                                    \
+     ESOS_SET_MSG_FROMTASK(stMsg, __pstSelf);                               \
+  } while(0)
+
+/**
+* Evaluates to TRUE if stMsg is a message of schema name
+* \hideinitializer
+*/
+#define ESOS_IS_MSG_SCHEMA(stMsg, name)               esos_IsMsg##name(&(stMsg))
+
+/**
+* Copies the fields of stMsg (a message of schema name) into the struct
+* at pst_X.  Evaluates to FALSE, and leaves pst_X alone, if stMsg is not
+* a message of schema name.
+* \hideinitializer
+*/
+#define ESOS_GET_MSG_SCHEMA(stMsg, name, pst_X)       esos_Unpack##name(&(stMsg), (pst_X))
+
+/** @} */
+
+#endif    // ESOS_SCHEMA_H
@@ -87,6 +87,8 @@ typedef   struct stTask*                   ESOS_TASK_HANDLE;
 
 /* Task flag : task is waiting on ACK from other task reading mail */
 #define __TASK_MAILNACK_MASK     ESOS_BIT5
+/* Task flag : task's delivery-confirmed message has been sent (ACK pending or received) */
+#define __TASK_MAILSENT_MASK     ESOS_BIT6
 /* Task flag : task has mail needing to be read */
 #define __TASK_HASMAIL_MASK      ESOS_BIT4
 
@@ -119,6 +121,9 @@ typedef   struct stTask*                   ESOS_TASK_HANDLE;
 #define   __ESOS_CLEAR_TASK_HASMAIL_FLAG(TaskHandle)   BIT_CLEAR_MASK((TaskHandle)->flags, __TASK_HASMAIL_MASK)
 #define   __ESOS_SET_TASK_MAILNACK_FLAG(TaskHandle)    BIT_SET_MASK((TaskHandle)->flags, __TASK_MAILNACK_MASK)
 #define   __ESOS_CLEAR_TASK_MAILNACK_FLAG(TaskHandle)  BIT_CLEAR_MASK((TaskHandle)->flags, __TASK_MAILNACK_MASK)
+#define   __ESOS_SET_TASK_MAILSENT_FLAG(TaskHandle)    BIT_SET_MASK((TaskHandle)->flags, __TASK_MAILSENT_MASK)
+#define   __ESOS_CLEAR_TASK_MAILSENT_FLAG(TaskHandle)  BIT_CLEAR_MASK((TaskHandle)->flags, __TASK_MAILSENT_MASK)
+#define   __ESOS_IS_TASK_MAILSENT(TaskHandle)          IS_BIT_SET_MASK((TaskHandle)->flags, __TASK_MAILSENT_MASK)
 
 
 /**
@@ -530,7 +535,7 @@ do {                                                    \
  *
  * \hideinitializer
  */
-#define ESOS_WAKE_TASK(TaskHandle)        __ESOS_TASK_CLEAR_SLEEPING_FLAG((TaskHandle))
+#define ESOS_WAKE_TASK(TaskHandle)        __ESOS_CLEAR_TASK_SLEEPING_FLAG((TaskHandle))
 
 /**
  * Kill an scheduled ESOS task.
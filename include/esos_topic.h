@@ -0,0 +1,105 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/**
+ * \addtogroup ESOS_Task_Mail_Service
+ * @{
+ */
+
+/** \file
+ *  This file contains macros, prototypes, and definitions for
+ *  publish/subscribe topics built on ESOS task mail.
+ *
+ *  Tasks subscribe to topics by topic number.  A publisher fills a
+ *  zero-copy mail block once and publishes it to a topic.  Every
+ *  subscriber gets a mail message that refers to the same block, and
+ *  the block is reference counted so that it returns to the mail block
+ *  pool only after the last subscriber releases it.  The cost of a
+ *  publish is one small message per subscriber, regardless of the
+ *  payload size.
+ *
+ *  Subscribers share the block, so they must treat its contents as
+ *  read-only.
+ */
+
+#ifndef   ESOS_TOPIC_H
+#define ESOS_TOPIC_H
+
+/* I N C L U D E S **********************************************************/
+#include    "esos.h"
+#include    "esos_mail.h"
+
+/* D E F I N E S ************************************************************/
+/**
+* Number of topics available.  Topics are numbered 0 to ESOS_NUM_TOPICS-1.
+* Applications may override this before ESOS is compiled.
+**/
+#ifndef ESOS_NUM_TOPICS
+#define ESOS_NUM_TOPICS                 8
+#endif
+
+/* M A C R O S ************************************************************/
+/**
+* Subscribes the current task to topic u8_topic
+* \hideinitializer
+*/
+#define ESOS_TASK_SUBSCRIBE_TOPIC(u8_topic)             esos_SubscribeTopic(__pstSelf, (u8_topic))
+
+/**
+* Unsubscribes the current task from topic u8_topic
+* \hideinitializer
+*/
+#define ESOS_TASK_UNSUBSCRIBE_TOPIC(u8_topic)           esos_UnsubscribeTopic(__pstSelf, (u8_topic))
+
+/**
+* Publishes u16_len bytes in the mail block hBlock to every subscriber
+* of topic u8_topic.  The current task gives up its reference to the block.
+* Evaluates to the number of subscribers that received the block.
+* \hideinitializer
+*/
+#define ESOS_TASK_PUBLISH_TOPIC(u8_topic, hBlock, u16_len)  esos_PublishTopic(__pstSelf, (u8_topic), (hBlock), (u16_len))
+
+#define ESOS_IS_MSG_TOPIC(stMsg)                  (stMsg.u8_flags & ESOS_MAILMESSAGE_TOPIC)
+#define ESOS_GET_MSG_TOPIC(stMsg)                 (stMsg.au8_Contents[1])
+
+/* E X T E R N S ************************************************************/
+extern    uint32_t        __au32_TopicSubscribers[ESOS_NUM_TOPICS];
+
+/* P U B L I C  P R O T O T Y P E S *****************************************/
+uint8_t   esos_SubscribeTopic(struct stTask* pst_Task, uint8_t u8_Topic);
+uint8_t   esos_UnsubscribeTopic(struct stTask* pst_Task, uint8_t u8_Topic);
+uint8_t   esos_IsSubscribedTopic(struct stTask* pst_Task, uint8_t u8_Topic);
+uint8_t   esos_PublishTopic(struct stTask* pst_From, uint8_t u8_Topic, ESOS_MAILBLOCK_HANDLE h_Block, uint16_t u16_Len);
+
+/* P R I V A T E    P R O T O T Y P E S ***********************************/
+void      __esos_InitTopics(void);
+void      __esos_UnsubscribeAllTopics(struct stTask* pst_Task);
+
+/** @} */
+
+#endif    // ESOS_TOPIC_H
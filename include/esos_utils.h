@@ -48,8 +48,30 @@
 
 
 /* D E F I N E S ************************************************************/
+// starting value of a CRC-16/CCITT (see esos_buffer_crc16)
+#define ESOS_CRC16_INIT           0xFFFF
 
 /* M A C R O S ************************************************************/
+/**
+* Masks interrupts around a short critical section shared by tasks and
+* ISRs.  The previous interrupt state is saved in u32_state (a local
+* uint32_t) and restored by __ESOS_EXIT_CRITICAL, so critical sections
+* may nest and may also be used from within ISRs.
+* \note Hosted (PC) builds have no interrupts.  There, these macros only
+* keep the compiler from moving memory accesses across them.
+* \hideinitializer
+*/
+#if defined(__arm__)
+#define __ESOS_ENTER_CRITICAL(u32_state)                                     \
+          __asm__ volatile ("mrs %0, primask\n\tcpsid i" : "=r" (u32_state) :: "memory")
+#define __ESOS_EXIT_CRITICAL(u32_state)                                      \
+          __asm__ volatile ("msr primask, %0" :: "r" (u32_state) : "memory")
+#else
+#define __ESOS_ENTER_CRITICAL(u32_state)                                     \
+          do { (u32_state) = 0; __asm__ volatile ("" ::: "memory"); } while(0)
+#define __ESOS_EXIT_CRITICAL(u32_state)                                      \
+          do { (void) (u32_state); __asm__ volatile ("" ::: "memory"); } while(0)
+#endif
 
 
 /* E X T E R N S ************************************************************/
@@ -63,6 +85,7 @@ uint16_t 	esos_hash_u32_to_u16(uint32_t u32_hash);
 uint32_t 	esos_string_hash_u32(char *psz_str);
 uint32_t 	esos_buffer_hash_u32(void *buf, uint16_t len);
 // ESOS-provided CRC functions go here
+uint16_t    esos_buffer_crc16(uint16_t u16_crc, void *buf, uint16_t len);
 
 /* P R I V A T E    P R O T O T Y P E S ***********************************/
 void 		__esos_set_PRNG_U32Seed(uint32_t u32_seed);
@@ -37,6 +37,9 @@
 
 /* E X T E R N S ************************************************************/
 extern struct termios stored_settings;
+#ifdef ESOS_USE_DMA_TX
+extern uint32_t       __u32_PcDmaTxTransfers;
+#endif
 
 /* M A C R O S **************************************************************/
 
@@ -45,6 +48,10 @@ void    __esos_hw_signal_start_tx(void);
 void    __esos_hw_signal_stop_tx(void);
 uint8_t   kbhit(void);
 void set_keypress(void);
+#ifdef ESOS_USE_DMA_RX
+// replays a byte stream through the mock circular RX DMA
+void    __esos_PcDmaRxFeed(uint8_t* pu8_Data, uint16_t u16_Len);
+#endif
 
 // Documentation for this file. If the \file tag isn't present,
 // this file won't be documented.
@@ -43,14 +43,17 @@
 
 
 /* E X T E R N S ************************************************************/
-extern CBUFFER*   __pst_CB_Rx;
-extern CBUFFER*     __pst_CB_Tx;
+extern SPSCBUFFER*   __pst_CB_Rx;
+extern SPSCBUFFER*   __pst_CB_Tx;
 
 /* M A C R O S **************************************************************/
 
 /* P U B L I C  P R O T O T Y P E S *****************************************/
 void    __esos_hw_signal_start_tx(void);
 void    __esos_hw_signal_stop_tx(void);
+#ifdef ESOS_USE_DMA_RX
+void    __esos_hw_uart_rx_idle(void);
+#endif
 
 // Documentation for this file. If the \file tag isn't present,
 // this file won't be documented.
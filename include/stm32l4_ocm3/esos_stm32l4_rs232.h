@@ -43,8 +43,8 @@
 
 
 /* E X T E R N S ************************************************************/
-extern CBUFFER*   __pst_CB_Rx;
-extern CBUFFER*     __pst_CB_Tx;
+extern SPSCBUFFER*   __pst_CB_Rx;
+extern SPSCBUFFER*   __pst_CB_Tx;
 
 /* M A C R O S **************************************************************/
 
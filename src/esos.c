@@ -103,8 +103,8 @@ static struct stTask        __stUsbCommSystem;
 #endif
 
 // ESOS task mail services
+//   (mailbox storage is carved from the mailbox arena in esos_mail.c)
 MAILBOX     __astMailbox[MAX_NUM_USER_TASKS];
-uint8_t       __au8_MBData[MAX_NUM_USER_TASKS][MAX_SIZE_TASK_MAILBOX];
 CBUFFER     __astCircularBuffers[MAX_NUM_USER_TASKS];
 
 
@@ -114,16 +114,35 @@ uint32_t      __esos_u32UserFlags, __esos_u32SystemFlags;
 /****************************************************************
 ** Embedded Systems Operating System (ESOS) code
 ****************************************************************/
+/**
+ * Adds a task to the scheduler with a default sized mailbox
+ * (MAX_SIZE_TASK_MAILBOX bytes).
+ * \param taskname name of task (argument to \ref ESOS_USER_TASK declaration
+ * \retval NULLPTR   if no more tasks can execute at this time (scheduler is full
+ *                   or the mailbox arena is exhausted)
+ * \retval TaskHandle the handle of the just registered and scheduled task
+ *  \sa esos_RegisterTaskWithMailbox
+*/
+ESOS_TASK_HANDLE    esos_RegisterTask( uint8_t (*taskname)(ESOS_TASK_HANDLE pstTask) ) {
+  return esos_RegisterTaskWithMailbox( taskname, MAX_SIZE_TASK_MAILBOX );
+}// end esos_RegisterTask()
+
 /**
  * Adds a task to the scheduler.  Task will start executing at the
- * next opportunity. (almost immediately)
+ * next opportunity. (almost immediately)  The task's mailbox is carved
+ * from the shared mailbox arena, so tasks that receive a lot of mail can
+ * be given large mailboxes and tasks that receive none can be given none.
  * \param taskname name of task (argument to \ref ESOS_USER_TASK declaration
- * \retval NULLPTR   if no more tasks can execute at this time (scheduler is full)
+ * \param u16_MailboxLen  size (in bytes) of the task's mailbox.  Zero means
+ *                        the task will never receive mail.
+ * \retval NULLPTR   if no more tasks can execute at this time (scheduler is full
+ *                   or the mailbox arena is exhausted)
  * \retval TaskHandle the handle of the just registered and scheduled task
  *  \sa ESOS_USER_TASK
  *  \sa esos_UnregisterTask
+ *  \sa esos_GetMailboxArenaFree
 */
-ESOS_TASK_HANDLE    esos_RegisterTask( uint8_t (*taskname)(ESOS_TASK_HANDLE pstTask) ) {
+ESOS_TASK_HANDLE    esos_RegisterTaskWithMailbox( uint8_t (*taskname)(ESOS_TASK_HANDLE pstTask), uint16_t u16_MailboxLen ) {
   uint8_t     u8_i;
   uint8_t     u8_FoundFcn = FALSE;
   uint8_t     u8_IndexFcn;
@@ -164,9 +183,13 @@ ESOS_TASK_HANDLE    esos_RegisterTask( uint8_t (*taskname)(ESOS_TASK_HANDLE pstT
          2) add the task to the task rotation
     */
     if (u8_FoundFcn) {
+      // (re)attach and reset the task mailbox
+      if (!__esos_AttachTaskMailbox(__astUserTaskPool[u8_IndexFcn].pst_Mailbox, u8_IndexFcn, u16_MailboxLen))
+        return NULLPTR;
       __ESOS_INIT_TASK( &__astUserTaskPool[u8_IndexFcn]);                 // reset the task state
       __astUserTaskPool[u8_IndexFcn].flags = 0;                           // reset the task flags
-      ESOS_TASK_FLUSH_TASK_MAILBOX(&__astUserTaskPool[u8_IndexFcn]);      // reset the task mailbox
+      __esos_UnsubscribeAllTopics(&__astUserTaskPool[u8_IndexFcn]);       // reset the task subscriptions
+      __esos_EndRpcCall(&__astUserTaskPool[u8_IndexFcn]);                 // drop any RPC call left over
       __au8UserTaskStructIndex[__u8UserTasksRegistered] = u8_IndexFcn;
       __u8UserTasksRegistered++;
       // make sure this task has a non-zero task identifier
@@ -184,10 +207,14 @@ ESOS_TASK_HANDLE    esos_RegisterTask( uint8_t (*taskname)(ESOS_TASK_HANDLE pstT
        If we found a free task slot in the pool, then give this free slot to the new task.
     */
     if (u8_FoundFree) {
+      // give the task its mailbox before committing the slot to it
+      if (!__esos_AttachTaskMailbox(__astUserTaskPool[u8_IndexFree].pst_Mailbox, u8_IndexFree, u16_MailboxLen))
+        return NULLPTR;
       __astUserTaskPool[u8_IndexFree].pfn = taskname;                   // attach task to the free slot
       __ESOS_INIT_TASK(&__astUserTaskPool[u8_IndexFree]);               // reset the task state
       __astUserTaskPool[u8_IndexFree].flags = 0;                        // reset the task flags
-      ESOS_TASK_FLUSH_TASK_MAILBOX(&__astUserTaskPool[u8_IndexFree]);   // reset the task mailbox
+      __esos_UnsubscribeAllTopics(&__astUserTaskPool[u8_IndexFree]);    // reset the task subscriptions
+      __esos_EndRpcCall(&__astUserTaskPool[u8_IndexFree]);              // drop any RPC call left over
       __au8UserTaskStructIndex[__u8UserTasksRegistered] = u8_IndexFree;
       __u8UserTasksRegistered++;
       // Since this is a "new" task, give it a new task ID number
@@ -515,8 +542,16 @@ void __esosInit(void) {
     // assign each possible user task a mailbox and initialize it
     __astUserTaskPool[u8_i].pst_Mailbox = &__astMailbox[u8_i];
     (__astUserTaskPool[u8_i].pst_Mailbox)->pst_CBuffer = &__astCircularBuffers[u8_i];
-    __esos_InitMailbox(__astUserTaskPool[u8_i].pst_Mailbox, &__au8_MBData[u8_i][0]);
+    __esos_InitMailbox(__astUserTaskPool[u8_i].pst_Mailbox, NULLPTR, 0);
   }
+  // mailbox storage is given out as tasks are registered
+  __esos_InitMailboxArena();
+  // put all zero-copy mail blocks in the free pool
+  __esos_InitMailBlocks();
+  // no task subscribes to any topic
+  __esos_InitTopics();
+  // no task has an RPC call outstanding
+  __esos_InitRpcCalls();
   __esos_u32TmrActiveFlags = 0;
   for (u8_i=0; u8_i<MAX_NUM_TMRS; u8_i++) {
     __astTmrSvcs[u8_i].pfn = NULLPTR;
@@ -552,11 +587,10 @@ void __esosInit(void) {
 #endif
   /*
    * Now, initialize one of the communication systems if
-   * the user has requested it in user_config.h
-   *
-   * TODO: At some point, I want to be able to run both comm
-   * systems independently so we can use USB and debug via
-   * RS232 or vice-versa.  I'll worry about that later.
+   * the user has requested it in user_config.h.  It becomes
+   * the console channel (ESOS_COMM_CONSOLE).  More comm
+   * channels, each with its own hardware backend, can be
+   * set up in user_init() with ESOS_INIT_COMM_CHANNEL.
    */
 #ifdef  ESOS_USE_BULK_CDC_USB
   __esos_InitCommSystem();
@@ -564,6 +598,10 @@ void __esosInit(void) {
 #ifdef ESOS_USE_SERIAL_PORT
   __esos_InitCommSystem();
 #endif
+#ifdef ESOS_USE_LOG
+  // the log drains to a comm channel, so it starts after the comm system
+  __esos_InitLog();
+#endif
 
 #ifdef ESOS_USE_LCD
   // Initialize LCD services
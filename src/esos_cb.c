@@ -31,6 +31,7 @@
  */
 
 
+#include    <string.h>
 #include    "esos.h"
 #include    "esos_cb.h"
 
@@ -136,6 +137,34 @@ void __esos_CB_WriteUINT8Buffer(CBUFFER* pst_CBuffer, uint8_t* pu8_x, uint16_t u
   }
 } // end __esos_CB_WriteUINT8Buffer()
 
+/**
+* Writes an entire frame of bytes to a circular buffer, or nothing at all.
+*
+* Space for the whole frame is checked up front.  The frame is then
+* copied in (at most) two contiguous spans, and the element count is
+* updated once.  A reader will never see a partially written frame.
+*
+* \param pst_CBuffer  pointer to structure (CBUFFER) describing the circular buffer
+* \param pu8_x        pointer to the frame data
+* \param u16_size     number of bytes in the frame
+* \retval TRUE        if the entire frame was written
+* \retval FALSE       if the circular buffer does not have room for the frame.
+*                     The circular buffer is left untouched.
+*/
+uint8_t __esos_CB_WriteUINT8Frame(CBUFFER* pst_CBuffer, uint8_t* pu8_x, uint16_t u16_size ) {
+  uint16_t    u16_end, u16_span;
+
+  if (u16_size > __ESOS_CB_GET_AVAILABLE(pst_CBuffer))
+    return FALSE;
+  u16_end = (pst_CBuffer->u16_Start + pst_CBuffer->u16_Count) % pst_CBuffer->u16_Length;
+  u16_span = pst_CBuffer->u16_Length - u16_end;
+  if (u16_span > u16_size) u16_span = u16_size;
+  memcpy( &pst_CBuffer->pau8_Data[u16_end], pu8_x, u16_span );
+  memcpy( &pst_CBuffer->pau8_Data[0], &pu8_x[u16_span], u16_size-u16_span );
+  pst_CBuffer->u16_Count += u16_size;
+  return TRUE;
+} // end __esos_CB_WriteUINT8Frame()
+
 /***************************************************************
 **** READERs
 ***************************************************************/
@@ -180,3 +209,297 @@ void __esos_CB_ReadUINT8Buffer(CBUFFER* pst_CBuffer, uint8_t* pu8_x, uint16_t u1
     __READ_CB_UINT8(pst_CBuffer, pu8_x[u16_i]);
   }
 } // end __esos_CB_ReadUINT8Buffer()
+
+/**
+* Copies data out of a circular buffer <em>without</em> consuming it.
+*
+* \param pst_CBuffer  pointer to structure (CBUFFER) describing the circular buffer
+* \param u16_offset   number of bytes past the oldest element to start copying
+* \param pu8_x        pointer to storage that receives the data
+* \param u16_size     number of bytes to copy
+* \note This function <em>ASSUMES</em> that the circular buffer contains
+* at least u16_offset+u16_size bytes.
+*/
+void __esos_CB_PeekUINT8Buffer(CBUFFER* pst_CBuffer, uint16_t u16_offset, uint8_t* pu8_x, uint16_t u16_size ) {
+  uint16_t    u16_begin, u16_span;
+
+  u16_begin = (pst_CBuffer->u16_Start + u16_offset) % pst_CBuffer->u16_Length;
+  u16_span = pst_CBuffer->u16_Length - u16_begin;
+  if (u16_span > u16_size) u16_span = u16_size;
+  memcpy( pu8_x, &pst_CBuffer->pau8_Data[u16_begin], u16_span );
+  memcpy( &pu8_x[u16_span], &pst_CBuffer->pau8_Data[0], u16_size-u16_span );
+} // end __esos_CB_PeekUINT8Buffer()
+
+/**
+* Removes a span of bytes from the middle of a circular buffer.  The
+* (older) bytes in front of the span are moved up to close the gap, so
+* the order of the remaining data is kept.
+*
+* \param pst_CBuffer  pointer to structure (CBUFFER) describing the circular buffer
+* \param u16_offset   number of bytes (from the oldest) in front of the span
+* \param u16_size     number of bytes to remove
+* \note Caller must make sure the span is within the buffer contents.
+*/
+void __esos_CB_RemoveUINT8Span(CBUFFER* pst_CBuffer, uint16_t u16_offset, uint16_t u16_size ) {
+  uint16_t    u16_i;
+
+  // move the bytes in front of the span, newest first
+  u16_i = u16_offset;
+  while (u16_i--) {
+    pst_CBuffer->pau8_Data[(pst_CBuffer->u16_Start + u16_i + u16_size) % pst_CBuffer->u16_Length] =
+      pst_CBuffer->pau8_Data[(pst_CBuffer->u16_Start + u16_i) % pst_CBuffer->u16_Length];
+  }
+  __ESOS_CB_DISCARD( pst_CBuffer, u16_size );
+} // end __esos_CB_RemoveUINT8Span()
+
+/***************************************************************
+**** SINGLE-PRODUCER/SINGLE-CONSUMER (SPSC) RINGS
+****
+**** The producer only ever writes u16_Head and the consumer only
+**** ever writes u16_Tail.  Data is stored before the head is
+**** published, and read before the tail is released, with a
+**** memory barrier between the two.  So an ISR and a task may
+**** share a ring without disabling interrupts.
+***************************************************************/
+
+/**
+* Initializes (or resets) a SPSC ring
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param pau8_ptr     pointer to the storage for the ring
+* \param u16_Len      number of bytes in the storage.  <em>MUST</em> be a power of two.
+*/
+void __esos_SPSC_Init(SPSCBUFFER* pst_Ring, uint8_t* pau8_ptr, uint16_t u16_Len) {
+  pst_Ring->u16_Head = 0;
+  pst_Ring->u16_Tail = 0;
+  pst_Ring->u16_Length = u16_Len;
+  pst_Ring->pau8_Data = pau8_ptr;
+} // endof __esos_SPSC_Init()
+
+/**
+* Discards all unread data in a SPSC ring.
+*
+* \note Must be called from the <em>consumer</em> side of the ring.
+*/
+void __esos_SPSC_Flush(SPSCBUFFER* pst_Ring) {
+  pst_Ring->u16_Tail = pst_Ring->u16_Head;
+} // endof __esos_SPSC_Flush()
+
+/**
+* Writes a byte into a SPSC ring
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param u8_x         data to write to the ring
+* \retval TRUE        if the byte was written
+* \retval FALSE       if the ring was full and the byte was dropped
+* \note Must be called from the <em>producer</em> side of the ring.
+*/
+uint8_t __esos_SPSC_WriteUINT8(SPSCBUFFER* pst_Ring, uint8_t u8_x) {
+  uint16_t    u16_head;
+
+  u16_head = pst_Ring->u16_Head;
+  if ((uint16_t)(u16_head - pst_Ring->u16_Tail) == pst_Ring->u16_Length)
+    return FALSE;
+  pst_Ring->pau8_Data[__ESOS_SPSC_INDEX(pst_Ring, u16_head)] = u8_x;
+  __ESOS_CB_MEMORY_BARRIER();
+  pst_Ring->u16_Head = u16_head + 1;
+  return TRUE;
+} // end __esos_SPSC_WriteUINT8()
+
+/**
+* Copies bytes into the free space of a SPSC ring <em>without</em>
+* publishing them.  Several spans can be stored and then published all
+* at once with \ref __ESOS_SPSC_COMMIT.
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param u16_offset   number of bytes past the head to start storing
+* \param pu8_x        pointer to the data to store
+* \param u16_size     number of bytes to store
+* \note This function <em>ASSUMES</em> that the ring has room for
+* u16_offset+u16_size bytes.
+* \note Must be called from the <em>producer</em> side of the ring.
+*/
+void __esos_SPSC_PutUINT8Span(SPSCBUFFER* pst_Ring, uint16_t u16_offset, uint8_t* pu8_x, uint16_t u16_size) {
+  uint16_t    u16_begin, u16_span;
+
+  // copy in (at most) two contiguous spans
+  u16_begin = __ESOS_SPSC_INDEX(pst_Ring, pst_Ring->u16_Head+u16_offset);
+  u16_span = pst_Ring->u16_Length - u16_begin;
+  if (u16_span > u16_size) u16_span = u16_size;
+  memcpy( &pst_Ring->pau8_Data[u16_begin], pu8_x, u16_span );
+  memcpy( &pst_Ring->pau8_Data[0], &pu8_x[u16_span], u16_size-u16_span );
+} // end __esos_SPSC_PutUINT8Span()
+
+/**
+* Writes as many bytes of a buffer as will fit into a SPSC ring.  The
+* new data is published to the consumer all at once.
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param pu8_x        pointer to the data to write
+* \param u16_size     number of bytes to write
+* \retval N           number of bytes actually written
+* \note Must be called from the <em>producer</em> side of the ring.
+*/
+uint16_t __esos_SPSC_WriteUINT8Buffer(SPSCBUFFER* pst_Ring, uint8_t* pu8_x, uint16_t u16_size) {
+  if (u16_size > __ESOS_SPSC_GET_AVAILABLE(pst_Ring)) u16_size = __ESOS_SPSC_GET_AVAILABLE(pst_Ring);
+  __esos_SPSC_PutUINT8Span(pst_Ring, 0, pu8_x, u16_size);
+  __ESOS_SPSC_COMMIT(pst_Ring, u16_size);
+  return u16_size;
+} // end __esos_SPSC_WriteUINT8Buffer()
+
+/**
+* Reads the oldest byte from a SPSC ring
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \note This function <em>ASSUMES</em> that the ring is not empty.
+* \note Must be called from the <em>consumer</em> side of the ring.
+*/
+uint8_t __esos_SPSC_ReadUINT8(SPSCBUFFER* pst_Ring) {
+  uint16_t    u16_tail;
+  uint8_t     u8_retval;
+
+  u16_tail = pst_Ring->u16_Tail;
+  __ESOS_CB_MEMORY_BARRIER();
+  u8_retval = pst_Ring->pau8_Data[__ESOS_SPSC_INDEX(pst_Ring, u16_tail)];
+  __ESOS_CB_MEMORY_BARRIER();
+  pst_Ring->u16_Tail = u16_tail + 1;
+  return u8_retval;
+} // end __esos_SPSC_ReadUINT8()
+
+/**
+* Copies bytes out of a SPSC ring <em>without</em> consuming them.  The
+* space can be given back to the producer later with \ref __ESOS_SPSC_RELEASE.
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param u16_offset   number of bytes past the oldest to start copying
+* \param pu8_x        pointer to the storage that receives the data
+* \param u16_size     number of bytes to copy
+* \note This function <em>ASSUMES</em> that the ring holds at least
+* u16_offset+u16_size bytes.
+* \note Must be called from the <em>consumer</em> side of the ring.
+*/
+void __esos_SPSC_GetUINT8Span(SPSCBUFFER* pst_Ring, uint16_t u16_offset, uint8_t* pu8_x, uint16_t u16_size) {
+  uint16_t    u16_begin, u16_span;
+
+  __ESOS_CB_MEMORY_BARRIER();
+  // copy out (at most) two contiguous spans
+  u16_begin = __ESOS_SPSC_INDEX(pst_Ring, pst_Ring->u16_Tail+u16_offset);
+  u16_span = pst_Ring->u16_Length - u16_begin;
+  if (u16_span > u16_size) u16_span = u16_size;
+  memcpy( pu8_x, &pst_Ring->pau8_Data[u16_begin], u16_span );
+  memcpy( &pu8_x[u16_span], &pst_Ring->pau8_Data[0], u16_size-u16_span );
+} // end __esos_SPSC_GetUINT8Span()
+
+/**
+* Reads up to u16_size bytes from a SPSC ring.  The space is
+* released to the producer all at once.
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param pu8_x        pointer to the storage that receives the data
+* \param u16_size     maximum number of bytes to read
+* \retval N           number of bytes actually read
+* \note Must be called from the <em>consumer</em> side of the ring.
+*/
+uint16_t __esos_SPSC_ReadUINT8Buffer(SPSCBUFFER* pst_Ring, uint8_t* pu8_x, uint16_t u16_size) {
+  if (u16_size > __ESOS_SPSC_GET_COUNT(pst_Ring)) u16_size = __ESOS_SPSC_GET_COUNT(pst_Ring);
+  __esos_SPSC_GetUINT8Span(pst_Ring, 0, pu8_x, u16_size);
+  __ESOS_SPSC_RELEASE(pst_Ring, u16_size);
+  return u16_size;
+} // end __esos_SPSC_ReadUINT8Buffer()
+
+/**
+* Moves up to u16_size bytes from one SPSC ring to another, with block
+* copies straight out of the source ring's storage.  The data is
+* published to the consumer of pst_To (and the space released to the
+* producer of pst_From) one contiguous span at a time.
+*
+* \param pst_To       ring that receives the data
+* \param pst_From     ring the data is taken from
+* \param u16_size     maximum number of bytes to move
+* \retval N           number of bytes actually moved
+* \note Must be called from the <em>producer</em> side of pst_To and the
+* <em>consumer</em> side of pst_From.
+*/
+uint16_t __esos_SPSC_MoveUINT8Buffer(SPSCBUFFER* pst_To, SPSCBUFFER* pst_From, uint16_t u16_size) {
+  uint16_t    u16_begin, u16_span, u16_moved;
+
+  if (u16_size > __ESOS_SPSC_GET_COUNT(pst_From)) u16_size = __ESOS_SPSC_GET_COUNT(pst_From);
+  u16_moved = 0;
+  while (u16_moved < u16_size) {
+    u16_begin = __ESOS_SPSC_INDEX(pst_From, pst_From->u16_Tail);
+    u16_span = pst_From->u16_Length - u16_begin;
+    if (u16_span > u16_size-u16_moved) u16_span = u16_size-u16_moved;
+    u16_span = __esos_SPSC_WriteUINT8Buffer(pst_To, &pst_From->pau8_Data[u16_begin], u16_span);
+    if (u16_span == 0) break;
+    __ESOS_SPSC_RELEASE(pst_From, u16_span);
+    u16_moved += u16_span;
+  } // end while
+  return u16_moved;
+} // end __esos_SPSC_MoveUINT8Buffer()
+
+/**
+* Looks for the first byte in a SPSC ring that is one of a set of bytes
+* (e.g. line or record delimiters), <em>without</em> consuming anything.
+* The ring is searched in place, one contiguous span at a time.
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param u16_offset   number of bytes past the oldest to start looking.
+*                     (Bytes already searched need not be searched again.)
+* \param pau8_Set     the bytes to look for
+* \param u8_SetLen    number of bytes in pau8_Set
+* \retval N           offset (from the oldest byte) of the first match
+* \retval __ESOS_SPSC_NOT_FOUND   if none of the bytes is in the ring
+* \note Must be called from the <em>consumer</em> side of the ring.
+*/
+uint16_t __esos_SPSC_ScanUINT8(SPSCBUFFER* pst_Ring, uint16_t u16_offset, const uint8_t* pau8_Set, uint8_t u8_SetLen) {
+  uint16_t    u16_count, u16_begin, u16_span, u16_i;
+  uint8_t*    pu8_span;
+  uint8_t*    pu8_hit;
+  uint8_t     u8_j;
+
+  u16_count = __ESOS_SPSC_GET_COUNT(pst_Ring);
+  __ESOS_CB_MEMORY_BARRIER();
+  while (u16_offset < u16_count) {
+    u16_begin = __ESOS_SPSC_INDEX(pst_Ring, pst_Ring->u16_Tail+u16_offset);
+    u16_span = pst_Ring->u16_Length - u16_begin;
+    if (u16_span > u16_count-u16_offset) u16_span = u16_count-u16_offset;
+    pu8_span = &pst_Ring->pau8_Data[u16_begin];
+    if (u8_SetLen == 1) {
+      pu8_hit = memchr(pu8_span, pau8_Set[0], u16_span);
+      if (pu8_hit) return u16_offset + (pu8_hit-pu8_span);
+    } else {
+      for (u16_i=0; u16_i<u16_span; u16_i++) {
+        for (u8_j=0; u8_j<u8_SetLen; u8_j++) {
+          if (pu8_span[u16_i] == pau8_Set[u8_j]) return u16_offset + u16_i;
+        }
+      } // end for
+    }
+    u16_offset += u16_span;
+  } // end while
+  return __ESOS_SPSC_NOT_FOUND;
+} // end __esos_SPSC_ScanUINT8()
+
+/**
+* Describes the u16_size oldest bytes of a SPSC ring as a view, so they
+* can be parsed where they lie.  Nothing is consumed:  give the space
+* back with \ref __ESOS_SPSC_RELEASE when done with the view.
+*
+* \param pst_Ring     pointer to structure (SPSCBUFFER) describing the ring
+* \param u16_size     number of bytes in the view
+* \param pst_View     the view to fill in
+* \note This function <em>ASSUMES</em> that the ring holds at least
+* u16_size bytes.
+* \note Must be called from the <em>consumer</em> side of the ring.
+*/
+void __esos_SPSC_GetView(SPSCBUFFER* pst_Ring, uint16_t u16_size, SPSCVIEW* pst_View) {
+  uint16_t    u16_begin;
+
+  __ESOS_CB_MEMORY_BARRIER();
+  u16_begin = __ESOS_SPSC_INDEX(pst_Ring, pst_Ring->u16_Tail);
+  pst_View->pu8_Span1 = &pst_Ring->pau8_Data[u16_begin];
+  pst_View->u16_Len1 = pst_Ring->u16_Length - u16_begin;
+  if (pst_View->u16_Len1 > u16_size) pst_View->u16_Len1 = u16_size;
+  pst_View->pu8_Span2 = &pst_Ring->pau8_Data[0];
+  pst_View->u16_Len2 = u16_size - pst_View->u16_Len1;
+  pst_View->u16_Len = u16_size;
+} // end __esos_SPSC_GetView()
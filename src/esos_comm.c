@@ -34,29 +34,361 @@
 #include    "esos.h"
 #include  	"esos_cb.h"
 #include    "esos_comm.h"
+#include    "esos_format.h"
+#include    <string.h>
 
 // ******** G L O B A L S ***************
 volatile uint8_t                __esos_comm_tx_buff[ESOS_SERIAL_IN_EP_SIZE];
 volatile uint8_t                __esos_comm_rx_buff[ESOS_SERIAL_OUT_EP_SIZE];
-CBUFFER                   __st_CB_Tx, __st_CB_Rx;
-CBUFFER*                    __pst_CB_Tx;
-CBUFFER*              __pst_CB_Rx;
-volatile struct    stTask   __stChildTaskTx, __stChildTaskRx;
+ESOS_COMM_CHANNEL         __st_CommConsole;
+SPSCBUFFER*                 __pst_CB_Tx;
+SPSCBUFFER*           __pst_CB_Rx;
+#ifdef ESOS_USE_DMA_TX
+// number of TX ring bytes the DMA engine is sending right now
+volatile uint16_t           __u16_DmaTxLen;
+#endif
+#ifdef ESOS_USE_DMA_RX
+// RX ring index the DMA had reached at the last update, the number
+// of bytes the DMA is ahead of the ring head, and the number of
+// unread bytes the DMA has overwritten
+volatile uint16_t           __u16_DmaRxPos;
+volatile uint16_t           __u16_DmaRxLag;
+volatile uint16_t           __u16_DmaRxOverruns;
+#endif
+#ifdef ESOS_USE_COMM_OUTQ
+// shared queue of complete output records bound for the console
+SPSCBUFFER                  __st_CommOutQ;
+uint8_t                     __au8_CommOutQ[ESOS_COMM_OUTQ_SIZE];
+#endif
 
 /****************************************************************
 ** F U N C T I O N S
 ****************************************************************/
-void __esos_InitCommSystem(void) {
-  // setup the circular buffers & their descriptors
-  __pst_CB_Rx = &__st_CB_Rx;
-  __pst_CB_Tx = &__st_CB_Tx;
-  __esos_CB_Init( __pst_CB_Tx, __esos_comm_tx_buff, ESOS_SERIAL_IN_EP_SIZE);
-  __esos_CB_Init( __pst_CB_Rx, __esos_comm_rx_buff, ESOS_SERIAL_OUT_EP_SIZE);
+// the console channel's backend is the hardware comm system
+static void __esos_CommConsoleStartTx(ESOS_COMM_HANDLE h_Chan) {
+  (void) h_Chan;
+  __esos_hw_signal_start_tx();
+} // endof __esos_CommConsoleStartTx()
+
+void esos_InitCommChannel(ESOS_COMM_HANDLE h_Chan, uint8_t* pau8_Tx, uint16_t u16_TxLen,
+                          uint8_t* pau8_Rx, uint16_t u16_RxLen, void (*pfn_StartTx)(ESOS_COMM_HANDLE h_Chan)) {
+  // The comm buffers are shared between tasks and the backend's
+  //   ISRs, so they use the lock-free SPSC rings.
+  __esos_SPSC_Init( &h_Chan->st_Tx, pau8_Tx, u16_TxLen );
+  __esos_SPSC_Init( &h_Chan->st_Rx, pau8_Rx, u16_RxLen );
+  h_Chan->u8_Flags = 0;
+  h_Chan->u16_InScanEnd = 0;
+  h_Chan->u8_InScanSetLen = 0;
+  h_Chan->u16_OutNeed = 0;
+  h_Chan->pfn_StartTx = pfn_StartTx;
+} // endof esos_InitCommChannel()
+
+/**
+* Tells the backend of channel h_Chan that there is new data to send
+*/
+void __esos_CommStartTx(ESOS_COMM_HANDLE h_Chan) {
+  if (h_Chan->pfn_StartTx) h_Chan->pfn_StartTx( h_Chan );
+} // endof __esos_CommStartTx()
 
+void __esos_InitCommSystem(void) {
+  // setup the console channel.  The hardware layer works directly on
+  //   its rings (through __pst_CB_Tx and __pst_CB_Rx)
+  esos_InitCommChannel( ESOS_COMM_CONSOLE, (uint8_t*) __esos_comm_tx_buff, ESOS_SERIAL_IN_EP_SIZE,
+                        (uint8_t*) __esos_comm_rx_buff, ESOS_SERIAL_OUT_EP_SIZE, __esos_CommConsoleStartTx );
+  __pst_CB_Tx = &ESOS_COMM_CONSOLE->st_Tx;
+  __pst_CB_Rx = &ESOS_COMM_CONSOLE->st_Rx;
+
+#ifdef ESOS_USE_DMA_TX
+  __u16_DmaTxLen = 0;
+#endif
   __esos_hw_InitCommSystem();
+#ifdef ESOS_USE_DMA_RX
+  __u16_DmaRxPos = 0;
+  __u16_DmaRxLag = 0;
+  __u16_DmaRxOverruns = 0;
+  __esos_hw_dma_rx_start( __pst_CB_Rx->pau8_Data, __ESOS_SPSC_GET_LENGTH( __pst_CB_Rx ) );
+#endif
+#ifdef ESOS_USE_COMM_OUTQ
+  __esos_SPSC_Init( &__st_CommOutQ, __au8_CommOutQ, ESOS_COMM_OUTQ_SIZE );
+  // the drain task receives no mail, so give it no mailbox
+  esos_RegisterTaskWithMailbox( __esos_CommOutQDrain, 0 );
+#endif
 
 } // endof esos_Init_CommSystem()
 
+#ifdef ESOS_USE_DMA_TX
+/****************************************************************
+** DMA TX ENGINE
+**
+** The DMA engine is the consumer of the TX ring.  It sends the
+** longest contiguous span of waiting data in one DMA transfer.
+** The span stays in the ring (so producers cannot overwrite it)
+** until the hardware reports that the transfer is complete.  Then
+** the space is released and the next span, if any, is started.
+** Data wrapped around the end of the ring takes two transfers.
+****************************************************************/
+/**
+* Starts a DMA transfer of the next contiguous span of the TX ring,
+* or marks TX as idle if the ring is empty.  Must be called with
+* interrupts masked (or from the DMA ISR).
+*/
+void __esos_DmaTxNext(void) {
+  uint16_t      u16_Begin, u16_Span;
+
+  u16_Span = __ESOS_SPSC_GET_COUNT( __pst_CB_Tx );
+  if (u16_Span == 0) {
+    __u16_DmaTxLen = 0;
+    __esos_ClearSystemFlag(__ESOS_SYS_COMM_TX_ONGOING);
+    return;
+  }
+  u16_Begin = __ESOS_SPSC_INDEX( __pst_CB_Tx, __pst_CB_Tx->u16_Tail );
+  if (u16_Span > __ESOS_SPSC_GET_LENGTH( __pst_CB_Tx ) - u16_Begin)
+    u16_Span = __ESOS_SPSC_GET_LENGTH( __pst_CB_Tx ) - u16_Begin;
+  __esos_SetSystemFlag(__ESOS_SYS_COMM_TX_ONGOING);
+  __u16_DmaTxLen = u16_Span;
+  __ESOS_CB_MEMORY_BARRIER();
+  __esos_hw_dma_tx_start( &__pst_CB_Tx->pau8_Data[u16_Begin], u16_Span );
+} // endof __esos_DmaTxNext()
+
+/**
+* Starts the DMA engine if it is idle.  Called (through
+* __esos_hw_signal_start_tx) after data is written into the TX ring.
+*/
+void __esos_DmaTxKick(void) {
+  uint32_t      u32_state;
+
+  __ESOS_ENTER_CRITICAL(u32_state);
+  if (__esos_IsSystemFlagClear(__ESOS_SYS_COMM_TX_ONGOING))
+    __esos_DmaTxNext();
+  __ESOS_EXIT_CRITICAL(u32_state);
+} // endof __esos_DmaTxKick()
+
+/**
+* Called by the hardware layer (from its DMA ISR) when the transfer
+* started by __esos_hw_dma_tx_start() has finished.  Gives the sent
+* bytes back to the TX ring producers and starts the next transfer.
+*/
+void __esos_DmaTxComplete(void) {
+  __ESOS_SPSC_RELEASE( __pst_CB_Tx, __u16_DmaTxLen );
+  __esos_DmaTxNext();
+} // endof __esos_DmaTxComplete()
+#endif    // ESOS_USE_DMA_TX
+
+#ifdef ESOS_USE_DMA_RX
+/****************************************************************
+** DMA RX ENGINE
+**
+** The DMA controller writes received bytes straight into the RX
+** ring, wrapping round it forever (circular mode).  It does not
+** move the ring head itself.  Instead, the hardware layer calls
+** __esos_DmaRxUpdate() on the DMA half-transfer and
+** transfer-complete events, and when the UART line goes idle.
+** Each update publishes everything received since the last one in
+** a single commit.  So tasks waiting on the RX ring run once per
+** burst, not once per byte.
+**
+** Circular DMA cannot be held off.  If the tasks fall a whole ring
+** behind, the DMA overwrites the oldest unread bytes.  The update
+** counts the lost bytes in __u16_DmaRxOverruns.  It runs in an ISR
+** (the ring's producer), so it never moves the tail.  Instead it
+** fills the ring, so that waiting tasks run, and remembers how far
+** the DMA is ahead of the head.  Once the tasks have made enough
+** room, the head skips forward to the DMA position and only the
+** newest bytes are published.
+****************************************************************/
+/**
+* Publishes the bytes the DMA has written into the RX ring since the
+* last update.  Called by the hardware layer from its DMA and UART
+* idle-line ISRs.
+*
+* \param u16_Remaining   the DMA transfer count register:  the number
+*                        of bytes left before the DMA wraps back to the
+*                        start of the ring
+* \note The half-transfer event guarantees at most half a ring
+* arrives between updates, so a full ring never looks like no data.
+*/
+void __esos_DmaRxUpdate(uint16_t u16_Remaining) {
+  uint16_t      u16_Pos, u16_New, u16_Room, u16_Catchup;
+
+  u16_Pos = __ESOS_SPSC_INDEX( __pst_CB_Rx, __ESOS_SPSC_GET_LENGTH( __pst_CB_Rx ) - u16_Remaining );
+  u16_New = __ESOS_SPSC_INDEX( __pst_CB_Rx, u16_Pos - __u16_DmaRxPos );
+  if (u16_New == 0) return;
+  __u16_DmaRxPos = u16_Pos;
+
+  u16_Room = __ESOS_SPSC_GET_AVAILABLE( __pst_CB_Rx );
+  if (u16_New > u16_Room)
+    __u16_DmaRxOverruns += u16_New - u16_Room;
+  // publishing u16_Catchup bytes puts the head back at the DMA position.
+  //   Whole rings the DMA is ahead by are already overwritten
+  __u16_DmaRxLag = __ESOS_SPSC_INDEX( __pst_CB_Rx, __u16_DmaRxLag + u16_New );
+  u16_Catchup = __u16_DmaRxLag;
+  if (u16_Catchup <= u16_Room) {
+    __ESOS_SPSC_COMMIT( __pst_CB_Rx, u16_Catchup );
+    __u16_DmaRxLag = 0;
+  } else {
+    // not enough room yet:  fill the ring and catch up later
+    __ESOS_SPSC_COMMIT( __pst_CB_Rx, u16_Room );
+    __u16_DmaRxLag -= u16_Room;
+  }
+} // endof __esos_DmaRxUpdate()
+#endif    // ESOS_USE_DMA_RX
+
+#ifdef ESOS_USE_COMM_OUTQ
+/****************************************************************
+** OUTPUT RECORD QUEUE
+**
+** Tasks append complete records (a 2-byte length, then the bytes)
+** to __st_CommOutQ without taking the console's "out" stream.  A
+** record is appended all at once, or not at all, inside a single
+** function call.  Since tasks never preempt one another, records
+** from different tasks never mix, and any number of tasks may be
+** producers.  The drain task is the only consumer.  It takes the
+** "out" stream once for a whole batch of records and moves them
+** into the console TX ring.
+****************************************************************/
+/**
+* Appends a record to the console's output queue.
+*
+* \param pu8_Data    pointer to the bytes of the record
+* \param u16_Len     number of bytes in the record
+* \retval TRUE       if the whole record was queued
+* \retval FALSE      if the queue does not have room for it right now
+* \retval ESOS_COMM_OUTQ_TOO_LONG  if the record is longer than
+*                    ESOS_COMM_OUTQ_MAX_RECORD_LEN, so it can never be queued
+* \note The bytes are copied before this returns, so pu8_Data need not
+* be static.  Must not be called from an ISR.
+* \sa ESOS_TASK_WAIT_ON_QUEUED_SEND_U8BUFFER
+*/
+uint8_t esos_CommQueueOutput(uint8_t* pu8_Data, uint16_t u16_Len) {
+  uint8_t       au8_Hdr[__ESOS_COMM_OUTQ_REC_HDR_LEN];
+
+  if (u16_Len == 0) return TRUE;
+  if (u16_Len > ESOS_COMM_OUTQ_MAX_RECORD_LEN) return ESOS_COMM_OUTQ_TOO_LONG;
+  if (!__ESOS_SPSC_IS_AVAILABLE_AT_LEAST( &__st_CommOutQ, (uint32_t) u16_Len+__ESOS_COMM_OUTQ_REC_HDR_LEN ))
+    return FALSE;
+  au8_Hdr[0] = u16_Len & 0xFF;
+  au8_Hdr[1] = u16_Len >> 8;
+  __esos_SPSC_PutUINT8Span( &__st_CommOutQ, 0, au8_Hdr, __ESOS_COMM_OUTQ_REC_HDR_LEN );
+  __esos_SPSC_PutUINT8Span( &__st_CommOutQ, __ESOS_COMM_OUTQ_REC_HDR_LEN, pu8_Data, u16_Len );
+  __ESOS_SPSC_COMMIT( &__st_CommOutQ, u16_Len+__ESOS_COMM_OUTQ_REC_HDR_LEN );
+  return TRUE;
+} // endof esos_CommQueueOutput()
+
+/**
+* Appends a zero-terminated string to the console's output queue as
+* one record.  (The terminator is not sent.)
+* \sa esos_CommQueueOutput
+*/
+uint8_t esos_CommQueueOutputString(char* psz_Out) {
+  return esos_CommQueueOutput( (uint8_t*) psz_Out, strlen( psz_Out ) );
+} // endof esos_CommQueueOutputString()
+
+/**
+* Formats text (see esos_format.h) straight into the console's output
+* queue as one record.
+* \retval TRUE       if the whole record was queued
+* \retval FALSE      if the queue does not have room for it right now
+* \retval ESOS_COMM_OUTQ_TOO_LONG  if the text does not fit even in the
+*                    empty queue, so it can never be queued
+* \sa ESOS_TASK_WAIT_ON_QUEUED_SEND_FORMATTED
+*/
+uint8_t esos_CommQueueFormat(const char* psz_Fmt, ...) {
+  va_list       ap;
+  uint16_t      u16_Len;
+  uint8_t       au8_Hdr[__ESOS_COMM_OUTQ_REC_HDR_LEN];
+
+  va_start(ap, psz_Fmt);
+  u16_Len = esos_VFormatToRing( &__st_CommOutQ, __ESOS_COMM_OUTQ_REC_HDR_LEN, psz_Fmt, ap );
+  va_end(ap);
+  if (u16_Len == ESOS_FORMAT_NO_ROOM) {
+    // the length is only known once formatted, so judge by an empty queue
+    if (__ESOS_SPSC_IS_EMPTY( &__st_CommOutQ ))
+      return ESOS_COMM_OUTQ_TOO_LONG;
+    return FALSE;
+  }
+  if (u16_Len == 0) return TRUE;
+  au8_Hdr[0] = u16_Len & 0xFF;
+  au8_Hdr[1] = u16_Len >> 8;
+  __esos_SPSC_PutUINT8Span( &__st_CommOutQ, 0, au8_Hdr, __ESOS_COMM_OUTQ_REC_HDR_LEN );
+  __ESOS_SPSC_COMMIT( &__st_CommOutQ, u16_Len+__ESOS_COMM_OUTQ_REC_HDR_LEN );
+  return TRUE;
+} // endof esos_CommQueueFormat()
+
+/**
+* Drains the output queue into the console.  Only the records queued
+* when it takes the "out" stream are sent in that batch, so tasks
+* writing to the console directly get their turn, too.
+*/
+ESOS_USER_TASK( __esos_CommOutQDrain ) {
+  static uint16_t     u16_BatchLeft;
+  static uint16_t     u16_RecLeft;
+
+  ESOS_TASK_BEGIN();
+  while (TRUE) {
+    ESOS_TASK_WAIT_WHILE_SPSC_IS_EMPTY( &__st_CommOutQ );
+    ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM();
+    u16_BatchLeft = __ESOS_SPSC_GET_COUNT( &__st_CommOutQ );
+    while (u16_BatchLeft) {
+      u16_RecLeft = __ESOS_SPSC_PEEK( &__st_CommOutQ, 0 ) | (__ESOS_SPSC_PEEK( &__st_CommOutQ, 1 ) << 8);
+      __ESOS_SPSC_RELEASE( &__st_CommOutQ, __ESOS_COMM_OUTQ_REC_HDR_LEN );
+      u16_BatchLeft -= u16_RecLeft+__ESOS_COMM_OUTQ_REC_HDR_LEN;
+      while (u16_RecLeft) {
+        ESOS_TASK_WAIT_WHILE_SPSC_IS_FULL( __pst_CB_Tx );
+        u16_RecLeft -= __esos_SPSC_MoveUINT8Buffer( __pst_CB_Tx, &__st_CommOutQ, u16_RecLeft );
+        __esos_CommStartTx( ESOS_COMM_CONSOLE );
+      } // end while(u16_RecLeft)
+    } // end while(u16_BatchLeft)
+    ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM();
+  } // end while(TRUE)
+  ESOS_TASK_END();
+} // endof __esos_CommOutQDrain()
+#endif    // ESOS_USE_COMM_OUTQ
+
+/**
+* Formats text (see esos_format.h) straight into the "out" ring of
+* channel h_Chan, with no intermediate buffer.  The text goes in all at
+* once, or not at all.
+*
+* When the text does not fit, its length is kept in the channel, and
+* later calls just compare it to the free room:  the text is formatted
+* again only once there is room for it.
+*
+* \param h_Chan       the channel
+* \param psz_Fmt      the format string
+* \retval TRUE        if the text was written (and the backend kicked)
+* \retval FALSE       if the ring does not have room for all of it right now
+* \retval ESOS_COMM_FORMAT_TOO_LONG  if the text is longer than the whole
+*                     ring (nothing is written)
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_SEND_FORMATTED
+*/
+uint8_t esos_ChannelFormat(ESOS_COMM_HANDLE h_Chan, const char* psz_Fmt, ...) {
+  va_list       ap;
+  uint16_t      u16_Len;
+
+  if (__ESOS_SPSC_GET_AVAILABLE( &h_Chan->st_Tx ) < h_Chan->u16_OutNeed) return FALSE;
+  va_start(ap, psz_Fmt);
+  u16_Len = esos_VFormatToRing( &h_Chan->st_Tx, 0, psz_Fmt, ap );
+  va_end(ap);
+  if (u16_Len == ESOS_FORMAT_NO_ROOM) {
+    // measure the text once, so the next calls can wait for room cheaply
+    va_start(ap, psz_Fmt);
+    u16_Len = esos_VFormatString( NULLPTR, 0, psz_Fmt, ap );
+    va_end(ap);
+    if (u16_Len > __ESOS_SPSC_GET_LENGTH( &h_Chan->st_Tx )) {
+      h_Chan->u16_OutNeed = 0;
+      return ESOS_COMM_FORMAT_TOO_LONG;
+    }
+    h_Chan->u16_OutNeed = u16_Len;
+    return FALSE;
+  }
+  h_Chan->u16_OutNeed = 0;
+  if (u16_Len) {
+    __ESOS_SPSC_COMMIT( &h_Chan->st_Tx, u16_Len );
+    __esos_CommStartTx( h_Chan );
+  }
+  return TRUE;
+} // endof esos_ChannelFormat()
+
 uint8_t __esos_u8_GetMSBHexCharFromUint8(uint8_t u8_x) {
   uint8_t u8_c;
 
@@ -74,124 +406,131 @@ uint8_t __esos_u8_GetLSBHexCharFromUint8(uint8_t u8_x) {
 }
 
 
-ESOS_CHILD_TASK( __esos_OutChar, uint8_t u8_c) {
-  static uint8_t        u8_localChar;
-
+/*
+ * The comm child tasks run on behalf of the task that owns the stream
+ * of channel h_Chan.  Whatever they must remember across a wait is
+ * kept in the channel, not in static locals, so that child tasks on
+ * different channels can be in progress at the same time.
+ */
+ESOS_CHILD_TASK( __esos_OutChar, ESOS_COMM_HANDLE h_Chan, uint8_t u8_c) {
   ESOS_TASK_BEGIN();
-  u8_localChar = u8_c;
+  h_Chan->au8_OutScratch[0] = u8_c;
 
   // wait for room in the TX CB to appear
-  ESOS_TASK_WAIT_WHILE_CB_IS_FULL( __pst_CB_Tx );
+  ESOS_TASK_WAIT_WHILE_SPSC_IS_FULL( &h_Chan->st_Tx );
   // write the data in the TX CB
-  __esos_CB_WriteUINT8( __pst_CB_Tx, u8_localChar);
+  __esos_SPSC_WriteUINT8( &h_Chan->st_Tx, h_Chan->au8_OutScratch[0] );
   // signal the hardware that a xfer should be started if
   // not already ongoing
-  __esos_hw_signal_start_tx();
+  __esos_CommStartTx( h_Chan );
 
   ESOS_TASK_END();
 } // end __esos_OutChar
 
 
-ESOS_CHILD_TASK( __esos_OutUint8AsHexString, uint8_t u8_x) {
-  static uint8_t        au8_String[5];
-
+ESOS_CHILD_TASK( __esos_OutUint8AsHexString, ESOS_COMM_HANDLE h_Chan, uint8_t u8_x) {
   ESOS_TASK_BEGIN();
-  au8_String[0] = '0';
-  au8_String[1] = 'x';
-  au8_String[2] = __esos_u8_GetMSBHexCharFromUint8(u8_x);
-  au8_String[3] = __esos_u8_GetLSBHexCharFromUint8(u8_x);
-  au8_String[4] = 0;
-
-  ESOS_TASK_WAIT_UNTIL_CB_HAS_AVAILABLE_AT_LEAST( __pst_CB_Tx, 4);
-  __esos_CB_WriteUINT8Buffer( __pst_CB_Tx, &au8_String[0], 4 );
+  h_Chan->au8_OutScratch[0] = '0';
+  h_Chan->au8_OutScratch[1] = 'x';
+  h_Chan->au8_OutScratch[2] = __esos_u8_GetMSBHexCharFromUint8(u8_x);
+  h_Chan->au8_OutScratch[3] = __esos_u8_GetLSBHexCharFromUint8(u8_x);
+
+  ESOS_TASK_WAIT_UNTIL_SPSC_HAS_AVAILABLE_AT_LEAST( &h_Chan->st_Tx, 4);
+  __esos_SPSC_WriteUINT8Buffer( &h_Chan->st_Tx, &h_Chan->au8_OutScratch[0], 4 );
   // signal the hardware that a xfer should be started if
   // not already ongoing
-  __esos_hw_signal_start_tx();
+  __esos_CommStartTx( h_Chan );
   ESOS_TASK_END();
 
 } // end __esos_OutUint8AsHexString()
 
-ESOS_CHILD_TASK( __esos_OutUint8AsDecString, uint8_t u8_x) {
+ESOS_CHILD_TASK( __esos_OutUint8AsDecString, ESOS_COMM_HANDLE h_Chan, uint8_t u8_x) {
   // code provided by Gary Weasel
-  static uint8_t      au8_String[5];
-  static uint8_t      u8_c;
-  static uint8_t      u8_digit;
-
+  uint8_t       u8_digit;
 
   ESOS_TASK_BEGIN();
   u8_digit = 0;
   if (u8_x > 99)
-    au8_String[u8_digit++] = '0' + u8_x / 100;
+    h_Chan->au8_OutScratch[u8_digit++] = '0' + u8_x / 100;
   if (u8_x > 9)
-    au8_String[u8_digit++] = '0' + (u8_x % 100) / 10;
-  au8_String[u8_digit++] = '0' + (u8_x % 10);
-  au8_String[u8_digit] = 0;
-  u8_c = 0;
-  while (u8_c < u8_digit) {
-    // wait for room in the TX CB to appear
-    ESOS_TASK_WAIT_WHILE_CB_IS_FULL( __pst_CB_Tx );
-    // write the data in the TX CB
-    __esos_CB_WriteUINT8( __pst_CB_Tx, au8_String[u8_c++] );
-  } //end while()
+    h_Chan->au8_OutScratch[u8_digit++] = '0' + (u8_x % 100) / 10;
+  h_Chan->au8_OutScratch[u8_digit++] = '0' + (u8_x % 10);
+  h_Chan->u16_OutLeft = u8_digit;
+
+  ESOS_TASK_WAIT_UNTIL_SPSC_HAS_AVAILABLE_AT_LEAST( &h_Chan->st_Tx, h_Chan->u16_OutLeft);
+  __esos_SPSC_WriteUINT8Buffer( &h_Chan->st_Tx, &h_Chan->au8_OutScratch[0], h_Chan->u16_OutLeft );
   // signal the hardware that a xfer should be started if
   // not already ongoing
-  __esos_hw_signal_start_tx();
+  __esos_CommStartTx( h_Chan );
   ESOS_TASK_END();
 } // end __esos_OutUint8AsDecString
 
-ESOS_CHILD_TASK( __esos_OutUint32AsHexString, uint32_t u32_x) {
-  static uint8_t        au8_String[11];
-  static uint8_t        u8_c;
+ESOS_CHILD_TASK( __esos_OutUint32AsHexString, ESOS_COMM_HANDLE h_Chan, uint32_t u32_x) {
+  uint8_t*      pau8_String;
+  uint8_t       u8_c;
 
   ESOS_TASK_BEGIN();
-  au8_String[0] = '0';
-  au8_String[1] = 'x';
+  pau8_String = h_Chan->au8_OutScratch;
+  pau8_String[0] = '0';
+  pau8_String[1] = 'x';
   u8_c = (u32_x >> 24);
-  au8_String[2] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
-  au8_String[3] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
+  pau8_String[2] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
+  pau8_String[3] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
   u8_c = (u32_x >> 16);
-  au8_String[4] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
-  au8_String[5] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
+  pau8_String[4] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
+  pau8_String[5] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
   u8_c = (u32_x >> 8);
-  au8_String[6] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
-  au8_String[7] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
+  pau8_String[6] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
+  pau8_String[7] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
   u8_c = u32_x;
-  au8_String[8] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
-  au8_String[9] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
-  au8_String[10] = 0;
-  u8_c = 0;
+  pau8_String[8] = __esos_u8_GetMSBHexCharFromUint8(u8_c);
+  pau8_String[9] = __esos_u8_GetLSBHexCharFromUint8(u8_c);
 
-  ESOS_TASK_WAIT_UNTIL_CB_HAS_AVAILABLE_AT_LEAST( __pst_CB_Tx, 10);
-  __esos_CB_WriteUINT8Buffer( __pst_CB_Tx, &au8_String[0], 10 );
+  ESOS_TASK_WAIT_UNTIL_SPSC_HAS_AVAILABLE_AT_LEAST( &h_Chan->st_Tx, 10);
+  __esos_SPSC_WriteUINT8Buffer( &h_Chan->st_Tx, &h_Chan->au8_OutScratch[0], 10 );
   // signal the hardware that a xfer should be started if
   // not already ongoing
-  __esos_hw_signal_start_tx();
+  __esos_CommStartTx( h_Chan );
   ESOS_TASK_END();
 
 } // end __esos_OutUint32AsHexString()
 
-ESOS_CHILD_TASK( __esos_OutCharBuffer, uint8_t* pu8_out, uint8_t u8_len) {
+ESOS_CHILD_TASK( __esos_OutCharBuffer, ESOS_COMM_HANDLE h_Chan, uint8_t* pu8_out, uint16_t u16_len) {
+  uint16_t      u16_n;
+
   ESOS_TASK_BEGIN();
-  ESOS_TASK_WAIT_UNTIL_CB_HAS_AVAILABLE_AT_LEAST( __pst_CB_Tx, u8_len);
-  __esos_CB_WriteUINT8Buffer( __pst_CB_Tx, pu8_out, u8_len );
-  // signal the hardware that a xfer should be started if
-  // not already ongoing
-  __esos_hw_signal_start_tx();
+  h_Chan->pu8_Out = pu8_out;
+  h_Chan->u16_OutLeft = u16_len;
+  while (h_Chan->u16_OutLeft) {
+    // wait for room in the TX CB to appear, then fill as much of it
+    // as we can in one block.  (Buffers bigger than the TX CB go out
+    // in several blocks.)
+    ESOS_TASK_WAIT_WHILE_SPSC_IS_FULL( &h_Chan->st_Tx );
+    u16_n = __esos_SPSC_WriteUINT8Buffer( &h_Chan->st_Tx, h_Chan->pu8_Out, h_Chan->u16_OutLeft );
+    h_Chan->pu8_Out += u16_n;
+    h_Chan->u16_OutLeft -= u16_n;
+    // signal the hardware that a xfer should be started if
+    // not already ongoing
+    __esos_CommStartTx( h_Chan );
+  } //end while()
   ESOS_TASK_END();
 } // end __esos_OutCharBuffer
 
 
-ESOS_CHILD_TASK( __esos_OutString, char* psz_out ) {
-  static char*        psz_local;
+ESOS_CHILD_TASK( __esos_OutString, ESOS_COMM_HANDLE h_Chan, char* psz_out ) {
+  uint16_t      u16_n;
 
   ESOS_TASK_BEGIN();
-  psz_local = psz_out;
-  while ( *psz_local ) {
-    // wait for room in the TX CB to appear
-    ESOS_TASK_WAIT_WHILE_CB_IS_FULL( __pst_CB_Tx );
-    // write the data in the TX CB
-    __esos_CB_WriteUINT8( __pst_CB_Tx, *psz_local++ );
-    __esos_hw_signal_start_tx();
+  h_Chan->pu8_Out = (uint8_t*) psz_out;
+  h_Chan->u16_OutLeft = strlen( psz_out );
+  while ( h_Chan->u16_OutLeft ) {
+    // wait for room in the TX CB to appear, then copy as much of
+    // the string as fits in one block and kick the hardware once
+    ESOS_TASK_WAIT_WHILE_SPSC_IS_FULL( &h_Chan->st_Tx );
+    u16_n = __esos_SPSC_WriteUINT8Buffer( &h_Chan->st_Tx, h_Chan->pu8_Out, h_Chan->u16_OutLeft );
+    h_Chan->pu8_Out += u16_n;
+    h_Chan->u16_OutLeft -= u16_n;
+    __esos_CommStartTx( h_Chan );
   } //end while()
   ESOS_TASK_END();
 } // end __esos_OutString
@@ -201,20 +540,24 @@ ESOS_CHILD_TASK( __esos_OutString, char* psz_out ) {
  *  INCOMING COMM CHILD TASKS
  *************************************
 */
-ESOS_CHILD_TASK( __esos_getBuffer, uint8_t* pau8_buff, uint8_t u8_size) {
-  static uint8_t        u8_i;
-  static uint8_t*       pau8_LocalPtr;
-  static uint8_t        u8_LocalSize;
+// bytes __esos_getBuffer waits for when u16_left are still wanted:  all of
+//   them, or half the "in" ring, whichever is less
+#define   __ESOS_COMM_IN_CHUNK(h_Chan, u16_left)                                     \
+            (((u16_left) < (__ESOS_SPSC_GET_LENGTH( &(h_Chan)->st_Rx )+1)/2) ?       \
+             (u16_left) : (__ESOS_SPSC_GET_LENGTH( &(h_Chan)->st_Rx )+1)/2)
 
+ESOS_CHILD_TASK( __esos_getBuffer, ESOS_COMM_HANDLE h_Chan, uint8_t* pau8_buff, uint16_t u16_size) {
   ESOS_TASK_BEGIN();
-  u8_LocalSize = u8_size;
-  pau8_LocalPtr = pau8_buff;
-
-  for (u8_i=0; u8_i<u8_LocalSize; u8_i++) {
-    //wait for the RX character to arrive
-    ESOS_TASK_WAIT_WHILE ( __ESOS_CB_IS_EMPTY( __pst_CB_Rx ) );
-    pau8_LocalPtr[u8_i] = __esos_CB_ReadUINT8( __pst_CB_Rx );
-  } // end for(...)
+  h_Chan->u16_InCount = 0;
+  while (h_Chan->u16_InCount < u16_size) {
+    // wait for the rest of the data (or half a ring of it) to arrive, then
+    //   take it at once.  Taking long reads in halves leaves room for more
+    //   data to come in while the task gets around to it.
+    ESOS_TASK_WAIT_UNTIL( __ESOS_SPSC_GET_COUNT( &h_Chan->st_Rx ) >=
+                          __ESOS_COMM_IN_CHUNK( h_Chan, u16_size - h_Chan->u16_InCount ) );
+    h_Chan->u16_InCount += __esos_SPSC_ReadUINT8Buffer( &h_Chan->st_Rx, &pau8_buff[h_Chan->u16_InCount],
+                                                        u16_size - h_Chan->u16_InCount );
+  } // end while(...)
   ESOS_TASK_END();
 } // end __esos_getBuffer
 
@@ -222,27 +565,106 @@ ESOS_CHILD_TASK( __esos_getBuffer, uint8_t* pau8_buff, uint8_t u8_size) {
 // THIS FUNCTION IS POTENTIALLY VERY DANGEROUS!!!!!!
 // ************************************************************
 // The return data buffer pau8_buff must be at least as big as
-// the ESOS coming incoming buffer -- ESOS_SERIAL_OUT_EP_SIZE
+// the channel's incoming buffer -- ESOS_SERIAL_OUT_EP_SIZE on
+// the console
 //
 // Will suck down data until we get a zero-terminator, or
 // carriage return/newline type character.  Will also return when
-// the number of characters received is the size of the ESOS
-// incoming data buffer -- ESOS_SERIAL_OUT_EP_SIZE
+// the number of characters received is the size of the
+// incoming data buffer
 //
-ESOS_CHILD_TASK( __esos_getString, char* pau8_buff) {
-  static uint8_t        u8_i;
+// The string is found in place in the ring first, so the task wakes
+// once per string (not once per character) and copies it in one block.
+//
+static const uint8_t    __au8_CommStringEnds[3] = { '\n', '\r', 0 };
 
+ESOS_CHILD_TASK( __esos_getString, ESOS_COMM_HANDLE h_Chan, char* pau8_buff) {
   ESOS_TASK_BEGIN();
-  for (u8_i=0; u8_i<(ESOS_SERIAL_OUT_EP_SIZE-1); u8_i++) {
-    //wait for the RX character to arrive
-    ESOS_TASK_WAIT_WHILE ( __ESOS_CB_IS_EMPTY( __pst_CB_Rx ) );
-    pau8_buff[u8_i] = __esos_CB_ReadUINT8( __pst_CB_Rx );
-    if ((pau8_buff[u8_i] == '\n') || (pau8_buff[u8_i] == '\r') || (pau8_buff[u8_i] == 0)) break;
-  } // end for(...)
-  pau8_buff[u8_i] = 0;
+  ESOS_TASK_WAIT_UNTIL( (h_Chan->u16_InCount = __esos_CommScanIn( h_Chan, __au8_CommStringEnds, sizeof(__au8_CommStringEnds),
+                                                                  __ESOS_SPSC_GET_LENGTH( &h_Chan->st_Rx )-1 )) != 0 );
+  __esos_SPSC_GetUINT8Span( &h_Chan->st_Rx, 0, (uint8_t*) pau8_buff, h_Chan->u16_InCount );
+  __ESOS_SPSC_RELEASE( &h_Chan->st_Rx, h_Chan->u16_InCount );
+  // the terminator (if there is one) is replaced by the zero
+  if (memchr( __au8_CommStringEnds, pau8_buff[h_Chan->u16_InCount-1], sizeof(__au8_CommStringEnds) )) h_Chan->u16_InCount--;
+  pau8_buff[h_Chan->u16_InCount] = 0;
   ESOS_TASK_END();
 } // end __esos_getString
 
+/**
+* Looks in the "in" ring of channel h_Chan for a record ended by one of
+* the bytes in pau8_Set.  Only bytes that arrived since the last call
+* are searched, if that call looked for the same delimiters.
+*
+* \param h_Chan       the channel
+* \param pau8_Set     the bytes that end a record
+* \param u8_SetLen    number of bytes in pau8_Set
+* \param u16_Max      longest record:  a record this long ends even
+*                     without a delimiter
+* \retval N           length of the record (delimiter included)
+* \retval 0           if there is no whole record in the ring yet
+*/
+uint16_t __esos_CommScanIn(ESOS_COMM_HANDLE h_Chan, const uint8_t* pau8_Set, uint8_t u8_SetLen, uint16_t u16_Max) {
+  SPSCBUFFER*   pst_Rx = &h_Chan->st_Rx;
+  uint16_t      u16_Count, u16_Done, u16_At;
+
+  u16_Count = __ESOS_SPSC_GET_COUNT( pst_Rx );
+  // bytes already searched.  (If they have since been read some other
+  // way, the search starts over.)
+  u16_Done = h_Chan->u16_InScanEnd - pst_Rx->u16_Tail;
+  if (u16_Done > u16_Count) u16_Done = 0;
+  // (... and so does a search for other delimiters)
+  if ((u8_SetLen != h_Chan->u8_InScanSetLen) || memcmp( pau8_Set, h_Chan->au8_InScanSet, u8_SetLen )) u16_Done = 0;
+  u16_At = __esos_SPSC_ScanUINT8( pst_Rx, u16_Done, pau8_Set, u8_SetLen );
+  if (u16_At < u16_Max) return u16_At+1;
+  if (u16_Count >= u16_Max) return u16_Max;
+  h_Chan->u16_InScanEnd = pst_Rx->u16_Tail + u16_Count;
+  // remember what was looked for.  (Sets too big to keep are searched
+  //   from the start every time.)
+  if (u8_SetLen <= __ESOS_COMM_MAX_SCAN_SET) {
+    memcpy( h_Chan->au8_InScanSet, pau8_Set, u8_SetLen );
+    h_Chan->u8_InScanSetLen = u8_SetLen;
+  } else h_Chan->u8_InScanSetLen = 0;
+  return 0;
+} // endof __esos_CommScanIn()
+
+/**
+* Checks for a whole record ended by u8_Delim in the "in" ring of channel
+* h_Chan, and describes it in place.
+*
+* \param h_Chan       the channel
+* \param u8_Delim     the byte that ends a record
+* \param pst_View     filled in with the record (delimiter included)
+* \retval TRUE        if there is a record (or the ring is full of one
+*                     with no delimiter yet)
+* \retval FALSE       otherwise
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_GET_RECORD
+*/
+uint8_t esos_ChannelGetRecord(ESOS_COMM_HANDLE h_Chan, uint8_t u8_Delim, SPSCVIEW* pst_View) {
+  uint16_t      u16_Len;
+
+  u16_Len = __esos_CommScanIn( h_Chan, &u8_Delim, 1, __ESOS_SPSC_GET_LENGTH( &h_Chan->st_Rx ) );
+  if (u16_Len == 0) return FALSE;
+  __esos_SPSC_GetView( &h_Chan->st_Rx, u16_Len, pst_View );
+  return TRUE;
+} // endof esos_ChannelGetRecord()
+
+/**
+* Checks for u16_Size bytes in the "in" ring of channel h_Chan, and
+* describes them in place.
+*
+* \param h_Chan       the channel
+* \param u16_Size     number of bytes wanted (no more than the ring length)
+* \param pst_View     filled in with the bytes
+* \retval TRUE        if they are there
+* \retval FALSE       otherwise
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_GET_SIZED
+*/
+uint8_t esos_ChannelGetSized(ESOS_COMM_HANDLE h_Chan, uint16_t u16_Size, SPSCVIEW* pst_View) {
+  if (__ESOS_SPSC_GET_COUNT( &h_Chan->st_Rx ) < u16_Size) return FALSE;
+  __esos_SPSC_GetView( &h_Chan->st_Rx, u16_Size, pst_View );
+  return TRUE;
+} // endof esos_ChannelGetSized()
+
 
 // ================================================================
 // UNSAFE I/O functions.  Only use when you can be absolutely sure
@@ -254,9 +676,9 @@ ESOS_CHILD_TASK( __esos_getString, char* pau8_buff) {
 // This routine is UNSAFE.  It can HANG the system!!!!
 void __esos_unsafe_PutUint8(uint8_t u8_c) {
   // hang while CB is full
-  while (__ESOS_CB_IS_FULL( __pst_CB_Tx ));
+  while (__ESOS_SPSC_IS_FULL( __pst_CB_Tx ));
   // write the data in the TX CB
-  __esos_CB_WriteUINT8( __pst_CB_Tx, u8_c);
+  __esos_SPSC_WriteUINT8( __pst_CB_Tx, u8_c);
   // signal the hardware that a xfer should be started if
   // not already ongoing
   __esos_hw_signal_start_tx();
@@ -264,11 +686,16 @@ void __esos_unsafe_PutUint8(uint8_t u8_c) {
 
 // This routine is UNSAFE.  It can HANG the system!!!!
 void __esos_unsafe_PutString(char* psz_in) {
-  while ( *psz_in ) {
+  uint16_t    u16_left, u16_n;
+
+  u16_left = strlen( psz_in );
+  while ( u16_left ) {
     // hang while CB is full
-    while (__ESOS_CB_IS_FULL( __pst_CB_Tx ));
-    // write the data in the TX CB
-    __esos_CB_WriteUINT8( __pst_CB_Tx, *psz_in++);
+    while (__ESOS_SPSC_IS_FULL( __pst_CB_Tx ));
+    // write as much as fits in the TX CB
+    u16_n = __esos_SPSC_WriteUINT8Buffer( __pst_CB_Tx, (uint8_t*) psz_in, u16_left );
+    psz_in += u16_n;
+    u16_left -= u16_n;
     // signal the hardware that a xfer should be started if
     // not already ongoing
     __esos_hw_signal_start_tx();
@@ -278,7 +705,7 @@ void __esos_unsafe_PutString(char* psz_in) {
 // This routine is UNSAFE.  It can HANG the system!!!!
 uint8_t __esos_unsafe_GetUint8(void) {
   //wait for the RX character to arrive -- CAN HANG HERE!
-  while (__ESOS_CB_IS_EMPTY( __pst_CB_Rx ));
-  return __esos_CB_ReadUINT8( __pst_CB_Rx );  //return the character
+  while (__ESOS_SPSC_IS_EMPTY( __pst_CB_Rx ));
+  return __esos_SPSC_ReadUINT8( __pst_CB_Rx );  //return the character
 }
 
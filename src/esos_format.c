@@ -0,0 +1,487 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/** \file
+ * \brief Allocation-free formatted output for ESOS32
+ *
+ */
+
+
+#include    "esos.h"
+#include    "esos_format.h"
+#include    <string.h>
+#include    <limits.h>
+
+// ******** G L O B A L S ***************
+// "00" "01" ... "99":  decimal numbers are converted two digits at a time
+static const char __ac_FmtDigitPairs[200] = {
+  '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+  '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+  '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+  '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+  '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+  '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+  '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+  '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+  '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+  '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+static const char __ac_FmtHexLower[16] = {'0','1','2','3','4','5','6','7','8','9','a','b','c','d','e','f'};
+static const char __ac_FmtHexUpper[16] = {'0','1','2','3','4','5','6','7','8','9','A','B','C','D','E','F'};
+static const uint32_t __au32_FmtPow10[10] = {
+  1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+// bits in the conversion flags
+#define   __ESOS_FMT_LEFT         ESOS_BIT0
+#define   __ESOS_FMT_ZERO         ESOS_BIT1
+#define   __ESOS_FMT_PLUS         ESOS_BIT2
+#define   __ESOS_FMT_SPACE        ESOS_BIT3
+#define   __ESOS_FMT_ALT          ESOS_BIT4
+#define   __ESOS_FMT_PREC         ESOS_BIT5
+
+// argument lengths
+#define   __ESOS_FMT_LEN_INT      0
+#define   __ESOS_FMT_LEN_HH       1
+#define   __ESOS_FMT_LEN_H        2
+#define   __ESOS_FMT_LEN_L        3
+#define   __ESOS_FMT_LEN_LL       4
+
+// stores character c at output position u32_pos, if there is room for it
+//   (u32_pos is evaluated twice)
+#define   __ESOS_FMT_PUT(pstS, u32_pos, c)                                        \
+  do {                                                                            \
+    if ((u32_pos) < (pstS)->u16_Room)                                             \
+      (pstS)->pau8_Data[((pstS)->u16_Start+(uint16_t)(u32_pos)) & (pstS)->u16_Mask] = (c); \
+  } while(0)
+
+/****************************************************************
+** F U N C T I O N S
+****************************************************************/
+/**
+* Adds u16_n bytes to the length of the output (stopping at 0xFFFF)
+* \retval N   the output position the bytes start at
+*/
+static uint32_t __esos_FmtAdvance(ESOS_FMT_SINK* pst_Sink, uint16_t u16_n) {
+  uint32_t      u32_Pos, u32_End;
+
+  u32_Pos = pst_Sink->u16_Len;
+  u32_End = u32_Pos + u16_n;
+  pst_Sink->u16_Len = (u32_End > 0xFFFF) ? 0xFFFF : (uint16_t) u32_End;
+  return u32_Pos;
+} // end __esos_FmtAdvance()
+
+/**
+* Appends u16_n bytes to the output, or u16_n copies of one byte if
+* pu8_x is NULLPTR.  Copies in (at most) two contiguous spans.
+*/
+static void __esos_FmtPutBlock(ESOS_FMT_SINK* pst_Sink, const uint8_t* pu8_x, uint8_t u8_Fill, uint16_t u16_n) {
+  uint32_t      u32_Pos, u32_Span;
+  uint16_t      u16_Fit, u16_Begin;
+
+  u32_Pos = __esos_FmtAdvance(pst_Sink, u16_n);
+  if (u32_Pos >= pst_Sink->u16_Room) return;
+  u16_Fit = pst_Sink->u16_Room - u32_Pos;
+  if (u16_Fit > u16_n) u16_Fit = u16_n;
+  u16_Begin = (pst_Sink->u16_Start + (uint16_t) u32_Pos) & pst_Sink->u16_Mask;
+  u32_Span = (uint32_t) pst_Sink->u16_Mask + 1 - u16_Begin;
+  if (u32_Span > u16_Fit) u32_Span = u16_Fit;
+  if (pu8_x) {
+    memcpy( &pst_Sink->pau8_Data[u16_Begin], pu8_x, u32_Span );
+    memcpy( &pst_Sink->pau8_Data[0], &pu8_x[u32_Span], u16_Fit-u32_Span );
+  } else {
+    memset( &pst_Sink->pau8_Data[u16_Begin], u8_Fill, u32_Span );
+    memset( &pst_Sink->pau8_Data[0], u8_Fill, u16_Fit-u32_Span );
+  }
+} // end __esos_FmtPutBlock()
+
+/**
+* \retval N   number of decimal digits in u64_x (at least 1)
+*/
+static uint8_t __esos_FmtDecDigits(uint64_t u64_x) {
+  uint8_t       u8_n = 0, u8_d = 1;
+  uint32_t      u32_x;
+
+  // peel off 8 digits at a time until the rest fits 32 bits
+  while (u64_x > 0xFFFFFFFFUL) {
+    u64_x /= 100000000UL;
+    u8_n += 8;
+  }
+  u32_x = (uint32_t) u64_x;
+  while ((u8_d < 10) && (u32_x >= __au32_FmtPow10[u8_d])) u8_d++;
+  return u8_n + u8_d;
+} // end __esos_FmtDecDigits()
+
+/**
+* Stores the u8_n lowest decimal digits of u32_x (with leading zeros)
+* at output positions u32_Pos on.  The digits are made last to first,
+* two at a time, straight into place.
+*/
+static void __esos_FmtPutDec32(ESOS_FMT_SINK* pst_Sink, uint32_t u32_Pos, uint32_t u32_x, uint8_t u8_n) {
+  const char*   pc_Pair;
+
+  u32_Pos += u8_n;
+  while (u8_n >= 2) {
+    pc_Pair = &__ac_FmtDigitPairs[(u32_x % 100) * 2];
+    u32_x /= 100;
+    u32_Pos -= 2;
+    __ESOS_FMT_PUT(pst_Sink, u32_Pos, pc_Pair[0]);
+    __ESOS_FMT_PUT(pst_Sink, u32_Pos+1, pc_Pair[1]);
+    u8_n -= 2;
+  }
+  if (u8_n) __ESOS_FMT_PUT(pst_Sink, u32_Pos-1, '0' + (u32_x % 10));
+} // end __esos_FmtPutDec32()
+
+/**
+* Stores the u8_n lowest decimal digits of u64_x (with leading zeros)
+* at output positions u32_Pos on.  64-bit values are split into 8-digit
+* pieces, so only the 32-bit conversion runs per digit pair.
+*/
+static void __esos_FmtPutDec(ESOS_FMT_SINK* pst_Sink, uint32_t u32_Pos, uint64_t u64_x, uint8_t u8_n) {
+  while ((u64_x > 0xFFFFFFFFUL) && (u8_n > 8)) {
+    u8_n -= 8;
+    __esos_FmtPutDec32(pst_Sink, u32_Pos+u8_n, (uint32_t)(u64_x % 100000000UL), 8);
+    u64_x /= 100000000UL;
+  }
+  __esos_FmtPutDec32(pst_Sink, u32_Pos, (uint32_t) u64_x, u8_n);
+} // end __esos_FmtPutDec()
+
+/**
+* \retval N   number of hex digits in u64_x (at least 1)
+*/
+static uint8_t __esos_FmtHexDigits(uint64_t u64_x) {
+  uint8_t       u8_n = 1;
+
+  while (u64_x >>= 4) u8_n++;
+  return u8_n;
+} // end __esos_FmtHexDigits()
+
+/**
+* Stores the u8_n lowest hex digits of u64_x at output positions u32_Pos on
+*/
+static void __esos_FmtPutHex(ESOS_FMT_SINK* pst_Sink, uint32_t u32_Pos, uint64_t u64_x, uint8_t u8_n, const char* pc_Digits) {
+  u32_Pos += u8_n;
+  while (u8_n--) {
+    u32_Pos--;
+    __ESOS_FMT_PUT(pst_Sink, u32_Pos, pc_Digits[u64_x & 0xF]);
+    u64_x >>= 4;
+  }
+} // end __esos_FmtPutHex()
+
+/**
+* Appends u16_n characters at pc_Str, padded out to u16_Width
+*/
+static void __esos_FmtPutString(ESOS_FMT_SINK* pst_Sink, const char* pc_Str, uint16_t u16_n,
+                                uint8_t u8_Flags, uint16_t u16_Width) {
+  if ((u16_Width > u16_n) && !(u8_Flags & __ESOS_FMT_LEFT)) __esos_FmtPutBlock(pst_Sink, NULLPTR, ' ', u16_Width-u16_n);
+  __esos_FmtPutBlock(pst_Sink, (const uint8_t*) pc_Str, 0, u16_n);
+  if ((u16_Width > u16_n) && (u8_Flags & __ESOS_FMT_LEFT)) __esos_FmtPutBlock(pst_Sink, NULLPTR, ' ', u16_Width-u16_n);
+} // end __esos_FmtPutString()
+
+/**
+* Appends one formatted number:  the padding, sign, prefix and leading
+* zeros, and then the digits.  For 'q' conversions, u8_Frac digits of
+* the value are put after a decimal point.
+*
+* \param pst_Sink       where the output goes
+* \param u64_x          magnitude of the number
+* \param u8_Sign        sign character, or 0 for none
+* \param u8_Type        'd' (decimal), 'x'/'X' (hex) or 'q' (fixed-point)
+* \param u8_Flags       conversion flags
+* \param u16_Width      minimum field width
+* \param u16_Prec       precision (if u8_Flags has __ESOS_FMT_PREC)
+*/
+static void __esos_FmtPutNumber(ESOS_FMT_SINK* pst_Sink, uint64_t u64_x, uint8_t u8_Sign, uint8_t u8_Type,
+                                uint8_t u8_Flags, uint16_t u16_Width, uint16_t u16_Prec) {
+  uint8_t       u8_Digits, u8_Prefix = 0, u8_Frac = 0;
+  uint16_t      u16_Zeros = 0, u16_Body, u16_Pad;
+  uint32_t      u32_Pos;
+  uint64_t      u64_Int = u64_x;
+
+  if (u8_Type == 'q') {
+    // the integer part, then a point and u8_Frac more digits
+    u8_Frac = (u8_Flags & __ESOS_FMT_PREC) ? ((u16_Prec > 9) ? 9 : u16_Prec) : 0;
+    u64_Int = u64_x / __au32_FmtPow10[u8_Frac];
+    u8_Digits = __esos_FmtDecDigits(u64_Int);
+  } else if (u8_Type == 'd') {
+    u8_Digits = __esos_FmtDecDigits(u64_x);
+  } else {
+    u8_Digits = __esos_FmtHexDigits(u64_x);
+    if ((u8_Flags & __ESOS_FMT_ALT) && u64_x) u8_Prefix = 2;
+  }
+  if ((u8_Type != 'q') && (u8_Flags & __ESOS_FMT_PREC)) {
+    // the precision is the minimum number of digits (and "%.0d" of 0 is empty)
+    if ((u16_Prec == 0) && (u64_x == 0)) u8_Digits = 0;
+    if (u16_Prec > u8_Digits) u16_Zeros = u16_Prec - u8_Digits;
+  }
+  u16_Body = (u8_Sign ? 1 : 0) + u8_Prefix + u16_Zeros + u8_Digits + (u8_Frac ? u8_Frac+1 : 0);
+  u16_Pad = (u16_Width > u16_Body) ? u16_Width - u16_Body : 0;
+  if ((u8_Flags & __ESOS_FMT_ZERO) && !(u8_Flags & __ESOS_FMT_LEFT) &&
+      ((u8_Type == 'q') || !(u8_Flags & __ESOS_FMT_PREC))) {
+    u16_Zeros += u16_Pad;
+    u16_Pad = 0;
+  }
+
+  if (u16_Pad && !(u8_Flags & __ESOS_FMT_LEFT)) __esos_FmtPutBlock(pst_Sink, NULLPTR, ' ', u16_Pad);
+  u32_Pos = __esos_FmtAdvance(pst_Sink, (u8_Sign ? 1 : 0) + u8_Prefix);
+  if (u8_Sign) {
+    __ESOS_FMT_PUT(pst_Sink, u32_Pos, u8_Sign);
+    u32_Pos++;
+  }
+  if (u8_Prefix) {
+    __ESOS_FMT_PUT(pst_Sink, u32_Pos, '0');
+    __ESOS_FMT_PUT(pst_Sink, u32_Pos+1, u8_Type);
+  }
+  if (u16_Zeros) __esos_FmtPutBlock(pst_Sink, NULLPTR, '0', u16_Zeros);
+  u32_Pos = __esos_FmtAdvance(pst_Sink, u8_Digits + (u8_Frac ? u8_Frac+1 : 0));
+  if (u8_Type == 'x') {
+    __esos_FmtPutHex(pst_Sink, u32_Pos, u64_x, u8_Digits, __ac_FmtHexLower);
+  } else if (u8_Type == 'X') {
+    __esos_FmtPutHex(pst_Sink, u32_Pos, u64_x, u8_Digits, __ac_FmtHexUpper);
+  } else {
+    __esos_FmtPutDec(pst_Sink, u32_Pos, u64_Int, u8_Digits);
+    if (u8_Frac) {
+      u32_Pos += u8_Digits;
+      __ESOS_FMT_PUT(pst_Sink, u32_Pos, '.');
+      __esos_FmtPutDec32(pst_Sink, u32_Pos+1, (uint32_t)(u64_x % __au32_FmtPow10[u8_Frac]), u8_Frac);
+    }
+  }
+  if (u16_Pad && (u8_Flags & __ESOS_FMT_LEFT)) __esos_FmtPutBlock(pst_Sink, NULLPTR, ' ', u16_Pad);
+} // end __esos_FmtPutNumber()
+
+/**
+* Formats the argument list ap as psz_Fmt says, into pst_Sink.  The
+* sink's u16_Len must start at 0.  It holds the length of the whole
+* output afterwards, even if it did not all fit.
+*
+* \param pst_Sink       where the output goes
+* \param psz_Fmt        the format string (see esos_format.h)
+* \param ap             the arguments
+*/
+void __esos_VFormat(ESOS_FMT_SINK* pst_Sink, const char* psz_Fmt, va_list ap) {
+  const char*   pc_Run;
+  const char*   psz_Str;
+  uint8_t       u8_Flags, u8_Long, u8_Sign, u8_c;
+  uint16_t      u16_Width, u16_Prec, u16_n;
+  int           i_x;
+  int64_t       i64_x;
+  uint64_t      u64_x;
+
+  while (*psz_Fmt) {
+    // copy literal text up to the next conversion in one block
+    pc_Run = psz_Fmt;
+    while (*psz_Fmt && (*psz_Fmt != '%')) psz_Fmt++;
+    if (psz_Fmt != pc_Run) __esos_FmtPutBlock(pst_Sink, (const uint8_t*) pc_Run, 0, psz_Fmt - pc_Run);
+    if (!*psz_Fmt) break;
+    psz_Fmt++;
+
+    // flags
+    u8_Flags = 0;
+    while (TRUE) {
+      if (*psz_Fmt == '-') u8_Flags |= __ESOS_FMT_LEFT;
+      else if (*psz_Fmt == '0') u8_Flags |= __ESOS_FMT_ZERO;
+      else if (*psz_Fmt == '+') u8_Flags |= __ESOS_FMT_PLUS;
+      else if (*psz_Fmt == ' ') u8_Flags |= __ESOS_FMT_SPACE;
+      else if (*psz_Fmt == '#') u8_Flags |= __ESOS_FMT_ALT;
+      else break;
+      psz_Fmt++;
+    } // end while(flags)
+    // width
+    u16_Width = 0;
+    if (*psz_Fmt == '*') {
+      i_x = va_arg(ap, int);
+      if (i_x < 0) {
+        u8_Flags |= __ESOS_FMT_LEFT;
+        // (-INT_MIN does not exist:  clamp it first)
+        i_x = (i_x == INT_MIN) ? INT_MAX : -i_x;
+      }
+      u16_Width = ((unsigned int) i_x > 0xFFFF) ? 0xFFFF : i_x;
+      psz_Fmt++;
+    } else {
+      while ((*psz_Fmt >= '0') && (*psz_Fmt <= '9')) u16_Width = u16_Width*10 + (*psz_Fmt++ - '0');
+    }
+    // precision
+    u16_Prec = 0;
+    if (*psz_Fmt == '.') {
+      psz_Fmt++;
+      u8_Flags |= __ESOS_FMT_PREC;
+      if (*psz_Fmt == '*') {
+        i_x = va_arg(ap, int);
+        if (i_x < 0) u8_Flags &= ~__ESOS_FMT_PREC;
+        else u16_Prec = ((unsigned int) i_x > 0xFFFF) ? 0xFFFF : i_x;
+        psz_Fmt++;
+      } else {
+        while ((*psz_Fmt >= '0') && (*psz_Fmt <= '9')) u16_Prec = u16_Prec*10 + (*psz_Fmt++ - '0');
+      }
+    }
+    // length
+    u8_Long = __ESOS_FMT_LEN_INT;
+    if (*psz_Fmt == 'h') {
+      psz_Fmt++;
+      u8_Long = __ESOS_FMT_LEN_H;
+      if (*psz_Fmt == 'h') {
+        psz_Fmt++;
+        u8_Long = __ESOS_FMT_LEN_HH;
+      }
+    } else if (*psz_Fmt == 'l') {
+      psz_Fmt++;
+      u8_Long = __ESOS_FMT_LEN_L;
+      if (*psz_Fmt == 'l') {
+        psz_Fmt++;
+        u8_Long = __ESOS_FMT_LEN_LL;
+      }
+    }
+
+    u8_c = *psz_Fmt;
+    if (!u8_c) break;
+    psz_Fmt++;
+    switch (u8_c) {
+      case 'd':
+      case 'i':
+      case 'q':
+        if (u8_Long == __ESOS_FMT_LEN_LL) i64_x = va_arg(ap, long long);
+        else if (u8_Long == __ESOS_FMT_LEN_L) i64_x = va_arg(ap, long);
+        else if (u8_Long == __ESOS_FMT_LEN_H) i64_x = (short) va_arg(ap, int);
+        else if (u8_Long == __ESOS_FMT_LEN_HH) i64_x = (signed char) va_arg(ap, int);
+        else i64_x = va_arg(ap, int);
+        if (i64_x < 0) {
+          u8_Sign = '-';
+          u64_x = -(uint64_t) i64_x;
+        } else {
+          u8_Sign = (u8_Flags & __ESOS_FMT_PLUS) ? '+' : ((u8_Flags & __ESOS_FMT_SPACE) ? ' ' : 0);
+          u64_x = i64_x;
+        }
+        __esos_FmtPutNumber(pst_Sink, u64_x, u8_Sign, (u8_c == 'q') ? 'q' : 'd', u8_Flags, u16_Width, u16_Prec);
+        break;
+      case 'u':
+      case 'x':
+      case 'X':
+        if (u8_Long == __ESOS_FMT_LEN_LL) u64_x = va_arg(ap, unsigned long long);
+        else if (u8_Long == __ESOS_FMT_LEN_L) u64_x = va_arg(ap, unsigned long);
+        else if (u8_Long == __ESOS_FMT_LEN_H) u64_x = (unsigned short) va_arg(ap, unsigned int);
+        else if (u8_Long == __ESOS_FMT_LEN_HH) u64_x = (unsigned char) va_arg(ap, unsigned int);
+        else u64_x = va_arg(ap, unsigned int);
+        __esos_FmtPutNumber(pst_Sink, u64_x, 0, (u8_c == 'u') ? 'd' : u8_c, u8_Flags, u16_Width, u16_Prec);
+        break;
+      case 'c':
+        u8_c = (uint8_t) va_arg(ap, int);
+        __esos_FmtPutString(pst_Sink, (const char*) &u8_c, 1, u8_Flags, u16_Width);
+        break;
+      case 's':
+        psz_Str = va_arg(ap, const char*);
+        if (psz_Str == NULLPTR) psz_Str = "(null)";
+        // (a precision limits how much of the string is read)
+        for (u16_n=0; ((!(u8_Flags & __ESOS_FMT_PREC)) || (u16_n < u16_Prec)) && psz_Str[u16_n]; u16_n++);
+        __esos_FmtPutString(pst_Sink, psz_Str, u16_n, u8_Flags, u16_Width);
+        break;
+      default:
+        // "%%" (and anything we do not know) is copied as is
+        __esos_FmtPutBlock(pst_Sink, &u8_c, 0, 1);
+        break;
+    } // end switch()
+  } // end while()
+} // end __esos_VFormat()
+
+/**
+* Formats into a character buffer, like snprintf().  The output is
+* always zero-terminated (if u16_Size is not 0), and cut short if it
+* does not fit.
+*
+* \param pc_Buf         the buffer
+* \param u16_Size       size of the buffer (in bytes)
+* \param psz_Fmt        the format string (see esos_format.h)
+* \param ap             the arguments
+* \retval N             length of the whole output (not counting the terminator),
+*                       even if it did not all fit
+*/
+uint16_t esos_VFormatString(char* pc_Buf, uint16_t u16_Size, const char* psz_Fmt, va_list ap) {
+  ESOS_FMT_SINK   st_Sink;
+
+  st_Sink.pau8_Data = (uint8_t*) pc_Buf;
+  st_Sink.u16_Mask = 0xFFFF;
+  st_Sink.u16_Start = 0;
+  st_Sink.u16_Room = u16_Size ? u16_Size-1 : 0;
+  st_Sink.u16_Len = 0;
+  __esos_VFormat(&st_Sink, psz_Fmt, ap);
+  if (u16_Size)
+    pc_Buf[(st_Sink.u16_Len < st_Sink.u16_Room) ? st_Sink.u16_Len : st_Sink.u16_Room] = 0;
+  return st_Sink.u16_Len;
+} // end esos_VFormatString()
+
+/**
+* \sa esos_VFormatString
+*/
+uint16_t esos_FormatString(char* pc_Buf, uint16_t u16_Size, const char* psz_Fmt, ...) {
+  va_list       ap;
+  uint16_t      u16_n;
+
+  va_start(ap, psz_Fmt);
+  u16_n = esos_VFormatString(pc_Buf, u16_Size, psz_Fmt, ap);
+  va_end(ap);
+  return u16_n;
+} // end esos_FormatString()
+
+/**
+* Formats straight into the free space of a SPSC ring, starting
+* u16_Offset bytes past its head.  Nothing is published:  the caller
+* commits the output (with \ref __ESOS_SPSC_COMMIT) if it fit.
+*
+* \param pst_Ring       the ring
+* \param u16_Offset     number of free bytes to leave in front of the output
+* \param psz_Fmt        the format string (see esos_format.h)
+* \param ap             the arguments
+* \retval N             length of the output
+* \retval ESOS_FORMAT_NO_ROOM   if it did not fit in the ring's free space
+* \note Must be called from the <em>producer</em> side of the ring.
+*/
+uint16_t esos_VFormatToRing(SPSCBUFFER* pst_Ring, uint16_t u16_Offset, const char* psz_Fmt, va_list ap) {
+  ESOS_FMT_SINK   st_Sink;
+
+  if (__ESOS_SPSC_GET_AVAILABLE( pst_Ring ) < u16_Offset) return ESOS_FORMAT_NO_ROOM;
+  st_Sink.pau8_Data = pst_Ring->pau8_Data;
+  st_Sink.u16_Mask = __ESOS_SPSC_GET_LENGTH( pst_Ring ) - 1;
+  st_Sink.u16_Start = pst_Ring->u16_Head + u16_Offset;
+  st_Sink.u16_Room = __ESOS_SPSC_GET_AVAILABLE( pst_Ring ) - u16_Offset;
+  st_Sink.u16_Len = 0;
+  __esos_VFormat(&st_Sink, psz_Fmt, ap);
+  if (st_Sink.u16_Len > st_Sink.u16_Room) return ESOS_FORMAT_NO_ROOM;
+  return st_Sink.u16_Len;
+} // end esos_VFormatToRing()
+
+/**
+* \sa esos_VFormatToRing
+*/
+uint16_t esos_FormatToRing(SPSCBUFFER* pst_Ring, uint16_t u16_Offset, const char* psz_Fmt, ...) {
+  va_list       ap;
+  uint16_t      u16_n;
+
+  va_start(ap, psz_Fmt);
+  u16_n = esos_VFormatToRing(pst_Ring, u16_Offset, psz_Fmt, ap);
+  va_end(ap);
+  return u16_n;
+} // end esos_FormatToRing()
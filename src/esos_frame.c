@@ -0,0 +1,262 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+/** \file
+ * \brief Framed binary protocol (COBS + CRC-16) over the ESOS32 comm system
+ *
+ */
+
+
+#include    "esos.h"
+#include    "esos_frame.h"
+#include    <string.h>
+
+// ******** G L O B A L S ***************
+// bits in the decoder flags
+#define   __ESOS_FRAME_OVERFLOW       ESOS_BIT0
+
+// the largest COBS code:  a block of 254 bytes not followed by a zero
+#define   __ESOS_FRAME_COBS_MAX_CODE  0xFF
+
+/**
+* Where the encoder is in the free space of the "out" ring
+**/
+typedef struct __stFRAMEENCODER {
+  SPSCBUFFER*     pst_Ring;         // the ring being written
+  uint16_t        u16_CodePos;      // position of the code byte of the current block
+  uint16_t        u16_Pos;          // position of the next byte
+  uint8_t         u8_Code;          // code of the current block so far
+} __ESOS_FRAME_ENCODER;
+
+// puts byte u8_x at position u16_Pos of the ring's free space
+#define   __ESOS_FRAME_PUT(pstEnc, u16_Pos, u8_x)                                           \
+            ((pstEnc)->pst_Ring->pau8_Data[__ESOS_SPSC_INDEX((pstEnc)->pst_Ring, (pstEnc)->pst_Ring->u16_Head+(u16_Pos))] = (u8_x))
+
+/****************************************************************
+** F U N C T I O N S
+****************************************************************/
+
+/**
+* Gets a decoder ready for the start of a frame
+*/
+static void __esos_FrameReset(ESOS_FRAME_DECODER* pst_Dec) {
+  pst_Dec->u16_Len = 0;
+  pst_Dec->u8_Code = 0;
+  pst_Dec->u8_Left = 0;
+  pst_Dec->u8_Flags = 0;
+} // endof __esos_FrameReset()
+
+/**
+* Sets up a frame decoder.
+*
+* \param pst_Dec        pointer to the decoder
+* \param pau8_Buf       storage for one decoded frame.  It must hold the
+*                       largest expected data plus \ref ESOS_FRAME_OVERHEAD bytes.
+* \param u16_Size       size of pau8_Buf
+* \param pst_Handlers   table of frame types and their handlers
+* \param u8_NumHandlers number of entries in the table
+* \param pfn_Default    handler for the types not in the table, or NULLPTR
+*                       to drop those frames
+*/
+void esos_InitFrameDecoder(ESOS_FRAME_DECODER* pst_Dec, uint8_t* pau8_Buf, uint16_t u16_Size,
+                           const ESOS_FRAME_HANDLER* pst_Handlers, uint8_t u8_NumHandlers,
+                           ESOS_FRAME_HANDLER_FN pfn_Default) {
+  pst_Dec->pau8_Buf = pau8_Buf;
+  pst_Dec->u16_Size = u16_Size;
+  pst_Dec->pst_Handlers = pst_Handlers;
+  pst_Dec->u8_NumHandlers = u8_NumHandlers;
+  pst_Dec->pfn_Default = pfn_Default;
+  pst_Dec->u16_Frames = 0;
+  pst_Dec->u16_Errors = 0;
+  __esos_FrameReset(pst_Dec);
+} // endof esos_InitFrameDecoder()
+
+/**
+* Adds decoded bytes to the frame.  (A frame too long for the buffer is
+* marked, and dropped when it ends.)
+*/
+static void __esos_FramePut(ESOS_FRAME_DECODER* pst_Dec, uint8_t* pu8_x, uint16_t u16_n) {
+  if (pst_Dec->u16_Len+u16_n > pst_Dec->u16_Size) {
+    pst_Dec->u8_Flags |= __ESOS_FRAME_OVERFLOW;
+  } else {
+    memcpy( &pst_Dec->pau8_Buf[pst_Dec->u16_Len], pu8_x, u16_n );
+    pst_Dec->u16_Len += u16_n;
+  }
+} // endof __esos_FramePut()
+
+/**
+* Checks a frame that has ended and hands it to its handler
+* \retval 1       if the frame was good
+* \retval 0       if it was dropped
+*/
+static uint8_t __esos_FrameEnd(ESOS_FRAME_DECODER* pst_Dec) {
+  uint16_t      u16_Len, u16_Crc;
+  uint8_t       u8_Type, u8_i;
+
+  u16_Len = pst_Dec->u16_Len;
+  if (pst_Dec->u8_Left || (pst_Dec->u8_Flags & __ESOS_FRAME_OVERFLOW) || (u16_Len < ESOS_FRAME_OVERHEAD)) {
+    pst_Dec->u16_Errors++;
+    return 0;
+  }
+  u16_Len -= 2;
+  u16_Crc = esos_buffer_crc16( ESOS_CRC16_INIT, pst_Dec->pau8_Buf, u16_Len );
+  if ((pst_Dec->pau8_Buf[u16_Len] != (u16_Crc & 0xFF)) || (pst_Dec->pau8_Buf[u16_Len+1] != (u16_Crc >> 8))) {
+    pst_Dec->u16_Errors++;
+    return 0;
+  }
+  pst_Dec->u16_Frames++;
+  u8_Type = pst_Dec->pau8_Buf[0];
+  for (u8_i=0; u8_i<pst_Dec->u8_NumHandlers; u8_i++) {
+    if (pst_Dec->pst_Handlers[u8_i].u8_Type == u8_Type) {
+      pst_Dec->pst_Handlers[u8_i].pfn_Handler( u8_Type, &pst_Dec->pau8_Buf[1], u16_Len-1 );
+      return 1;
+    }
+  } // end for
+  if (pst_Dec->pfn_Default) pst_Dec->pfn_Default( u8_Type, &pst_Dec->pau8_Buf[1], u16_Len-1 );
+  return 1;
+} // endof __esos_FrameEnd()
+
+/**
+* Decodes one contiguous span of received bytes.  The data inside a COBS
+* block is copied in one piece, up to the first zero.
+* \retval N   number of good frames completed
+*/
+static uint16_t __esos_FrameDecodeSpan(ESOS_FRAME_DECODER* pst_Dec, uint8_t* pu8_p, uint16_t u16_n) {
+  uint8_t*      pu8_End = pu8_p + u16_n;
+  uint8_t*      pu8_Zero;
+  uint16_t      u16_Take, u16_Frames = 0;
+  uint8_t       u8_Zero = 0;
+
+  while (pu8_p < pu8_End) {
+    if (*pu8_p == 0) {
+      // the end of a frame.  (Zeros between frames are ignored.)
+      if (pst_Dec->u8_Code) u16_Frames += __esos_FrameEnd(pst_Dec);
+      __esos_FrameReset(pst_Dec);
+      pu8_p++;
+    } else if (pst_Dec->u8_Left == 0) {
+      // a new COBS block.  It stands for a zero after the data of the block
+      // before it, unless that one was a full block.
+      if (pst_Dec->u8_Code && (pst_Dec->u8_Code != __ESOS_FRAME_COBS_MAX_CODE)) __esos_FramePut(pst_Dec, &u8_Zero, 1);
+      pst_Dec->u8_Code = *pu8_p;
+      pst_Dec->u8_Left = *pu8_p - 1;
+      pu8_p++;
+    } else {
+      u16_Take = pu8_End - pu8_p;
+      if (u16_Take > pst_Dec->u8_Left) u16_Take = pst_Dec->u8_Left;
+      // a zero here ends the frame early.  (The next pass finds it.)
+      pu8_Zero = memchr( pu8_p, 0, u16_Take );
+      if (pu8_Zero) u16_Take = pu8_Zero - pu8_p;
+      __esos_FramePut(pst_Dec, pu8_p, u16_Take);
+      pst_Dec->u8_Left -= u16_Take;
+      pu8_p += u16_Take;
+    }
+  } // end while
+  return u16_Frames;
+} // endof __esos_FrameDecodeSpan()
+
+/**
+* Decodes all of the bytes in a ring (normally the "in" ring of a comm
+* channel) and calls the handlers of the frames they complete.  The
+* bytes are decoded where they lie in the ring and released all at
+* once, one span at a time.
+*
+* \param pst_Dec      pointer to the decoder
+* \param pst_Ring     the ring.  The caller must be its consumer.
+* \retval N           number of good frames completed
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_FRAMES
+*/
+uint16_t esos_FrameDecode(ESOS_FRAME_DECODER* pst_Dec, SPSCBUFFER* pst_Ring) {
+  uint16_t      u16_Begin, u16_Span, u16_Frames = 0;
+
+  while (__ESOS_SPSC_IS_NOT_EMPTY(pst_Ring)) {
+    __ESOS_CB_MEMORY_BARRIER();
+    u16_Begin = __ESOS_SPSC_INDEX(pst_Ring, pst_Ring->u16_Tail);
+    u16_Span = __ESOS_SPSC_GET_LENGTH(pst_Ring) - u16_Begin;
+    if (u16_Span > __ESOS_SPSC_GET_COUNT(pst_Ring)) u16_Span = __ESOS_SPSC_GET_COUNT(pst_Ring);
+    u16_Frames += __esos_FrameDecodeSpan(pst_Dec, &pst_Ring->pau8_Data[u16_Begin], u16_Span);
+    __ESOS_SPSC_RELEASE(pst_Ring, u16_Span);
+  } // end while
+  return u16_Frames;
+} // endof esos_FrameDecode()
+
+/**
+* COBS-encodes bytes into the free space of the "out" ring
+*/
+static void __esos_FrameEncode(__ESOS_FRAME_ENCODER* pst_Enc, uint8_t* pu8_x, uint16_t u16_n) {
+  while (u16_n--) {
+    if (*pu8_x) {
+      __ESOS_FRAME_PUT(pst_Enc, pst_Enc->u16_Pos, *pu8_x);
+      pst_Enc->u16_Pos++;
+      pst_Enc->u8_Code++;
+    }
+    if ((*pu8_x == 0) || (pst_Enc->u8_Code == __ESOS_FRAME_COBS_MAX_CODE)) {
+      // close the block and start the next one
+      __ESOS_FRAME_PUT(pst_Enc, pst_Enc->u16_CodePos, pst_Enc->u8_Code);
+      pst_Enc->u16_CodePos = pst_Enc->u16_Pos++;
+      pst_Enc->u8_Code = 1;
+    }
+    pu8_x++;
+  } // end while
+} // endof __esos_FrameEncode()
+
+/**
+* Sends a frame out channel h_Chan.  The frame is encoded straight into
+* the channel's "out" ring, all at once or not at all.  The caller must
+* have the "out" stream of the channel.  (It may be called from a frame
+* handler to send a reply.)
+*
+* \param h_Chan       the channel
+* \param u8_Type      frame type
+* \param pau8_Data    the data
+* \param u16_Len      number of bytes of data
+* \retval TRUE        if the frame was written (and the backend kicked)
+* \retval FALSE       if the ring does not have room for it right now
+* \sa ESOS_TASK_WAIT_ON_CHANNEL_SEND_FRAME
+*/
+uint8_t esos_ChannelSendFrame(ESOS_COMM_HANDLE h_Chan, uint8_t u8_Type, uint8_t* pau8_Data, uint16_t u16_Len) {
+  __ESOS_FRAME_ENCODER  st_Enc;
+  uint16_t              u16_Crc;
+  uint8_t               au8_Crc[2];
+
+  if (!__ESOS_SPSC_IS_AVAILABLE_AT_LEAST( &h_Chan->st_Tx, ESOS_FRAME_WIRE_LEN(u16_Len) )) return FALSE;
+  u16_Crc = esos_buffer_crc16( ESOS_CRC16_INIT, &u8_Type, 1 );
+  u16_Crc = esos_buffer_crc16( u16_Crc, pau8_Data, u16_Len );
+  au8_Crc[0] = u16_Crc & 0xFF;
+  au8_Crc[1] = u16_Crc >> 8;
+  st_Enc.pst_Ring = &h_Chan->st_Tx;
+  st_Enc.u16_CodePos = 0;
+  st_Enc.u16_Pos = 1;
+  st_Enc.u8_Code = 1;
+  __esos_FrameEncode( &st_Enc, &u8_Type, 1 );
+  __esos_FrameEncode( &st_Enc, pau8_Data, u16_Len );
+  __esos_FrameEncode( &st_Enc, au8_Crc, 2 );
+  __ESOS_FRAME_PUT( &st_Enc, st_Enc.u16_CodePos, st_Enc.u8_Code );
+  __ESOS_FRAME_PUT( &st_Enc, st_Enc.u16_Pos, 0 );
+  __ESOS_SPSC_COMMIT( &h_Chan->st_Tx, st_Enc.u16_Pos+1 );
+  __esos_CommStartTx( h_Chan );
+  return TRUE;
+} // endof esos_ChannelSendFrame()
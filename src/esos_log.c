@@ -0,0 +1,271 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+/** \file
+ * \brief Deferred binary logging for ESOS32
+ *
+ */
+
+
+#include    "esos.h"
+#include    "esos_log.h"
+#include    <string.h>
+#include    <stdarg.h>
+
+#ifdef    ESOS_USE_LOG
+
+// ******** G L O B A L S ***************
+SPSCBUFFER                  __st_LogRing;
+static uint8_t              __au8_LogRing[ESOS_LOG_RING_SIZE];
+volatile uint16_t           __u16_LogDropped;
+static ESOS_COMM_HANDLE     __h_LogChan;
+static uint32_t             __u32_LogLastTick;
+
+// first byte of the format-string section (provided by the linker)
+extern const char           __start_esos_log[];
+// the format of the "records were dropped" record.  (It also makes sure
+// the section exists when the application has no ESOS_LOG in it.)
+static const char __ac_LogDroppedFmt[] __ESOS_LOG_SECTION = "<%u log records dropped>";
+
+// length modifiers
+#define   __ESOS_LOG_LEN_INT      0
+#define   __ESOS_LOG_LEN_LONG     1
+#define   __ESOS_LOG_LEN_LLONG    2
+
+// sync byte + length byte + format id
+#define   __ESOS_LOG_HDR_LEN      4
+// longest varint of a 32-bit number
+#define   __ESOS_LOG_MAX_TICK_LEN 5
+
+/**
+* Writes x as a LEB128 varint:  7 bits per byte, least significant
+* first, with the top bit set on every byte but the last.
+* \retval N   number of bytes written (at most 10)
+*/
+static uint8_t __esos_LogPutVarint(uint8_t* pu8_Out, uint64_t u64_x) {
+  uint8_t     u8_n = 0;
+
+  while (u64_x >= 0x80) {
+    pu8_Out[u8_n++] = (uint8_t) u64_x | 0x80;
+    u64_x >>= 7;
+  } // end while
+  pu8_Out[u8_n++] = (uint8_t) u64_x;
+  return u8_n;
+} // endof __esos_LogPutVarint()
+
+/**
+* Makes a log record and adds it to the log ring, all at once or not at
+* all.  Called by \ref ESOS_LOG.
+*
+* \param psz_Fmt    the format string, in the "esos_log" section
+* \retval TRUE      if the record was added
+* \retval FALSE     if it was dropped (ring full or record too long)
+*/
+uint8_t __esos_Log(const char* psz_Fmt, ...) {
+  va_list       ap;
+  uint8_t       au8_Args[ESOS_LOG_MAX_RECORD_LEN];
+  uint8_t       au8_Hdr[__ESOS_LOG_HDR_LEN+__ESOS_LOG_MAX_TICK_LEN];
+  uint16_t      u16_ArgLen, u16_Id, u16_Str;
+  uint8_t       u8_HdrLen, u8_Len, u8_Signed;
+  const char*   pc_Fmt;
+  const char*   psz_Str;
+  int64_t       i64_x;
+  uint64_t      u64_x;
+  uint32_t      u32_Tick, u32_State;
+
+  // the room left for arguments once the longest possible header is in
+  #define   __ESOS_LOG_ARG_ROOM   (ESOS_LOG_MAX_RECORD_LEN-__ESOS_LOG_HDR_LEN-__ESOS_LOG_MAX_TICK_LEN)
+  u16_ArgLen = 0;
+  va_start(ap, psz_Fmt);
+  pc_Fmt = psz_Fmt;
+  while (*pc_Fmt) {
+    if (*pc_Fmt++ != '%') continue;
+    // flags, width and precision.  Only a '*' takes an argument.
+    while (*pc_Fmt && strchr("-0+ #.123456789*", *pc_Fmt)) {
+      if (*pc_Fmt == '*') {
+        if (u16_ArgLen+10 > __ESOS_LOG_ARG_ROOM) goto too_long;
+        i64_x = va_arg(ap, int);
+        u64_x = ((uint64_t) i64_x << 1) ^ (uint64_t) (i64_x >> 63);
+        u16_ArgLen += __esos_LogPutVarint( &au8_Args[u16_ArgLen], u64_x );
+      }
+      pc_Fmt++;
+    } // end while
+    // length.  'hh' and 'h' arguments arrive promoted to int.
+    u8_Len = __ESOS_LOG_LEN_INT;
+    while (*pc_Fmt == 'h') pc_Fmt++;
+    if (*pc_Fmt == 'l') {
+      pc_Fmt++;
+      u8_Len = __ESOS_LOG_LEN_LONG;
+      if (*pc_Fmt == 'l') {
+        pc_Fmt++;
+        u8_Len = __ESOS_LOG_LEN_LLONG;
+      }
+    }
+    u8_Signed = FALSE;
+    switch (*pc_Fmt) {
+      case 'd':
+      case 'i':
+      case 'q':
+        u8_Signed = TRUE;
+        // fall through
+      case 'u':
+      case 'x':
+      case 'X':
+        if (u16_ArgLen+10 > __ESOS_LOG_ARG_ROOM) goto too_long;
+        if (u8_Signed) {
+          if (u8_Len == __ESOS_LOG_LEN_LLONG) i64_x = va_arg(ap, long long);
+          else if (u8_Len == __ESOS_LOG_LEN_LONG) i64_x = va_arg(ap, long);
+          else i64_x = va_arg(ap, int);
+          u64_x = ((uint64_t) i64_x << 1) ^ (uint64_t) (i64_x >> 63);
+        } else {
+          if (u8_Len == __ESOS_LOG_LEN_LLONG) u64_x = va_arg(ap, unsigned long long);
+          else if (u8_Len == __ESOS_LOG_LEN_LONG) u64_x = va_arg(ap, unsigned long);
+          else u64_x = va_arg(ap, unsigned int);
+        }
+        u16_ArgLen += __esos_LogPutVarint( &au8_Args[u16_ArgLen], u64_x );
+        break;
+      case 'c':
+        if (u16_ArgLen+1 > __ESOS_LOG_ARG_ROOM) goto too_long;
+        au8_Args[u16_ArgLen++] = (uint8_t) va_arg(ap, int);
+        break;
+      case 's':
+        // strings are cut short to fit in the record
+        if (u16_ArgLen+2 > __ESOS_LOG_ARG_ROOM) goto too_long;
+        psz_Str = va_arg(ap, const char*);
+        if (psz_Str == NULLPTR) psz_Str = "(null)";
+        u16_Str = strlen( psz_Str );
+        if (u16_Str > __ESOS_LOG_ARG_ROOM-u16_ArgLen-2) u16_Str = __ESOS_LOG_ARG_ROOM-u16_ArgLen-2;
+        u16_ArgLen += __esos_LogPutVarint( &au8_Args[u16_ArgLen], u16_Str );
+        memcpy( &au8_Args[u16_ArgLen], psz_Str, u16_Str );
+        u16_ArgLen += u16_Str;
+        break;
+      case '\0':
+        continue;
+      default:
+        break;
+    } // end switch
+    pc_Fmt++;
+  } // end while
+  va_end(ap);
+  #undef    __ESOS_LOG_ARG_ROOM
+
+  u16_Id = (uint16_t) (psz_Fmt - __start_esos_log);
+  au8_Hdr[0] = ESOS_LOG_SYNC;
+  au8_Hdr[2] = u16_Id & 0xFF;
+  au8_Hdr[3] = u16_Id >> 8;
+  // the tick delta (and the record's place in the ring) are set together,
+  // so the records stay in time order when ISRs log, too
+  __ESOS_ENTER_CRITICAL(u32_State);
+  u32_Tick = esos_GetSystemTick();
+  u8_HdrLen = __ESOS_LOG_HDR_LEN + __esos_LogPutVarint( &au8_Hdr[__ESOS_LOG_HDR_LEN], u32_Tick-__u32_LogLastTick );
+  au8_Hdr[1] = u8_HdrLen - 2 + u16_ArgLen;
+  if (!__ESOS_SPSC_IS_AVAILABLE_AT_LEAST( &__st_LogRing, u8_HdrLen+u16_ArgLen )) {
+    __u16_LogDropped++;
+    __ESOS_EXIT_CRITICAL(u32_State);
+    return FALSE;
+  }
+  __esos_SPSC_PutUINT8Span( &__st_LogRing, 0, au8_Hdr, u8_HdrLen );
+  __esos_SPSC_PutUINT8Span( &__st_LogRing, u8_HdrLen, au8_Args, u16_ArgLen );
+  __ESOS_SPSC_COMMIT( &__st_LogRing, u8_HdrLen+u16_ArgLen );
+  __u32_LogLastTick = u32_Tick;
+  __ESOS_EXIT_CRITICAL(u32_State);
+  return TRUE;
+
+too_long:
+  va_end(ap);
+  __ESOS_ENTER_CRITICAL(u32_State);
+  __u16_LogDropped++;
+  __ESOS_EXIT_CRITICAL(u32_State);
+  return FALSE;
+} // endof __esos_Log()
+
+/**
+* Sets the channel the log records are sent out on.  The default is
+* \ref ESOS_COMM_CONSOLE.
+*
+* \param h_Chan       the channel
+* \note Records already handed to the old channel are still sent there.
+*/
+void esos_SetLogChannel(ESOS_COMM_HANDLE h_Chan) {
+  __h_LogChan = h_Chan;
+} // endof esos_SetLogChannel()
+
+/**
+* Returns the number of log records dropped and not yet reported
+*/
+uint16_t esos_GetLogDropped(void) {
+  return __u16_LogDropped;
+} // endof esos_GetLogDropped()
+
+/**
+* Sends the log records out the log channel.  Only the records in the
+* ring when it takes the channel's "out" stream are sent in that batch,
+* so other tasks writing to the channel get their turn, too.
+*/
+ESOS_USER_TASK( __esos_LogDrain ) {
+  static ESOS_COMM_HANDLE   h_Chan;
+  static uint16_t           u16_BatchLeft;
+  uint16_t                  u16_Dropped;
+  uint32_t                  u32_State;
+
+  ESOS_TASK_BEGIN();
+  while (TRUE) {
+    ESOS_TASK_WAIT_UNTIL( __ESOS_SPSC_IS_NOT_EMPTY( &__st_LogRing ) || __u16_LogDropped );
+    u16_Dropped = __u16_LogDropped;
+    if (u16_Dropped) {
+      // a failed attempt counts itself as dropped, so take that back out
+      if (!__esos_Log( __ac_LogDroppedFmt, u16_Dropped )) u16_Dropped = 1;
+      __ESOS_ENTER_CRITICAL(u32_State);
+      __u16_LogDropped -= u16_Dropped;
+      __ESOS_EXIT_CRITICAL(u32_State);
+    }
+    h_Chan = __h_LogChan;
+    ESOS_TASK_WAIT_ON_AVAILABLE_OUT_CHANNEL( h_Chan );
+    u16_BatchLeft = __ESOS_SPSC_GET_COUNT( &__st_LogRing );
+    while (u16_BatchLeft) {
+      ESOS_TASK_WAIT_WHILE_SPSC_IS_FULL( &h_Chan->st_Tx );
+      u16_BatchLeft -= __esos_SPSC_MoveUINT8Buffer( &h_Chan->st_Tx, &__st_LogRing, u16_BatchLeft );
+      __esos_CommStartTx( h_Chan );
+    } // end while(u16_BatchLeft)
+    ESOS_TASK_SIGNAL_AVAILABLE_OUT_CHANNEL( h_Chan );
+  } // end while(TRUE)
+  ESOS_TASK_END();
+} // endof __esos_LogDrain()
+
+/**
+* Sets up the log ring and starts the task that drains it.  Called by
+* ESOS after the comm system is up, so user_init() may log.
+*/
+void __esos_InitLog(void) {
+  __esos_SPSC_Init( &__st_LogRing, __au8_LogRing, ESOS_LOG_RING_SIZE );
+  __u16_LogDropped = 0;
+  __h_LogChan = ESOS_COMM_CONSOLE;
+  __u32_LogLastTick = esos_GetSystemTick();
+  esos_RegisterTaskWithMailbox( __esos_LogDrain, 0 );
+} // endof __esos_InitLog()
+
+#endif    // ESOS_USE_LOG
@@ -31,97 +31,536 @@
  */
 
 
+#include    <string.h>
 #include    "esos.h"
 #include    "esos_mail.h"
 
 // ******** G L O B A L S ***************
 //MAILBOX     __astMailbox[MAX_NUM_USER_TASKS];
-//uint8_t       __au8_MBData[MAX_NUM_USER_TASKS][MAX_SIZE_TASK_MAILBOX];
 uint8_t       __u8_esos_mail_routines_dummy_uint8;
+// receives the (unused) header when a task only asks if it has matching mail
+MAILMESSAGE   __st_MailFilterScratch;
+
+// outstanding RPC calls.  A task blocks on its call, so each user task
+//   slot can have at most one
+MAILRPCCALL   __astRpcCalls[MAX_NUM_USER_TASKS];
+uint16_t      __u16_RpcLastCallID;
+
+// arena that task mailboxes are carved from at registration.  Each task
+//   slot remembers the slice it was given so it can be reused later
+uint8_t       __au8_MBArena[ESOS_MAILBOX_ARENA_SIZE];
+uint16_t      __u16_MBArenaUsed;
+uint8_t*      __apu8_MBSlice[MAX_NUM_USER_TASKS];
+uint16_t      __au16_MBSliceLen[MAX_NUM_USER_TASKS];
+
+// pool of fixed-size blocks for zero-copy messages
+ESOS_DECLARE_POOL(__st_MailBlockPool, ESOS_MAIL_BLOCK_SIZE, ESOS_MAIL_NUM_BLOCKS);
+uint8_t       __au8_MailBlockRefs[ESOS_MAIL_NUM_BLOCKS];
 
 /****************************************************************
 ** F U N C T I O N S
 ****************************************************************/
-void __esos_InitMailbox(MAILBOX* pst_Mailbox, uint8_t* pau8_ptr) {
-  __esos_CB_Init( pst_Mailbox->pst_CBuffer, pau8_ptr, MAX_SIZE_TASK_MAILBOX);
+void __esos_InitMailbox(MAILBOX* pst_Mailbox, uint8_t* pau8_ptr, uint16_t u16_Len) {
+  __esos_CB_Init( pst_Mailbox->pst_CBuffer, pau8_ptr, u16_Len);
+#ifdef ESOS_USE_MAIL_STATS
+  memset( &pst_Mailbox->st_Stats, 0, sizeof(MAILSTATS) );
+#endif
 } // endof esos_InitMailbox()
 
 /**
-* Writes message data to a task's mailbox.
+* Empties the mailbox arena.  Called once by ESOS at startup.
+*/
+void __esos_InitMailboxArena(void) {
+  uint8_t     u8_i;
+
+  __u16_MBArenaUsed = 0;
+  for (u8_i=0; u8_i<MAX_NUM_USER_TASKS; u8_i++) {
+    __apu8_MBSlice[u8_i] = NULLPTR;
+    __au16_MBSliceLen[u8_i] = 0;
+  }
+} // endof __esos_InitMailboxArena()
+
+/**
+* Gives the task in pool slot u8_Slot a (empty) mailbox of u16_Len bytes.
+* The slot's previous slice of the arena is reused if it is big enough.
+* Otherwise, a new slice is carved from the arena.  The old slice is given
+* back only if it was the last one carved, so tasks that repeatedly
+* re-register with growing mailboxes will eventually exhaust the arena.
+* If the new slice cannot be carved, the slot keeps its old slice.
 *
-* \param pst_RcvrTask  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be written
-* \param pst_Msg        pointer to mailbox message structure that contains data to write to the task's mailbox
-* \note This function <em>ASSUMES</em> that there is ample free space available in specified
-* mailbox.
+* \param pst_Mailbox  pointer to the slot's mailbox
+* \param u8_Slot      index of the slot in the user task pool
+* \param u16_Len      size of the mailbox (in bytes)
+* \retval TRUE        if the mailbox was attached
+* \retval FALSE       if the arena does not have u16_Len bytes left
+*/
+uint8_t __esos_AttachTaskMailbox(MAILBOX* pst_Mailbox, uint8_t u8_Slot, uint16_t u16_Len) {
+  uint16_t    u16_Top;
+
+  if (__au16_MBSliceLen[u8_Slot] < u16_Len) {
+    // if the slot's old slice is at the top of the arena, the new slice
+    //   can start where the old one does
+    u16_Top = __u16_MBArenaUsed;
+    if ((__apu8_MBSlice[u8_Slot] != NULLPTR) &&
+        ((__apu8_MBSlice[u8_Slot]+__au16_MBSliceLen[u8_Slot]) == &__au8_MBArena[__u16_MBArenaUsed]))
+      u16_Top -= __au16_MBSliceLen[u8_Slot];
+    if (u16_Len > (ESOS_MAILBOX_ARENA_SIZE - u16_Top))
+      return FALSE;
+    __apu8_MBSlice[u8_Slot] = &__au8_MBArena[u16_Top];
+    __au16_MBSliceLen[u8_Slot] = u16_Len;
+    __u16_MBArenaUsed = u16_Top + u16_Len;
+  }
+  // release any blocks still referenced by a previous owner's mail
+  __esos_FlushMailbox( pst_Mailbox );
+  __esos_InitMailbox( pst_Mailbox, __apu8_MBSlice[u8_Slot], u16_Len );
+  return TRUE;
+} // endof __esos_AttachTaskMailbox()
+
+/**
+* \retval N  total size (in bytes) of the mailbox arena
+*/
+uint16_t esos_GetMailboxArenaSize(void) {
+  return ESOS_MAILBOX_ARENA_SIZE;
+} // endof esos_GetMailboxArenaSize()
+
+/**
+* \retval N  number of mailbox arena bytes given to tasks so far
+*/
+uint16_t esos_GetMailboxArenaUsed(void) {
+  return __u16_MBArenaUsed;
+} // endof esos_GetMailboxArenaUsed()
+
+/**
+* \retval N  number of mailbox arena bytes still available to newly
+*            registered tasks
+* \sa esos_RegisterTaskWithMailbox
+*/
+uint16_t esos_GetMailboxArenaFree(void) {
+  return ESOS_MAILBOX_ARENA_SIZE - __u16_MBArenaUsed;
+} // endof esos_GetMailboxArenaFree()
+
+/**
+* Gives a task its own mailbox storage in place of the storage it was
+* given from the mailbox arena when it was registered.  Tasks that
+* receive bulk data can be given a larger mailbox, and tasks that never
+* receive mail a smaller one.  Any mail waiting in the task's mailbox
+* is flushed.
 *
-* \sa ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_SPACE
-* \hideinitializer
+* \param pst_Task      pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be replaced
+* \param pau8_Storage  pointer to the storage the mailbox will use.  The storage
+*                      must remain valid as long as the task is registered.
+* \param u16_Len       number of bytes of storage at pau8_Storage
+* \retval TRUE         if the task's mailbox now uses the new storage
+* \retval FALSE        if the storage cannot hold even an empty message
+*
+* \note Call this after \ref esos_RegisterTask.  Registering the task again
+* (or registering another task into its slot) gives it a mailbox from
+* the mailbox arena once more.
+* \sa ESOS_TASK_MAILBOX_GET_LENGTH
 */
-void __esos_SendMailMessage(ESOS_TASK_HANDLE pst_RcvrTask, MAILMESSAGE* pst_Msg ) {
-  uint8_t               u8_i;
+uint8_t esos_SetTaskMailbox(ESOS_TASK_HANDLE pst_Task, uint8_t* pau8_Storage, uint16_t u16_Len) {
+  if ((pst_Task == NULLPTR) || (pau8_Storage == NULLPTR) || (u16_Len < __MAIL_MSG_HEADER_LEN))
+    return FALSE;
+  __esos_FlushMailbox( pst_Task->pst_Mailbox );
+  __esos_InitMailbox( pst_Task->pst_Mailbox, pau8_Storage, u16_Len );
+  return TRUE;
+} // endof esos_SetTaskMailbox()
 
-  // first message btye:  flags in upper nibble, payload length in lower
-  u8_i = ((pst_Msg->u8_flags)<<4) + (pst_Msg->u8_DataLength & 0x0F);
-  __esos_CB_WriteUINT8( pst_RcvrTask->pst_Mailbox->pst_CBuffer, u8_i );
-  // second message word: Task ID of sending task
-  __esos_CB_WriteUINT16( pst_RcvrTask->pst_Mailbox->pst_CBuffer, ESOS_GET_PMSG_FROMTASK(pst_Msg) );
-  // Now, timestamp the message with double word
-  __esos_CB_WriteUINT32( pst_RcvrTask->pst_Mailbox->pst_CBuffer, esos_GetSystemTick() );
-  // Now write the data depending on what type and how many
+/**
+* Puts every mail block on the free list.  Called once by ESOS at startup.
+*/
+void __esos_InitMailBlocks(void) {
+  ESOS_INIT_POOL(__st_MailBlockPool, ESOS_MAIL_BLOCK_SIZE, ESOS_MAIL_NUM_BLOCKS);
+} // endof __esos_InitMailBlocks()
+
+/**
+* Takes a block from the pool of zero-copy mail blocks.  The caller owns
+* the block and may fill it in place (see \ref ESOS_MAIL_BLOCK_PTR)
+* before sending it with a message made by \ref ESOS_TASK_MAKE_MSG_BLOCK.
+*
+* \retval handle               handle of the allocated block
+* \retval ESOS_MAIL_NULL_BLOCK  if the pool is empty
+* \sa ESOS_TASK_WAIT_ON_AVAILABLE_MAIL_BLOCK
+* \sa esos_ReleaseMailBlock
+*/
+ESOS_MAILBLOCK_HANDLE esos_AllocMailBlock(void) {
+  ESOS_MAILBLOCK_HANDLE     h_Block;
+
+  h_Block = esos_AllocPoolBlock( &__st_MailBlockPool );
+  if (h_Block != ESOS_MAIL_NULL_BLOCK)
+    __au8_MailBlockRefs[h_Block] = 1;
+  return h_Block;
+} // endof esos_AllocMailBlock()
+
+/**
+* Adds a reference to a mail block, so that one more
+* \ref esos_ReleaseMailBlock is needed before the block returns to
+* the pool.  The reference count saturates rather than wrapping, so a
+* block already holding 255 references cannot take another.
+*
+* \param h_Block  handle of the block
+* \retval TRUE    if the reference was added
+* \retval FALSE   if the block is not allocated, or its count is saturated
+*/
+uint8_t esos_RetainMailBlock(ESOS_MAILBLOCK_HANDLE h_Block) {
+  uint8_t       u8_ok = FALSE;
+  uint32_t      u32_state;
+
+  if (h_Block < ESOS_MAIL_NUM_BLOCKS) {
+    __ESOS_ENTER_CRITICAL(u32_state);
+    if ((__au8_MailBlockRefs[h_Block] != 0) && (__au8_MailBlockRefs[h_Block] != 0xFF)) {
+      __au8_MailBlockRefs[h_Block]++;
+      u8_ok = TRUE;
+    }
+    __ESOS_EXIT_CRITICAL(u32_state);
+  }
+  return u8_ok;
+} // endof esos_RetainMailBlock()
+
+/**
+* Gives up a reference to a mail block.  The block returns to the pool
+* when its last reference is released.  The task that received a block
+* message holds a reference and must release it when done with its
+* contents.  A sender whose block message could not be sent still holds
+* its reference.  Messages flushed from a mailbox give up their
+* reference (see \ref ESOS_TASK_FLUSH_TASK_MAILBOX).
+*
+* \param h_Block  handle of the block to release
+* \retval TRUE    if a reference was given up
+* \retval FALSE   if the block holds no references (e.g. it was already
+*                 released), in which case nothing is changed
+*/
+uint8_t esos_ReleaseMailBlock(ESOS_MAILBLOCK_HANDLE h_Block) {
+  uint8_t       u8_refs;
+  uint32_t      u32_state;
+
+  if (h_Block >= ESOS_MAIL_NUM_BLOCKS)
+    return FALSE;
+  __ESOS_ENTER_CRITICAL(u32_state);
+  u8_refs = __au8_MailBlockRefs[h_Block];
+  if (u8_refs != 0)
+    __au8_MailBlockRefs[h_Block] = u8_refs-1;
+  __ESOS_EXIT_CRITICAL(u32_state);
+  // a second release of a free block must not free it again
+  if (u8_refs == 0)
+    return FALSE;
+  // last reference gone, so give the block back
+  if (u8_refs == 1)
+    esos_ReleasePoolBlock( &__st_MailBlockPool, h_Block );
+  return TRUE;
+} // endof esos_ReleaseMailBlock()
+
+/**
+* \retval N  number of mail blocks available for allocation
+*/
+uint8_t esos_GetNumFreeMailBlocks(void) {
+  return ESOS_POOL_GET_NUM_FREE( &__st_MailBlockPool );
+} // endof esos_GetNumFreeMailBlocks()
+
+/**
+* Computes the number of bytes occupied by a message's data payload.
+*
+* \param pst_Msg        pointer to mailbox message structure
+* \retval N             number of payload bytes
+* \hideinitializer
+*/
+uint16_t __esos_GetMailMessagePayloadLength(MAILMESSAGE* pst_Msg ) {
+  // zero-copy messages carry only the block handle (and the topic
+  //   number, if published to a topic)
+  if ( ESOS_GET_PMSG_FLAGS(pst_Msg) & ESOS_MAILMESSAGE_BLOCK) {
+    if ( ESOS_GET_PMSG_FLAGS(pst_Msg) & ESOS_MAILMESSAGE_TOPIC)
+      return sizeof(ESOS_MAILBLOCK_HANDLE)+sizeof(uint8_t);
+    return sizeof(ESOS_MAILBLOCK_HANDLE);
+  }
+  // element counts this large can never fit in the contents.  Report
+  //   "one byte too many" rather than risk overflowing the scaling below
+  if ( ESOS_GET_PMSG_DATA_LENGTH(pst_Msg) > __MAIL_MSG_MAX_DATA_LEN )
+    return __MAIL_MSG_MAX_DATA_LEN+1;
   if ( ESOS_GET_PMSG_FLAGS(pst_Msg) & ESOS_MAILMESSAGE_UINT8) {
-    for (u8_i=0; u8_i<ESOS_GET_PMSG_DATA_LENGTH(pst_Msg); u8_i++) {
-      __esos_CB_WriteUINT8( pst_RcvrTask->pst_Mailbox->pst_CBuffer, pst_Msg->au8_Contents[u8_i] );
-    } // end for UINT8s
+    return ESOS_GET_PMSG_DATA_LENGTH(pst_Msg);
   } else if ( ESOS_GET_PMSG_FLAGS(pst_Msg) & ESOS_MAILMESSAGE_UINT16) {
-    for (u8_i=0; u8_i<pst_Msg->u8_DataLength; u8_i++) {
-      __esos_CB_WriteUINT16( pst_RcvrTask->pst_Mailbox->pst_CBuffer, pst_Msg->au16_Contents[u8_i] );
-    } // end for UINT16s
+    return ESOS_GET_PMSG_DATA_LENGTH(pst_Msg) * sizeof(uint16_t);
   } else if ( ESOS_GET_PMSG_FLAGS(pst_Msg) & ESOS_MAILMESSAGE_UINT32) {
-    for (u8_i=0; u8_i<pst_Msg->u8_DataLength; u8_i++) {
-      __esos_CB_WriteUINT32( pst_RcvrTask->pst_Mailbox->pst_CBuffer, pst_Msg->au32_Contents[u8_i] );
-    } // end for UINT32s
+    return ESOS_GET_PMSG_DATA_LENGTH(pst_Msg) * sizeof(uint32_t);
   } else {
-  } // end for STRINGs
-} // endof __esos_SendMailMessage()
+    // STRINGs are sent as bytes
+    return ESOS_GET_PMSG_DATA_LENGTH(pst_Msg);
+  }
+} // endof __esos_GetMailMessagePayloadLength()
 
 /**
-* Reads the next (oldest) waiting message from a task's mailbox.
+* Computes the number of mailbox bytes a message will occupy once sent
+* (header plus data payload).
 *
-* \param pstTask  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be written
-* \param pstMsg   pointer to mailbox message structure that contains data to write to the task's mailbox
-* \note This function <em>ASSUMES</em> that there is ample free space available in specified
-* mailbox.
+* \param pst_Msg        pointer to mailbox message structure
+* \retval N             number of bytes in the message frame
+* \hideinitializer
+*/
+uint16_t __esos_GetMailMessageFrameLength(MAILMESSAGE* pst_Msg ) {
+  return __esos_GetMailMessageHeaderLength(pst_Msg) + __esos_GetMailMessagePayloadLength(pst_Msg);
+} // endof __esos_GetMailMessageFrameLength()
+
+/**
+* Computes the number of mailbox bytes taken by a message's header.
+* RPC requests carry their call ID right after the usual header.
+*
+* \param pst_Msg        pointer to mailbox message structure
+* \retval N             number of bytes in the message header
+*/
+uint16_t __esos_GetMailMessageHeaderLength(MAILMESSAGE* pst_Msg ) {
+  if ( ESOS_GET_PMSG_FLAGS(pst_Msg) & ESOS_MAILMESSAGE_RPC_REQUEST)
+    return __MAIL_MSG_HEADER_LEN + sizeof(uint16_t);
+  return __MAIL_MSG_HEADER_LEN;
+} // endof __esos_GetMailMessageHeaderLength()
+
+/**
+* Writes a message with the given postmark into a mailbox's circular
+* buffer, or leaves the buffer untouched if the message does not fit.
+*
+* \param pst_Mailbox    pointer to the mailbox
+* \param pst_Msg        pointer to mailbox message structure to write
+* \param u32_Postmark   ESOS tick timestamp to put on the message
+* \retval TRUE          if the message was written
+* \retval FALSE         if the message does not fit, or is malformed
+*/
+uint8_t __esos_PostMailMessage(MAILBOX* pst_Mailbox, MAILMESSAGE* pst_Msg, uint32_t u32_Postmark ) {
+  uint8_t               au8_Header[__MAIL_MSG_HEADER_LEN+sizeof(uint16_t)];
+  uint16_t              u16_HeaderLen, u16_PayloadLen;
+  uint32_t              u32_IrqState;
+  CBUFFER*              pst_CB;
+
+  pst_CB = pst_Mailbox->pst_CBuffer;
+  // payload must fit in the MAILMESSAGE contents
+  u16_HeaderLen = __esos_GetMailMessageHeaderLength(pst_Msg);
+  u16_PayloadLen = __esos_GetMailMessagePayloadLength(pst_Msg);
+  if (u16_PayloadLen > __MAIL_MSG_MAX_DATA_LEN) {
+#ifdef ESOS_USE_MAIL_STATS
+    __ESOS_ENTER_CRITICAL(u32_IrqState);
+    pst_Mailbox->st_Stats.u32_NumRejected++;
+    __ESOS_EXIT_CRITICAL(u32_IrqState);
+#endif
+    return FALSE;
+  }
+
+  // first message btye:  flags
+  au8_Header[0] = pst_Msg->u8_flags;
+  // second message word: data payload length
+  au8_Header[1] = (uint8_t) ESOS_GET_PMSG_DATA_LENGTH(pst_Msg);
+  au8_Header[2] = (uint8_t) (ESOS_GET_PMSG_DATA_LENGTH(pst_Msg)>>8);
+  // third message word: Task ID of sending task
+  au8_Header[3] = (uint8_t) ESOS_GET_PMSG_FROMTASK(pst_Msg);
+  au8_Header[4] = (uint8_t) (ESOS_GET_PMSG_FROMTASK(pst_Msg)>>8);
+  // Now, timestamp the message with double word
+  au8_Header[5] = (uint8_t) u32_Postmark;
+  au8_Header[6] = (uint8_t) (u32_Postmark>>8);
+  au8_Header[7] = (uint8_t) (u32_Postmark>>16);
+  au8_Header[8] = (uint8_t) (u32_Postmark>>24);
+  // RPC requests also carry the call ID
+  au8_Header[9] = (uint8_t) pst_Msg->u16_CallID;
+  au8_Header[10] = (uint8_t) (pst_Msg->u16_CallID>>8);
+
+  // ISRs may post mail too, so check for room and write the message
+  //   in one critical section.  The message is written whole or not at
+  //   all.  The contents union already holds UINT16s and UINT32s
+  //   little-endian, which is the order the mailbox uses.
+  __ESOS_ENTER_CRITICAL(u32_IrqState);
+  if (!__ESOS_CB_IS_AVAILABLE_AT_LEAST(pst_CB, u16_HeaderLen+u16_PayloadLen)) {
+#ifdef ESOS_USE_MAIL_STATS
+    pst_Mailbox->st_Stats.u32_NumRejected++;
+#endif
+    __ESOS_EXIT_CRITICAL(u32_IrqState);
+    return FALSE;
+  }
+  __esos_CB_WriteUINT8Frame( pst_CB, au8_Header, u16_HeaderLen );
+  __esos_CB_WriteUINT8Frame( pst_CB, pst_Msg->au8_Contents, u16_PayloadLen );
+#ifdef ESOS_USE_MAIL_STATS
+  pst_Mailbox->st_Stats.u32_NumSent++;
+  if (__ESOS_CB_GET_COUNT(pst_CB) > pst_Mailbox->st_Stats.u16_MaxBytes)
+    pst_Mailbox->st_Stats.u16_MaxBytes = __ESOS_CB_GET_COUNT(pst_CB);
+#endif
+  __ESOS_EXIT_CRITICAL(u32_IrqState);
+  return TRUE;
+} // endof __esos_PostMailMessage()
+
+/**
+* Writes a message to a task's mailbox from an interrupt service routine.
+* Never blocks: if the mailbox does not have room, the message is dropped
+* and FALSE is returned right away.  On delivery, the receiving task is
+* woken up if it is sleeping.  Use \ref ESOS_TASK_SLEEP_ON_MAIL in the
+* receiver: a task that checks its mailbox and then calls
+* \ref ESOS_TASK_SLEEP can go to sleep just after this wake-up and miss it.
+*
+* The message is marked as coming from \ref ESOS_MAIL_FROM_ISR.  An ISR
+* cannot wait for a delivery confirmation or an RPC reply, so those flags
+* are cleared.  The ESOS_TASK_MAKE_MSG_xxx macros need a task, so an ISR
+* fills in the message with ESOS_SET_MSG_FLAGS, ESOS_SET_MSG_DATA_LENGTH
+* and the contents directly.
+*
+* \param pst_RcvrTask  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be written
+* \param pst_Msg        pointer to mailbox message structure that contains data to write to the task's mailbox
+* \retval TRUE          if the message was delivered into the mailbox
+* \retval FALSE         if the mailbox does not have room for the message, or the message is malformed
 *
-* \sa ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_SPACE
+* \sa ESOS_ISR_SEND_MESSAGE
+*/
+uint8_t esos_SendMailMessageFromISR(ESOS_TASK_HANDLE pst_RcvrTask, MAILMESSAGE* pst_Msg ) {
+  uint32_t              u32_IrqState;
+
+  pst_Msg->u8_flags &= ~(ESOS_MAILMESSAGE_REQUEST_ACK | ESOS_MAILMESSAGE_RPC_REQUEST);
+  pst_Msg->u16_FromTaskID = ESOS_MAIL_FROM_ISR;
+  if (!__esos_PostMailMessage( pst_RcvrTask->pst_Mailbox, pst_Msg, esos_GetSystemTick() ))
+    return FALSE;
+  // a higher-priority ISR may be updating the same task's flags.  This
+  //   does not protect a task-side flag update that we interrupted, so
+  //   the wake-up alone is not reliable: ESOS_TASK_SLEEP_ON_MAIL also
+  //   re-checks the mailbox, which always holds the delivered message
+  __ESOS_ENTER_CRITICAL(u32_IrqState);
+  ESOS_WAKE_TASK(pst_RcvrTask);
+  __ESOS_EXIT_CRITICAL(u32_IrqState);
+  return TRUE;
+} // endof esos_SendMailMessageFromISR()
+
+/**
+* Writes message data to a task's mailbox.
+*
+* The entire message (header and payload) is checked for room first and
+* then copied into the mailbox.  Either the whole message is delivered,
+* or the mailbox is not touched at all.
+*
+* \param pst_RcvrTask  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be written
+* \param pst_Msg        pointer to mailbox message structure that contains data to write to the task's mailbox
+* \retval TRUE          if the message was delivered into the mailbox
+* \retval FALSE         if the mailbox does not have room for the message, or the message is malformed
+*
+* \sa ESOS_TASK_WAIT_ON_TASKS_MAILBOX_HAS_ROOM_MESSAGE
+* \sa ESOS_TASK_WAIT_ON_SEND_MESSAGE
 * \hideinitializer
 */
-void __esos_ReadMailMessage(ESOS_TASK_HANDLE pst_Task, MAILMESSAGE* pst_Message ) {
+uint8_t __esos_SendMailMessage(ESOS_TASK_HANDLE pst_RcvrTask, MAILMESSAGE* pst_Msg ) {
+  return __esos_PostMailMessage( pst_RcvrTask->pst_Mailbox, pst_Msg, esos_GetSystemTick() );
+} // endof __esos_SendMailMessage()
+
+/**
+* Moves a task's delivery-confirmed send along: sends the message once
+* the recipient's mailbox has room, then waits for the recipient to read
+* it.  The sender's MAILSENT flag records that the message has gone out.
+*
+* \param pst_Task      pointer to task structure (ESOS_TASK_HANDLE) of the sender
+* \param pst_ToTask    pointer to task structure (ESOS_TASK_HANDLE) of the recipient
+* \param pst_Msg       pointer to the message to send
+* \retval TRUE         if the recipient has read the message
+* \retval FALSE        if the sender must keep waiting
+* \sa ESOS_TASK_WAIT_ON_DELIVERY
+*/
+uint8_t __esos_PollMailDelivery(ESOS_TASK_HANDLE pst_Task, ESOS_TASK_HANDLE pst_ToTask, MAILMESSAGE* pst_Msg ) {
+  if (!__ESOS_IS_TASK_MAILSENT( pst_Task )) {
+    // the recipient may read it (and ACK) at once, so flag the wait first
+    __ESOS_SET_TASK_MAILNACK_FLAG( pst_Task );
+    if (__esos_SendMailMessage(pst_ToTask, pst_Msg)) {
+      __ESOS_SET_TASK_MAILSENT_FLAG( pst_Task );
+    } else {
+      __ESOS_CLEAR_TASK_MAILNACK_FLAG( pst_Task );
+    }
+    return FALSE;
+  }
+  if (ESOS_TASK_IS_WAITING_MAIL_DELIVERY( pst_Task ))
+    return FALSE;
+  __ESOS_CLEAR_TASK_MAILSENT_FLAG( pst_Task );
+  return TRUE;
+} // endof __esos_PollMailDelivery()
+
+/**
+* Writes a batch of messages to a task's mailbox.  Messages are sent in
+* order and all carry the same postmark.  Sending stops at the first
+* message that does not fit, so the recipient always receives a prefix
+* of the batch with no gaps.  Each message is still all-or-nothing.
+*
+* \param pst_RcvrTask  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be written
+* \param pst_Msgs       pointer to an array of messages to send
+* \param u8_Count       number of messages in the array
+* \retval N             number of messages delivered (from the start of the array)
+*
+* \sa ESOS_TASK_SEND_MESSAGES
+* \sa ESOS_TASK_WAIT_ON_SEND_MESSAGES
+*/
+uint8_t __esos_SendMailMessages(ESOS_TASK_HANDLE pst_RcvrTask, MAILMESSAGE* pst_Msgs, uint8_t u8_Count ) {
   uint8_t               u8_i;
-  ESOS_TASK_HANDLE      pst_From;
+  uint32_t              u32_Postmark;
+  MAILBOX*              pst_Mailbox;
+
+  pst_Mailbox = pst_RcvrTask->pst_Mailbox;
+  u32_Postmark = esos_GetSystemTick();
+  for (u8_i=0; u8_i<u8_Count; u8_i++) {
+    if (!__esos_PostMailMessage( pst_Mailbox, &pst_Msgs[u8_i], u32_Postmark ))
+      break;
+  }
+  return u8_i;
+} // endof __esos_SendMailMessages()
+
+/**
+* Computes the number of mailbox bytes a batch of messages will occupy
+* once sent.
+*
+* \param pst_Msgs       pointer to an array of messages
+* \param u8_Count       number of messages in the array
+* \retval N             number of bytes in all the message frames
+*/
+uint16_t __esos_GetMailMessagesFrameLength(MAILMESSAGE* pst_Msgs, uint8_t u8_Count ) {
+  uint8_t               u8_i;
+  uint16_t              u16_Len = 0;
 
-  /* first message btye:  flags in upper nibble, payload length in lower */
-  u8_i = __esos_CB_ReadUINT8( pst_Task->pst_Mailbox->pst_CBuffer );
-  pst_Message->u8_flags = u8_i>>4;
-  pst_Message->u8_DataLength = u8_i & 0x0F;
-  /* second message byte: Task ID of sending task */
-  pst_Message->u16_FromTaskID = __esos_CB_ReadUINT16( pst_Task->pst_Mailbox->pst_CBuffer );
+  for (u8_i=0; u8_i<u8_Count; u8_i++) {
+    u16_Len += __esos_GetMailMessageFrameLength( &pst_Msgs[u8_i] );
+  }
+  return u16_Len;
+} // endof __esos_GetMailMessagesFrameLength()
+
+/**
+* Decodes the header of the message that starts u16_Offset bytes into a
+* mailbox, and checks that the entire message is really there.  The
+* payload is not touched.
+*
+* \param pst_CB        pointer to the mailbox circular buffer
+* \param u16_Offset    offset (from the oldest byte) of the message
+* \param pst_Message   pointer to mailbox message structure that receives the header fields
+* \retval N            length of the message frame (header and payload)
+* \retval 0            if the mailbox does not hold a whole, valid message at u16_Offset
+*/
+uint16_t __esos_ParseMailHeader(CBUFFER* pst_CB, uint16_t u16_Offset, MAILMESSAGE* pst_Message ) {
+  uint8_t               au8_Header[__MAIL_MSG_HEADER_LEN+sizeof(uint16_t)];
+  uint16_t              u16_HeaderLen, u16_PayloadLen;
+
+  if ((__ESOS_CB_GET_COUNT(pst_CB) - u16_Offset) < __MAIL_MSG_HEADER_LEN)
+    return 0;
+  /* first message btye:  flags, then payload length word */
+  __esos_CB_PeekUINT8Buffer( pst_CB, u16_Offset, au8_Header, __MAIL_MSG_HEADER_LEN );
+  pst_Message->u8_flags = au8_Header[0];
+  pst_Message->u16_DataLength = ((uint16_t) au8_Header[1]) + (((uint16_t) au8_Header[2])<<8);
+  u16_HeaderLen = __esos_GetMailMessageHeaderLength(pst_Message);
+  u16_PayloadLen = __esos_GetMailMessagePayloadLength(pst_Message);
+  /* make sure the entire message is really there */
+  if ((u16_PayloadLen > __MAIL_MSG_MAX_DATA_LEN) ||
+      ((__ESOS_CB_GET_COUNT(pst_CB) - u16_Offset) < (u16_HeaderLen+u16_PayloadLen)))
+    return 0;
+  /* third message word: Task ID of sending task */
+  pst_Message->u16_FromTaskID = ((uint16_t) au8_Header[3]) + (((uint16_t) au8_Header[4])<<8);
   /* Now, timestamp the message */
-  pst_Message->u32_Postmark = __esos_CB_ReadUINT32( pst_Task->pst_Mailbox->pst_CBuffer );
-  /* Now write the data depending on what type and how many */
-  if ( ESOS_GET_PMSG_FLAGS(pst_Message) & ESOS_MAILMESSAGE_UINT8) {
-    for (u8_i=0; u8_i<ESOS_GET_PMSG_DATA_LENGTH(pst_Message); u8_i++) {
-      pst_Message->au8_Contents[u8_i] = __esos_CB_ReadUINT8( pst_Task->pst_Mailbox->pst_CBuffer );
-    } // end for UINT8s
-  } else if ( ESOS_GET_PMSG_FLAGS(pst_Message) & ESOS_MAILMESSAGE_UINT16) {
-    for (u8_i=0; u8_i<pst_Message->u8_DataLength; u8_i++) {
-      pst_Message->au16_Contents[u8_i] = __esos_CB_ReadUINT16( pst_Task->pst_Mailbox->pst_CBuffer );
-    } // end for UINT16s
-  } else if ( ESOS_GET_PMSG_FLAGS(pst_Message) & ESOS_MAILMESSAGE_UINT32) {
-    for (u8_i=0; u8_i<pst_Message->u8_DataLength; u8_i++) {
-      pst_Message->au32_Contents[u8_i] = __esos_CB_ReadUINT32( pst_Task->pst_Mailbox->pst_CBuffer );
-    } // end for UINT32s
-  } else {
-  } // end strings
+  pst_Message->u32_Postmark = ((uint32_t) au8_Header[5]) + (((uint32_t) au8_Header[6])<<8) +
+                              (((uint32_t) au8_Header[7])<<16) + (((uint32_t) au8_Header[8])<<24);
+  /* RPC requests carry their call ID after the header */
+  if (u16_HeaderLen > __MAIL_MSG_HEADER_LEN) {
+    __esos_CB_PeekUINT8Buffer( pst_CB, u16_Offset+__MAIL_MSG_HEADER_LEN, &au8_Header[9], sizeof(uint16_t) );
+    pst_Message->u16_CallID = ((uint16_t) au8_Header[9]) + (((uint16_t) au8_Header[10])<<8);
+  }
+  return u16_HeaderLen+u16_PayloadLen;
+} // endof __esos_ParseMailHeader()
+
+/**
+* Confirms delivery of a message to its sender, if the sender asked.
+*/
+void __esos_AckMailMessage(MAILMESSAGE* pst_Message ) {
+  ESOS_TASK_HANDLE      pst_From;
+
   /* If sending task requests ACK a.k.a. "delivery confirmation, then do it */
   if ( ESOS_GET_PMSG_FLAGS(pst_Message) & ESOS_MAILMESSAGE_REQUEST_ACK) {
     pst_From = esos_GetTaskHandleFromID( ESOS_GET_PMSG_FROMTASK(pst_Message) );
@@ -129,7 +568,410 @@ void __esos_ReadMailMessage(ESOS_TASK_HANDLE pst_Task, MAILMESSAGE* pst_Message
       __ESOS_CLEAR_TASK_MAILNACK_FLAG( pst_From );
     } // end if ! NULLPTR
   } //end if
+} // endof __esos_AckMailMessage()
+
+/**
+* Removes bytes from a mailbox.  ISRs may be appending mail at the same
+* time, so this is done in a critical section.
+*
+* \param pst_CB        pointer to the mailbox circular buffer
+* \param u16_Offset    offset of the first byte to remove
+* \param u16_Len       number of bytes to remove
+*/
+void __esos_DiscardMailFrame(CBUFFER* pst_CB, uint16_t u16_Offset, uint16_t u16_Len ) {
+  uint32_t              u32_IrqState;
+
+  __ESOS_ENTER_CRITICAL(u32_IrqState);
+  if (u16_Offset == 0) {
+    __ESOS_CB_DISCARD( pst_CB, u16_Len );
+  } else {
+    __esos_CB_RemoveUINT8Span( pst_CB, u16_Offset, u16_Len );
+  }
+  __ESOS_EXIT_CRITICAL(u32_IrqState);
+} // endof __esos_DiscardMailFrame()
+
+/**
+* Empties a mailbox.  Zero-copy messages in the mailbox give up the block
+* reference they hold, so their blocks can return to the pool.  Mail that
+* an ISR adds while the mailbox is being flushed is kept.
+*
+* \param pst_Mailbox  pointer to the mailbox to flush
+* \sa ESOS_TASK_FLUSH_TASK_MAILBOX
+*/
+void __esos_FlushMailbox(MAILBOX* pst_Mailbox ) {
+  uint16_t              u16_Offset, u16_Count, u16_FrameLen;
+  ESOS_MAILBLOCK_HANDLE h_Block;
+  CBUFFER*              pst_CB;
+
+  pst_CB = pst_Mailbox->pst_CBuffer;
+  u16_Count = __ESOS_CB_GET_COUNT(pst_CB);
+  u16_Offset = 0;
+  while (u16_Offset < u16_Count) {
+    u16_FrameLen = __esos_ParseMailHeader( pst_CB, u16_Offset, &__st_MailFilterScratch );
+    if (u16_FrameLen == 0)
+      break;
+    if (ESOS_GET_MSG_FLAGS(__st_MailFilterScratch) & ESOS_MAILMESSAGE_BLOCK) {
+      __esos_CB_PeekUINT8Buffer( pst_CB, u16_Offset+__esos_GetMailMessageHeaderLength(&__st_MailFilterScratch),
+                                 &h_Block, sizeof(h_Block) );
+      esos_ReleaseMailBlock( h_Block );
+    }
+    u16_Offset += u16_FrameLen;
+  } // end while
+  if (u16_Count)
+    __esos_DiscardMailFrame( pst_CB, 0, u16_Count );
+} // endof __esos_FlushMailbox()
+
+/**
+* Reads the next (oldest) waiting message from a task's mailbox.
+*
+* The message header is validated against the amount of data in the
+* mailbox before anything is consumed.  Since messages are always
+* written whole, an inconsistent mailbox can only mean corruption.  In
+* that case, the mailbox is flushed so that later reads re-synchronize.
+*
+* \param pst_Task  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be read
+* \param pst_Message   pointer to mailbox message structure that will receive the message
+* \retval TRUE     if a message was read into pst_Message
+* \retval FALSE    if the mailbox was empty (or corrupt and has been flushed)
+*
+* \sa ESOS_TASK_GET_NEXT_MESSAGE
+* \hideinitializer
+*/
+uint8_t __esos_ReadMailMessage(ESOS_TASK_HANDLE pst_Task, MAILMESSAGE* pst_Message ) {
+  if (!__esos_PeekMailMessage( pst_Task, pst_Message ))
+    return FALSE;
+  /* consume the whole message at once */
+  __esos_DiscardMailFrame( pst_Task->pst_Mailbox->pst_CBuffer, 0, __esos_GetMailMessageFrameLength(pst_Message) );
+#ifdef ESOS_USE_MAIL_STATS
+  __esos_RecordMailRead( pst_Task->pst_Mailbox, pst_Message );
+#endif
+  __esos_AckMailMessage( pst_Message );
+  return TRUE;
 } // __esos_ReadMailMessage()
 
+/**
+* Copies the next (oldest) waiting message from a task's mailbox without
+* removing it.  The sender is not sent a delivery confirmation.
+*
+* \param pst_Task  pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be read
+* \param pst_Message   pointer to mailbox message structure that will receive the message
+* \retval TRUE     if a message was copied into pst_Message
+* \retval FALSE    if the mailbox was empty (or corrupt and has been flushed)
+*
+* \sa ESOS_TASK_PEEK_NEXT_MESSAGE
+*/
+uint8_t __esos_PeekMailMessage(ESOS_TASK_HANDLE pst_Task, MAILMESSAGE* pst_Message ) {
+  uint16_t              u16_FrameLen;
+  CBUFFER*              pst_CB;
+
+  pst_CB = pst_Task->pst_Mailbox->pst_CBuffer;
+  if (__ESOS_CB_IS_EMPTY(pst_CB))
+    return FALSE;
+  u16_FrameLen = __esos_ParseMailHeader( pst_CB, 0, pst_Message );
+  if (u16_FrameLen == 0) {
+    __esos_DiscardMailFrame( pst_CB, 0, __ESOS_CB_GET_COUNT(pst_CB) );
+    return FALSE;
+  }
+  /* Now the data */
+  __esos_CB_PeekUINT8Buffer( pst_CB, __esos_GetMailMessageHeaderLength(pst_Message), pst_Message->au8_Contents,
+                             __esos_GetMailMessagePayloadLength(pst_Message) );
+  return TRUE;
+} // endof __esos_PeekMailMessage()
+
+/**
+* Finds the oldest message in a task's mailbox that passes a filter.
+* The search hops from header to header using the length in each
+* header, so the payloads of messages that are skipped are never read
+* (except for their first byte, when filtering on type).
+*
+* \param pst_Task    pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be searched
+* \param pst_Filter  pointer to the filter
+* \param pst_Header  pointer to mailbox message structure that receives the matching
+*                    message's header fields
+* \retval offset     offset of the matching message in the mailbox
+* \retval __MAIL_MSG_NOT_FOUND  if no message passes the filter
+*/
+uint16_t __esos_FindMailMessage(ESOS_TASK_HANDLE pst_Task, MAILFILTER* pst_Filter, MAILMESSAGE* pst_Header ) {
+  uint16_t              u16_Offset = 0;
+  uint16_t              u16_FrameLen;
+  uint8_t               u8_Type;
+  CBUFFER*              pst_CB;
+
+  pst_CB = pst_Task->pst_Mailbox->pst_CBuffer;
+  while (u16_Offset < __ESOS_CB_GET_COUNT(pst_CB)) {
+    u16_FrameLen = __esos_ParseMailHeader( pst_CB, u16_Offset, pst_Header );
+    if (u16_FrameLen == 0) {
+      __esos_DiscardMailFrame( pst_CB, 0, __ESOS_CB_GET_COUNT(pst_CB) );
+      return __MAIL_MSG_NOT_FOUND;
+    }
+    if ((!(pst_Filter->u8_Fields & ESOS_MAILFILTER_FROM) || (pst_Header->u16_FromTaskID == pst_Filter->u16_FromTaskID)) &&
+        (!(pst_Filter->u8_Fields & ESOS_MAILFILTER_FLAGS) || ((pst_Header->u8_flags & pst_Filter->u8_FlagsMask) == pst_Filter->u8_FlagsValue))) {
+      if (!(pst_Filter->u8_Fields & ESOS_MAILFILTER_TYPE))
+        return u16_Offset;
+      if (u16_FrameLen > __esos_GetMailMessageHeaderLength(pst_Header)) {
+        __esos_CB_PeekUINT8Buffer( pst_CB, u16_Offset+__esos_GetMailMessageHeaderLength(pst_Header), &u8_Type, 1 );
+        if (u8_Type == pst_Filter->u8_Type)
+          return u16_Offset;
+      } // end if
+    } // end if
+    u16_Offset += u16_FrameLen;
+  } // end while
+  return __MAIL_MSG_NOT_FOUND;
+} // endof __esos_FindMailMessage()
+
+/**
+* Reads (and removes) the oldest message in a task's mailbox that passes
+* a filter.  Messages in front of it stay in the mailbox, in order.
+*
+* \param pst_Task    pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be read
+* \param pst_Filter  pointer to the filter
+* \param pst_Message pointer to mailbox message structure that will receive the message
+* \retval TRUE       if a matching message was read into pst_Message
+* \retval FALSE      if no message passes the filter
+*
+* \sa ESOS_TASK_GET_MATCHING_MESSAGE
+*/
+uint8_t __esos_ReadMatchingMailMessage(ESOS_TASK_HANDLE pst_Task, MAILFILTER* pst_Filter, MAILMESSAGE* pst_Message ) {
+  uint16_t              u16_Offset, u16_FrameLen;
+  CBUFFER*              pst_CB;
+
+  u16_Offset = __esos_FindMailMessage( pst_Task, pst_Filter, pst_Message );
+  if (u16_Offset == __MAIL_MSG_NOT_FOUND)
+    return FALSE;
+  pst_CB = pst_Task->pst_Mailbox->pst_CBuffer;
+  u16_FrameLen = __esos_GetMailMessageFrameLength(pst_Message);
+  __esos_CB_PeekUINT8Buffer( pst_CB, u16_Offset+__esos_GetMailMessageHeaderLength(pst_Message), pst_Message->au8_Contents,
+                             __esos_GetMailMessagePayloadLength(pst_Message) );
+  __esos_DiscardMailFrame( pst_CB, u16_Offset, u16_FrameLen );
+#ifdef ESOS_USE_MAIL_STATS
+  __esos_RecordMailRead( pst_Task->pst_Mailbox, pst_Message );
+#endif
+  __esos_AckMailMessage( pst_Message );
+  return TRUE;
+} // endof __esos_ReadMatchingMailMessage()
+
+/**
+* Reads every message waiting in a task's mailbox, up to u8_Max of them,
+* into an array in one pass.  Messages are read oldest first.
+*
+* \param pst_Task      pointer to task structure (ESOS_TASK_HANDLE) whose mailbox will be read
+* \param pst_Msgs      pointer to an array of at least u8_Max messages
+* \param u8_Max        most messages to read
+* \retval N            number of messages read into the array
+*
+* \sa ESOS_TASK_GET_MESSAGES
+*/
+uint8_t __esos_ReadMailMessages(ESOS_TASK_HANDLE pst_Task, MAILMESSAGE* pst_Msgs, uint8_t u8_Max ) {
+  uint8_t               u8_i;
+
+  for (u8_i=0; u8_i<u8_Max; u8_i++) {
+    if (!__esos_ReadMailMessage( pst_Task, &pst_Msgs[u8_i] ))
+      break;
+  }
+  return u8_i;
+} // endof __esos_ReadMailMessages()
+
+/**
+* Clears the table of outstanding RPC calls.  Called once by ESOS at startup.
+*/
+void __esos_InitRpcCalls(void) {
+  uint8_t     u8_i;
+
+  for (u8_i=0; u8_i<MAX_NUM_USER_TASKS; u8_i++) {
+    __astRpcCalls[u8_i].u16_CallID = 0;
+    __astRpcCalls[u8_i].pst_Reply = NULLPTR;
+    __astRpcCalls[u8_i].u8_Sent = FALSE;
+    __astRpcCalls[u8_i].u8_GotReply = FALSE;
+  }
+  __u16_RpcLastCallID = 0;
+} // endof __esos_InitRpcCalls()
+
+/**
+* Finds the RPC call slot of a task.  Only tasks in the user task pool
+* have one, so child tasks cannot make RPC calls.
+*
+* \param pst_Task      pointer to task structure (ESOS_TASK_HANDLE)
+* \retval ptr          pointer to the task's RPC call slot
+* \retval NULLPTR      if the task is not in the user task pool
+*/
+MAILRPCCALL* __esos_GetRpcCall(ESOS_TASK_HANDLE pst_Task ) {
+  if (!__ESOS_IS_USER_TASK_HANDLE(pst_Task))
+    return NULLPTR;
+  return &__astRpcCalls[pst_Task - __astUserTaskPool];
+} // endof __esos_GetRpcCall()
+
+/**
+* Starts an RPC call for a task: gives the request a fresh call ID, marks
+* it as an RPC request, and registers where the reply should go.
+*
+* \param pst_Task      pointer to task structure (ESOS_TASK_HANDLE) of the caller
+* \param pst_Request   pointer to the request message
+* \param pst_Reply     pointer to the message structure that will receive the reply
+* \note Tasks outside the user task pool get no call started, and their
+* call ends at once without a reply.
+* \sa ESOS_TASK_WAIT_ON_RPC_CALL
+*/
+void __esos_BeginRpcCall(ESOS_TASK_HANDLE pst_Task, MAILMESSAGE* pst_Request, MAILMESSAGE* pst_Reply ) {
+  MAILRPCCALL*      pst_Call;
+
+  pst_Call = __esos_GetRpcCall(pst_Task);
+  if (pst_Call == NULLPTR)
+    return;
+  // call ID 0 is never used, so a cleared slot never matches a reply
+  if (++__u16_RpcLastCallID == 0) __u16_RpcLastCallID = 1;
+  pst_Request->u8_flags |= ESOS_MAILMESSAGE_RPC_REQUEST;
+  pst_Request->u16_CallID = __u16_RpcLastCallID;
+  pst_Call->u16_CallID = __u16_RpcLastCallID;
+  pst_Call->pst_Reply = pst_Reply;
+  pst_Call->u8_Sent = FALSE;
+  pst_Call->u8_GotReply = FALSE;
+} // endof __esos_BeginRpcCall()
+
+/**
+* Moves a task's RPC call along: sends the request once the server's
+* mailbox has room, then watches for the reply.  The timeout is kept in
+* the caller's u32_savedTick/u32_waitLen, as for \ref ESOS_TASK_WAIT_TICKS.
+*
+* \param pst_Task      pointer to task structure (ESOS_TASK_HANDLE) of the caller
+* \param pst_ToTask    pointer to task structure (ESOS_TASK_HANDLE) of the server
+* \param pst_Request   pointer to the request message
+* \retval TRUE         if the call is over (replied to or timed out)
+* \retval FALSE        if the caller must keep waiting
+* \sa ESOS_TASK_WAIT_ON_RPC_CALL
+*/
+uint8_t __esos_PollRpcCall(ESOS_TASK_HANDLE pst_Task, ESOS_TASK_HANDLE pst_ToTask, MAILMESSAGE* pst_Request ) {
+  MAILRPCCALL*      pst_Call;
 
+  pst_Call = __esos_GetRpcCall(pst_Task);
+  if (pst_Call == NULLPTR)
+    return TRUE;
+  if (!pst_Call->u8_Sent)
+    pst_Call->u8_Sent = __esos_SendMailMessage(pst_ToTask, pst_Request);
+  if (pst_Call->u8_GotReply)
+    return TRUE;
+  return __esos_hasTickDurationPassed(pst_Task->u32_savedTick, pst_Task->u32_waitLen);
+} // endof __esos_PollRpcCall()
+
+/**
+* Ends a task's RPC call, whether or not the reply came.  Replies that
+* arrive afterwards are dropped.
+*
+* \param pst_Task      pointer to task structure (ESOS_TASK_HANDLE) of the caller
+* \retval TRUE         if the reply arrived
+* \retval FALSE        if the call timed out
+*/
+uint8_t __esos_EndRpcCall(ESOS_TASK_HANDLE pst_Task ) {
+  MAILRPCCALL*      pst_Call;
+
+  pst_Call = __esos_GetRpcCall(pst_Task);
+  if (pst_Call == NULLPTR)
+    return FALSE;
+  pst_Call->u16_CallID = 0;
+  pst_Call->pst_Reply = NULLPTR;
+  return pst_Call->u8_GotReply;
+} // endof __esos_EndRpcCall()
+
+/**
+* Sends the reply to an RPC request straight to the calling task.  The
+* reply never enters the caller's mailbox.  It is copied into the reply
+* structure the caller is blocked on, so it cannot be confused with any
+* other mail and cannot be lost to a full mailbox.
+*
+* \param pst_Request   pointer to the request message being answered
+* \param pst_Reply     pointer to the reply message
+* \retval TRUE         if the caller got the reply
+* \retval FALSE        if the request is not an RPC request, or the caller
+*                      is gone or has given up (timed out) on this call
+* \sa ESOS_TASK_SEND_RPC_REPLY
+*/
+uint8_t esos_SendRpcReply(MAILMESSAGE* pst_Request, MAILMESSAGE* pst_Reply ) {
+  ESOS_TASK_HANDLE  pst_Caller;
+  MAILRPCCALL*      pst_Call;
+
+  if (!(ESOS_GET_PMSG_FLAGS(pst_Request) & ESOS_MAILMESSAGE_RPC_REQUEST))
+    return FALSE;
+  if (__esos_GetMailMessagePayloadLength(pst_Reply) > __MAIL_MSG_MAX_DATA_LEN)
+    return FALSE;
+  pst_Caller = esos_GetTaskHandleFromID( ESOS_GET_PMSG_FROMTASK(pst_Request) );
+  if (pst_Caller == NULLPTR)
+    return FALSE;
+  pst_Call = __esos_GetRpcCall(pst_Caller);
+  if ((pst_Call == NULLPTR) || (pst_Call->u16_CallID != pst_Request->u16_CallID) || (pst_Call->pst_Reply == NULLPTR) || pst_Call->u8_GotReply)
+    return FALSE;
+  // hand over the reply
+  *(pst_Call->pst_Reply) = *pst_Reply;
+  pst_Call->pst_Reply->u8_flags = (ESOS_GET_PMSG_FLAGS(pst_Reply) & ~ESOS_MAILMESSAGE_RPC_REQUEST) | ESOS_MAILMESSAGE_RPC_REPLY;
+  pst_Call->pst_Reply->u16_CallID = pst_Request->u16_CallID;
+  pst_Call->pst_Reply->u32_Postmark = esos_GetSystemTick();
+  pst_Call->u8_GotReply = TRUE;
+  return TRUE;
+} // endof esos_SendRpcReply()
+
+#ifdef ESOS_USE_MAIL_STATS
+/**
+* Counts a message as read and adds its postmark-to-read latency to the
+* mailbox's latency histogram.
+*
+* \param pst_Mailbox   pointer to the mailbox the message was read from
+* \param pst_Message   pointer to the message that was read
+*/
+void __esos_RecordMailRead(MAILBOX* pst_Mailbox, MAILMESSAGE* pst_Message ) {
+  uint32_t        u32_Latency;
+  uint8_t         u8_Bin = 0;
+
+  u32_Latency = esos_GetSystemTick() - pst_Message->u32_Postmark;
+  // bin is the number of significant bits in the latency
+  while (u32_Latency && (u8_Bin < ESOS_MAIL_STATS_NUM_BINS-1)) {
+    u32_Latency >>= 1;
+    u8_Bin++;
+  }
+  pst_Mailbox->st_Stats.u32_NumRead++;
+  pst_Mailbox->st_Stats.au32_Latency[u8_Bin]++;
+} // endof __esos_RecordMailRead()
+
+/**
+* Copies the statistics of a task's mailbox.  The counts are copied in one
+* critical section, so they agree with each other even if an ISR is
+* posting mail.  The number of bytes and messages waiting in the mailbox
+* right now are filled in too.
+*
+* \param pst_Task    pointer to task structure (ESOS_TASK_HANDLE) whose mailbox is examined
+* \param pst_Stats   pointer to MAILSTATS structure to receive the snapshot
+* \sa ESOS_TASK_GET_MAIL_STATS
+*/
+void esos_GetTaskMailStats(ESOS_TASK_HANDLE pst_Task, MAILSTATS* pst_Stats ) {
+  uint32_t        u32_IrqState;
+  uint16_t        u16_Offset = 0;
+  uint16_t        u16_FrameLen;
+  CBUFFER*        pst_CB;
+
+  pst_CB = pst_Task->pst_Mailbox->pst_CBuffer;
+  __ESOS_ENTER_CRITICAL(u32_IrqState);
+  *pst_Stats = pst_Task->pst_Mailbox->st_Stats;
+  pst_Stats->u16_NumBytes = __ESOS_CB_GET_COUNT(pst_CB);
+  __ESOS_EXIT_CRITICAL(u32_IrqState);
+  // count the messages by hopping from header to header.  Mail that
+  //   arrives meanwhile is past u16_NumBytes and is not counted.
+  pst_Stats->u16_NumMsgs = 0;
+  while (u16_Offset < pst_Stats->u16_NumBytes) {
+    u16_FrameLen = __esos_ParseMailHeader( pst_CB, u16_Offset, &__st_MailFilterScratch );
+    if (u16_FrameLen == 0) break;
+    pst_Stats->u16_NumMsgs++;
+    u16_Offset += u16_FrameLen;
+  } // end while
+} // endof esos_GetTaskMailStats()
+
+/**
+* Zeroes the statistics of a task's mailbox.
+*
+* \param pst_Task    pointer to task structure (ESOS_TASK_HANDLE) whose mailbox statistics are reset
+* \sa ESOS_TASK_RESET_MAIL_STATS
+*/
+void esos_ResetTaskMailStats(ESOS_TASK_HANDLE pst_Task ) {
+  uint32_t        u32_IrqState;
 
+  __ESOS_ENTER_CRITICAL(u32_IrqState);
+  memset( &pst_Task->pst_Mailbox->st_Stats, 0, sizeof(MAILSTATS) );
+  __ESOS_EXIT_CRITICAL(u32_IrqState);
+} // endof esos_ResetTaskMailStats()
+#endif    // ESOS_USE_MAIL_STATS
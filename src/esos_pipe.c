@@ -0,0 +1,243 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/** \file
+ * \brief Byte-stream pipes between ESOS32 tasks
+ *
+ */
+
+
+#include    "esos.h"
+#include    "esos_pipe.h"
+
+// ******** G L O B A L S ***************
+
+/****************************************************************
+** F U N C T I O N S
+****************************************************************/
+/**
+* Initializes an (empty) pipe.  The reader is woken as soon as there is
+* any data, and the writer as soon as there is any room.
+*
+* \param pst_Pipe       pointer to the pipe to initialize
+* \param pau8_Data      pointer to storage for the pipe
+* \param u16_Len        number of bytes of storage.  <em>MUST</em> be a power of two.
+* \sa ESOS_DECLARE_PIPE
+* \sa ESOS_INIT_PIPE
+*/
+void esos_InitPipe(PIPE* pst_Pipe, uint8_t* pau8_Data, uint16_t u16_Len) {
+  __esos_SPSC_Init( &pst_Pipe->st_Ring, pau8_Data, u16_Len );
+  pst_Pipe->u16_LowWater = u16_Len - 1;
+  pst_Pipe->u16_HighWater = 1;
+  pst_Pipe->pst_Reader = NULLPTR;
+  pst_Pipe->pst_Writer = NULLPTR;
+} // end esos_InitPipe()
+
+/**
+* Sets the watermarks of a pipe.
+*
+* \param pst_Pipe       pointer to the pipe
+* \param u16_LowWater   the writer is woken when a read leaves this many bytes or fewer
+* \param u16_HighWater  the reader is woken when a write leaves this many bytes or more
+*/
+void esos_SetPipeWatermarks(PIPE* pst_Pipe, uint16_t u16_LowWater, uint16_t u16_HighWater) {
+  pst_Pipe->u16_LowWater = u16_LowWater;
+  pst_Pipe->u16_HighWater = u16_HighWater;
+} // end esos_SetPipeWatermarks()
+
+/**
+* Sets the tasks that a pipe wakes (see \ref ESOS_WAKE_TASK) when it
+* crosses its watermarks.  Either may be NULLPTR.
+*
+* \param pst_Pipe       pointer to the pipe
+* \param pst_Reader     task to wake at the high watermark
+* \param pst_Writer     task to wake at the low watermark
+*/
+void esos_SetPipeTasks(PIPE* pst_Pipe, ESOS_TASK_HANDLE pst_Reader, ESOS_TASK_HANDLE pst_Writer) {
+  pst_Pipe->pst_Reader = pst_Reader;
+  pst_Pipe->pst_Writer = pst_Writer;
+} // end esos_SetPipeTasks()
+
+/**
+* Wakes the reader of a pipe if data was just written up to the high
+* watermark.
+*/
+void __esos_PipeWakeReader(PIPE* pst_Pipe) {
+  uint32_t            u32_state;
+
+  if ((pst_Pipe->pst_Reader != NULLPTR) && (ESOS_PIPE_GET_COUNT(pst_Pipe) >= pst_Pipe->u16_HighWater)) {
+    // a higher-priority ISR may be updating the same task's flags.  A
+    //   wake-up can still be lost to a task-side flag update, so readers
+    //   sleep with ESOS_TASK_SLEEP_ON_PIPE_HIGH_WATER, which re-checks
+    __ESOS_ENTER_CRITICAL(u32_state);
+    ESOS_WAKE_TASK(pst_Pipe->pst_Reader);
+    __ESOS_EXIT_CRITICAL(u32_state);
+  }
+} // end __esos_PipeWakeReader()
+
+/**
+* Wakes the writer of a pipe if data was just read down to the low
+* watermark.
+*/
+void __esos_PipeWakeWriter(PIPE* pst_Pipe) {
+  uint32_t            u32_state;
+
+  if ((pst_Pipe->pst_Writer != NULLPTR) && (ESOS_PIPE_GET_COUNT(pst_Pipe) <= pst_Pipe->u16_LowWater)) {
+    __ESOS_ENTER_CRITICAL(u32_state);
+    ESOS_WAKE_TASK(pst_Pipe->pst_Writer);
+    __ESOS_EXIT_CRITICAL(u32_state);
+  }
+} // end __esos_PipeWakeWriter()
+
+/**
+* Writes as many bytes as will fit into a pipe.
+*
+* \param pst_Pipe   pointer to the pipe
+* \param pu8_x      pointer to the data
+* \param u16_Len    number of bytes to write
+* \retval N         number of bytes written
+*/
+uint16_t esos_PipeWrite(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len) {
+  u16_Len = __esos_SPSC_WriteUINT8Buffer( &pst_Pipe->st_Ring, pu8_x, u16_Len );
+  if (u16_Len) __esos_PipeWakeReader(pst_Pipe);
+  return u16_Len;
+} // end esos_PipeWrite()
+
+/**
+* Writes several pieces of data into a pipe, in order, as one stream.
+* Writing stops when the pipe is full.  Everything written is seen by
+* the reader at once.
+*
+* \param pst_Pipe   pointer to the pipe
+* \param pst_Vec    pointer to an array of pieces
+* \param u8_NumVec  number of pieces
+* \retval N         number of bytes written
+*/
+uint16_t esos_PipeWritev(PIPE* pst_Pipe, ESOS_IOVEC* pst_Vec, uint8_t u8_NumVec) {
+  uint16_t            u16_Room, u16_Done = 0, u16_Len;
+  uint8_t             u8_i;
+
+  u16_Room = ESOS_PIPE_GET_AVAILABLE(pst_Pipe);
+  for (u8_i=0; (u8_i<u8_NumVec) && (u16_Done<u16_Room); u8_i++) {
+    u16_Len = pst_Vec[u8_i].u16_Len;
+    if (u16_Len > u16_Room-u16_Done) u16_Len = u16_Room-u16_Done;
+    __esos_SPSC_PutUINT8Span( &pst_Pipe->st_Ring, u16_Done, pst_Vec[u8_i].pu8_Base, u16_Len );
+    u16_Done += u16_Len;
+  }
+  if (u16_Done) {
+    __ESOS_SPSC_COMMIT( &pst_Pipe->st_Ring, u16_Done );
+    __esos_PipeWakeReader(pst_Pipe);
+  }
+  return u16_Done;
+} // end esos_PipeWritev()
+
+/**
+* Writes all of the data into a pipe, or nothing if it does not fit.
+*
+* \param pst_Pipe   pointer to the pipe
+* \param pu8_x      pointer to the data
+* \param u16_Len    number of bytes to write
+* \retval TRUE      if the data was written
+* \retval FALSE     if the pipe does not have room for all of it
+* \sa ESOS_TASK_WAIT_ON_PIPE_WRITE
+*/
+uint8_t esos_PipeWriteAll(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len) {
+  if (ESOS_PIPE_GET_AVAILABLE(pst_Pipe) < u16_Len)
+    return FALSE;
+  esos_PipeWrite(pst_Pipe, pu8_x, u16_Len);
+  return TRUE;
+} // end esos_PipeWriteAll()
+
+/**
+* Reads up to u16_Len bytes from a pipe.
+*
+* \param pst_Pipe   pointer to the pipe
+* \param pu8_x      pointer to storage for the data
+* \param u16_Len    largest number of bytes to read
+* \retval N         number of bytes read
+*/
+uint16_t esos_PipeRead(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len) {
+  u16_Len = __esos_SPSC_ReadUINT8Buffer( &pst_Pipe->st_Ring, pu8_x, u16_Len );
+  if (u16_Len) __esos_PipeWakeWriter(pst_Pipe);
+  return u16_Len;
+} // end esos_PipeRead()
+
+/**
+* Reads from a pipe into several pieces of storage, filling them in
+* order.  Reading stops when the pipe is empty.  The space read is
+* given back to the writer at once.
+*
+* \param pst_Pipe   pointer to the pipe
+* \param pst_Vec    pointer to an array of pieces
+* \param u8_NumVec  number of pieces
+* \retval N         number of bytes read
+*/
+uint16_t esos_PipeReadv(PIPE* pst_Pipe, ESOS_IOVEC* pst_Vec, uint8_t u8_NumVec) {
+  uint16_t            u16_Count, u16_Done = 0, u16_Len;
+  uint8_t             u8_i;
+
+  u16_Count = ESOS_PIPE_GET_COUNT(pst_Pipe);
+  for (u8_i=0; (u8_i<u8_NumVec) && (u16_Done<u16_Count); u8_i++) {
+    u16_Len = pst_Vec[u8_i].u16_Len;
+    if (u16_Len > u16_Count-u16_Done) u16_Len = u16_Count-u16_Done;
+    __esos_SPSC_GetUINT8Span( &pst_Pipe->st_Ring, u16_Done, pst_Vec[u8_i].pu8_Base, u16_Len );
+    u16_Done += u16_Len;
+  }
+  if (u16_Done) {
+    __ESOS_SPSC_RELEASE( &pst_Pipe->st_Ring, u16_Done );
+    __esos_PipeWakeWriter(pst_Pipe);
+  }
+  return u16_Done;
+} // end esos_PipeReadv()
+
+/**
+* Reads exactly u16_Len bytes from a pipe, or nothing if fewer are waiting.
+*
+* \param pst_Pipe   pointer to the pipe
+* \param pu8_x      pointer to storage for the data
+* \param u16_Len    number of bytes to read
+* \retval TRUE      if the data was read
+* \retval FALSE     if the pipe holds fewer than u16_Len bytes
+* \sa ESOS_TASK_WAIT_ON_PIPE_READ
+*/
+uint8_t esos_PipeReadAll(PIPE* pst_Pipe, uint8_t* pu8_x, uint16_t u16_Len) {
+  if (ESOS_PIPE_GET_COUNT(pst_Pipe) < u16_Len)
+    return FALSE;
+  esos_PipeRead(pst_Pipe, pu8_x, u16_Len);
+  return TRUE;
+} // end esos_PipeReadAll()
+
+/**
+* Discards all unread data in a pipe.  Must be called by the reader.
+*
+* \param pst_Pipe   pointer to the pipe
+*/
+void esos_FlushPipe(PIPE* pst_Pipe) {
+  __esos_SPSC_Flush( &pst_Pipe->st_Ring );
+  __esos_PipeWakeWriter(pst_Pipe);
+} // end esos_FlushPipe()
@@ -0,0 +1,228 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/** \file
+ * \brief Fixed-block memory pools for ESOS32
+ *
+ */
+
+
+#include    "esos.h"
+#include    "esos_pool.h"
+
+// ******** G L O B A L S ***************
+
+/****************************************************************
+** F U N C T I O N S
+****************************************************************/
+/**
+* Initializes a pool and puts all of its blocks on the free list.
+*
+* \param pst_Pool       pointer to the pool to initialize
+* \param pau8_Data      pointer to storage for u8_NumBlocks*u16_BlockSize bytes
+* \param pau8_Next      pointer to storage for u8_NumBlocks free list links
+* \param u16_BlockSize  size of each block (in bytes)
+* \param u8_NumBlocks   number of blocks (at most ESOS_POOL_MAX_BLOCKS)
+* \sa ESOS_DECLARE_POOL
+* \sa ESOS_INIT_POOL
+*/
+void esos_InitPool(POOL* pst_Pool, uint8_t* pau8_Data, uint8_t* pau8_Next, uint16_t u16_BlockSize, uint8_t u8_NumBlocks) {
+  uint8_t     u8_i;
+
+  if (u8_NumBlocks > ESOS_POOL_MAX_BLOCKS) u8_NumBlocks = ESOS_POOL_MAX_BLOCKS;
+  pst_Pool->pau8_Data = pau8_Data;
+  pst_Pool->pau8_Next = pau8_Next;
+  pst_Pool->u16_BlockSize = u16_BlockSize;
+  pst_Pool->u8_NumBlocks = u8_NumBlocks;
+  for (u8_i=0; u8_i<u8_NumBlocks; u8_i++) {
+    pau8_Next[u8_i] = u8_i+1;
+  }
+  if (u8_NumBlocks) {
+    pau8_Next[u8_NumBlocks-1] = ESOS_POOL_NULL_BLOCK;
+    pst_Pool->u8_Free = 0;
+  } else {
+    pst_Pool->u8_Free = ESOS_POOL_NULL_BLOCK;
+  }
+  pst_Pool->u8_NumFree = u8_NumBlocks;
+  esos_ResetPoolStats(pst_Pool);
+} // end esos_InitPool()
+
+/**
+* Takes the first block off the free list.  Must be called with
+* interrupts masked.
+*/
+ESOS_POOL_BLOCK __esos_TakePoolBlock(POOL* pst_Pool) {
+  ESOS_POOL_BLOCK     h_Block;
+
+  h_Block = pst_Pool->u8_Free;
+  if (h_Block != ESOS_POOL_NULL_BLOCK) {
+    pst_Pool->u8_Free = pst_Pool->pau8_Next[h_Block];
+    pst_Pool->pau8_Next[h_Block] = __ESOS_POOL_BLOCK_IN_USE;
+    pst_Pool->u8_NumFree--;
+    if (pst_Pool->u8_NumFree < pst_Pool->u8_MinFree)
+      pst_Pool->u8_MinFree = pst_Pool->u8_NumFree;
+  }
+  return h_Block;
+} // end __esos_TakePoolBlock()
+
+/**
+* Allocates a block from a pool.  Safe to call from tasks and ISRs.
+*
+* \param pst_Pool   pointer to the pool
+* \retval handle                handle of the allocated block
+* \retval ESOS_POOL_NULL_BLOCK  if the pool is empty
+* \sa ESOS_POOL_BLOCK_PTR
+* \sa ESOS_TASK_WAIT_ON_POOL_BLOCK
+*/
+ESOS_POOL_BLOCK esos_AllocPoolBlock(POOL* pst_Pool) {
+  ESOS_POOL_BLOCK     h_Block;
+  uint32_t            u32_state;
+
+  __ESOS_ENTER_CRITICAL(u32_state);
+  h_Block = __esos_TakePoolBlock(pst_Pool);
+  if (h_Block == ESOS_POOL_NULL_BLOCK)
+    pst_Pool->u16_NumFails++;
+  __ESOS_EXIT_CRITICAL(u32_state);
+  return h_Block;
+} // end esos_AllocPoolBlock()
+
+/**
+* Returns a block to its pool.  Safe to call from tasks and ISRs.
+* Releasing a block that is not allocated (e.g. releasing it twice)
+* would corrupt the free list, so such releases are rejected.
+*
+* \param pst_Pool   pointer to the pool the block came from
+* \param h_Block    handle of the block to release.  Out-of-range
+*                   handles (e.g. ESOS_POOL_NULL_BLOCK) are ignored.
+* \retval TRUE      if the block was returned to the pool
+* \retval FALSE     if the handle is out of range or the block is already free
+*/
+uint8_t esos_ReleasePoolBlock(POOL* pst_Pool, ESOS_POOL_BLOCK h_Block) {
+  uint32_t            u32_state;
+
+  if (h_Block >= pst_Pool->u8_NumBlocks)
+    return FALSE;
+  __ESOS_ENTER_CRITICAL(u32_state);
+  if (pst_Pool->pau8_Next[h_Block] != __ESOS_POOL_BLOCK_IN_USE) {
+    __ESOS_EXIT_CRITICAL(u32_state);
+    return FALSE;
+  }
+  pst_Pool->pau8_Next[h_Block] = pst_Pool->u8_Free;
+  pst_Pool->u8_Free = h_Block;
+  pst_Pool->u8_NumFree++;
+  __ESOS_EXIT_CRITICAL(u32_state);
+  return TRUE;
+} // end esos_ReleasePoolBlock()
+
+/**
+* Finds the handle of the pool block that contains the given address.
+*
+* \param pst_Pool   pointer to the pool
+* \param pu8_Block  pointer into a block of the pool
+* \retval handle                handle of the block
+* \retval ESOS_POOL_NULL_BLOCK  if the pointer is not within the pool
+*/
+ESOS_POOL_BLOCK esos_GetPoolBlockFromPtr(POOL* pst_Pool, uint8_t* pu8_Block) {
+  uint32_t            u32_offset;
+
+  if (pu8_Block < pst_Pool->pau8_Data)
+    return ESOS_POOL_NULL_BLOCK;
+  u32_offset = (uint32_t) (pu8_Block - pst_Pool->pau8_Data);
+  if (u32_offset >= ((uint32_t) pst_Pool->u16_BlockSize)*pst_Pool->u8_NumBlocks)
+    return ESOS_POOL_NULL_BLOCK;
+  return (ESOS_POOL_BLOCK) (u32_offset / pst_Pool->u16_BlockSize);
+} // end esos_GetPoolBlockFromPtr()
+
+/**
+* Resets the high-water mark and failure count of a pool
+*
+* \param pst_Pool   pointer to the pool
+*/
+void esos_ResetPoolStats(POOL* pst_Pool) {
+  pst_Pool->u8_MinFree = pst_Pool->u8_NumFree;
+  pst_Pool->u16_NumFails = 0;
+} // end esos_ResetPoolStats()
+
+/**
+* Allocates a block of at least u16_Size bytes from a set of pools.
+* The smallest block size class that fits the request is tried first.
+* If it is empty, the next larger classes are tried in turn.  Safe to
+* call from tasks and ISRs.
+*
+* \param pst_Set    pointer to the pool set
+* \param u16_Size   number of bytes needed
+* \retval ptr       pointer to the allocated block
+* \retval NULLPTR   if no pool in the set can satisfy the request.  The
+*                   failure is charged to the smallest class that fits.
+*/
+uint8_t* esos_AllocPoolSetBlock(POOLSET* pst_Set, uint16_t u16_Size) {
+  uint8_t             u8_i;
+  POOL*               pst_Pool;
+  POOL*               pst_Fit = NULLPTR;
+  ESOS_POOL_BLOCK     h_Block;
+  uint32_t            u32_state;
+
+  __ESOS_ENTER_CRITICAL(u32_state);
+  for (u8_i=0; u8_i<pst_Set->u8_NumPools; u8_i++) {
+    pst_Pool = pst_Set->ppst_Pools[u8_i];
+    if (pst_Pool->u16_BlockSize >= u16_Size) {
+      if (pst_Fit == NULLPTR) pst_Fit = pst_Pool;
+      h_Block = __esos_TakePoolBlock(pst_Pool);
+      if (h_Block != ESOS_POOL_NULL_BLOCK) {
+        __ESOS_EXIT_CRITICAL(u32_state);
+        return ESOS_POOL_BLOCK_PTR(pst_Pool, h_Block);
+      } // end if
+    } // end if
+  } // end for
+  if (pst_Fit != NULLPTR)
+    pst_Fit->u16_NumFails++;
+  __ESOS_EXIT_CRITICAL(u32_state);
+  return NULLPTR;
+} // end esos_AllocPoolSetBlock()
+
+/**
+* Returns a block allocated by \ref esos_AllocPoolSetBlock to its pool.
+* Safe to call from tasks and ISRs.
+*
+* \param pst_Set    pointer to the pool set
+* \param pu8_Block  pointer returned by esos_AllocPoolSetBlock.  Pointers
+*                   not belonging to any pool in the set are ignored.
+* \retval TRUE      if the block was returned to its pool
+* \retval FALSE     if the pointer is not in the set or the block is already free
+*/
+uint8_t esos_ReleasePoolSetBlock(POOLSET* pst_Set, uint8_t* pu8_Block) {
+  uint8_t             u8_i;
+  ESOS_POOL_BLOCK     h_Block;
+
+  for (u8_i=0; u8_i<pst_Set->u8_NumPools; u8_i++) {
+    h_Block = esos_GetPoolBlockFromPtr(pst_Set->ppst_Pools[u8_i], pu8_Block);
+    if (h_Block != ESOS_POOL_NULL_BLOCK)
+      return esos_ReleasePoolBlock(pst_Set->ppst_Pools[u8_i], h_Block);
+  } // end for
+  return FALSE;
+} // end esos_ReleasePoolSetBlock()
@@ -0,0 +1,192 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/** \file
+ * \brief Typed fixed-size message queues for ESOS32
+ *
+ */
+
+
+#include    <string.h>
+#include    "esos.h"
+#include    "esos_queue.h"
+
+// ******** G L O B A L S ***************
+
+/****************************************************************
+** F U N C T I O N S
+****************************************************************/
+/**
+* Initializes an (empty) queue.
+*
+* \param pst_Queue      pointer to the queue to initialize
+* \param pau8_Data      pointer to storage for u16_Capacity*u16_ElemSize bytes
+* \param u16_ElemSize   size of each element (in bytes)
+* \param u16_Capacity   number of element slots
+* \sa ESOS_DECLARE_QUEUE
+* \sa ESOS_INIT_QUEUE
+*/
+void esos_InitQueue(QUEUE* pst_Queue, uint8_t* pau8_Data, uint16_t u16_ElemSize, uint16_t u16_Capacity) {
+  pst_Queue->pau8_Data = pau8_Data;
+  pst_Queue->u16_ElemSize = u16_ElemSize;
+  pst_Queue->u16_Capacity = u16_Capacity;
+  esos_FlushQueue(pst_Queue);
+} // end esos_InitQueue()
+
+/**
+* Discards every element in a queue.
+*
+* \param pst_Queue      pointer to the queue
+*/
+void esos_FlushQueue(QUEUE* pst_Queue) {
+  uint32_t            u32_state;
+
+  __ESOS_ENTER_CRITICAL(u32_state);
+  pst_Queue->u16_Head = 0;
+  pst_Queue->u16_Tail = 0;
+  pst_Queue->u16_Count = 0;
+  __ESOS_EXIT_CRITICAL(u32_state);
+} // end esos_FlushQueue()
+
+/**
+* Reserves the next free slot of a queue.  The slot stays invisible to
+* the consumer until it is committed with \ref esos_QueueCommit.
+*
+* \note Only for a queue with a single producer context (see esos_queue.h).
+*
+* \param pst_Queue  pointer to the queue
+* \retval ptr       pointer to the reserved slot
+* \retval NULLPTR   if the queue is full
+* \sa ESOS_TASK_WAIT_ON_QUEUE_RESERVE
+*/
+void* esos_QueueReserve(QUEUE* pst_Queue) {
+  if (ESOS_QUEUE_IS_FULL(pst_Queue))
+    return NULLPTR;
+  return &pst_Queue->pau8_Data[(uint32_t) pst_Queue->u16_Head*pst_Queue->u16_ElemSize];
+} // end esos_QueueReserve()
+
+/**
+* Hands the slot reserved by \ref esos_QueueReserve to the consumer.
+*
+* \param pst_Queue  pointer to the queue
+*/
+void esos_QueueCommit(QUEUE* pst_Queue) {
+  uint32_t            u32_state;
+
+  if (++pst_Queue->u16_Head == pst_Queue->u16_Capacity)
+    pst_Queue->u16_Head = 0;
+  __ESOS_ENTER_CRITICAL(u32_state);
+  pst_Queue->u16_Count++;
+  __ESOS_EXIT_CRITICAL(u32_state);
+} // end esos_QueueCommit()
+
+/**
+* Finds the oldest element of a queue without removing it.  The element
+* stays in its slot until it is released with \ref esos_QueueRelease.
+*
+* \note Only for a queue with a single consumer context (see esos_queue.h).
+*
+* \param pst_Queue  pointer to the queue
+* \retval ptr       pointer to the oldest element
+* \retval NULLPTR   if the queue is empty
+* \sa ESOS_TASK_WAIT_ON_QUEUE_PEEK
+*/
+void* esos_QueuePeek(QUEUE* pst_Queue) {
+  if (ESOS_QUEUE_IS_EMPTY(pst_Queue))
+    return NULLPTR;
+  return &pst_Queue->pau8_Data[(uint32_t) pst_Queue->u16_Tail*pst_Queue->u16_ElemSize];
+} // end esos_QueuePeek()
+
+/**
+* Removes the element found by \ref esos_QueuePeek and gives its slot
+* back to the producer.
+*
+* \param pst_Queue  pointer to the queue
+*/
+void esos_QueueRelease(QUEUE* pst_Queue) {
+  uint32_t            u32_state;
+
+  if (++pst_Queue->u16_Tail == pst_Queue->u16_Capacity)
+    pst_Queue->u16_Tail = 0;
+  __ESOS_ENTER_CRITICAL(u32_state);
+  pst_Queue->u16_Count--;
+  __ESOS_EXIT_CRITICAL(u32_state);
+} // end esos_QueueRelease()
+
+/**
+* Copies an element into a queue.  The whole send runs with interrupts
+* masked, so tasks and ISRs may send to the same queue.
+*
+* \param pst_Queue  pointer to the queue
+* \param pv_Elem    pointer to the element (u16_ElemSize bytes)
+* \retval TRUE      if the element was queued
+* \retval FALSE     if the queue is full
+* \sa ESOS_TASK_WAIT_ON_QUEUE_SEND
+*/
+uint8_t esos_QueueSend(QUEUE* pst_Queue, const void* pv_Elem) {
+  uint32_t            u32_state;
+
+  __ESOS_ENTER_CRITICAL(u32_state);
+  if (ESOS_QUEUE_IS_FULL(pst_Queue)) {
+    __ESOS_EXIT_CRITICAL(u32_state);
+    return FALSE;
+  }
+  memcpy(&pst_Queue->pau8_Data[(uint32_t) pst_Queue->u16_Head*pst_Queue->u16_ElemSize], pv_Elem, pst_Queue->u16_ElemSize);
+  if (++pst_Queue->u16_Head == pst_Queue->u16_Capacity)
+    pst_Queue->u16_Head = 0;
+  pst_Queue->u16_Count++;
+  __ESOS_EXIT_CRITICAL(u32_state);
+  return TRUE;
+} // end esos_QueueSend()
+
+/**
+* Copies the oldest element out of a queue and removes it.  The whole
+* receive runs with interrupts masked, so tasks and ISRs may receive
+* from the same queue.
+*
+* \param pst_Queue  pointer to the queue
+* \param pv_Elem    pointer to storage for the element (u16_ElemSize bytes)
+* \retval TRUE      if an element was copied out
+* \retval FALSE     if the queue is empty
+* \sa ESOS_TASK_WAIT_ON_QUEUE_RECEIVE
+*/
+uint8_t esos_QueueReceive(QUEUE* pst_Queue, void* pv_Elem) {
+  uint32_t            u32_state;
+
+  __ESOS_ENTER_CRITICAL(u32_state);
+  if (ESOS_QUEUE_IS_EMPTY(pst_Queue)) {
+    __ESOS_EXIT_CRITICAL(u32_state);
+    return FALSE;
+  }
+  memcpy(pv_Elem, &pst_Queue->pau8_Data[(uint32_t) pst_Queue->u16_Tail*pst_Queue->u16_ElemSize], pst_Queue->u16_ElemSize);
+  if (++pst_Queue->u16_Tail == pst_Queue->u16_Capacity)
+    pst_Queue->u16_Tail = 0;
+  pst_Queue->u16_Count--;
+  __ESOS_EXIT_CRITICAL(u32_state);
+  return TRUE;
+} // end esos_QueueReceive()
@@ -0,0 +1,169 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/** \file
+ * \brief Publish/subscribe topics for ESOS32 tasks
+ *
+ */
+
+
+#include    "esos.h"
+#include    "esos_topic.h"
+
+// bit for a task's user task pool slot in a topic's subscriber mask.
+//   Only tasks in the user task pool have a slot (see __ESOS_IS_USER_TASK_HANDLE)
+#define __TOPIC_SLOT_MASK(pstTask)      (((uint32_t) 1) << ((pstTask) - __astUserTaskPool))
+
+#if (MAX_NUM_USER_TASKS > 32)
+#error "topic subscriber masks hold one bit per user task, so MAX_NUM_USER_TASKS must be no larger than 32"
+#endif
+
+// ******** G L O B A L S ***************
+// one bit per user task pool slot for each topic
+uint32_t      __au32_TopicSubscribers[ESOS_NUM_TOPICS];
+
+/****************************************************************
+** F U N C T I O N S
+****************************************************************/
+/**
+* Removes all subscriptions to all topics.  Called once by ESOS at startup.
+*/
+void __esos_InitTopics(void) {
+  uint8_t     u8_i;
+
+  for (u8_i=0; u8_i<ESOS_NUM_TOPICS; u8_i++) {
+    __au32_TopicSubscribers[u8_i] = 0;
+  }
+} // endof __esos_InitTopics()
+
+/**
+* Removes a task from every topic.  Called by ESOS when a task is
+* registered so that it does not inherit the subscriptions of the task
+* that last used its slot.
+*/
+void __esos_UnsubscribeAllTopics(ESOS_TASK_HANDLE pst_Task) {
+  uint8_t     u8_i;
+  uint32_t    u32_mask;
+
+  if (!__ESOS_IS_USER_TASK_HANDLE(pst_Task))
+    return;
+  u32_mask = ~__TOPIC_SLOT_MASK(pst_Task);
+  for (u8_i=0; u8_i<ESOS_NUM_TOPICS; u8_i++) {
+    __au32_TopicSubscribers[u8_i] &= u32_mask;
+  }
+} // endof __esos_UnsubscribeAllTopics()
+
+/**
+* Subscribes a task to a topic.  The task will receive a mail message
+* (see \ref ESOS_IS_MSG_TOPIC) for everything published to the topic
+* from now on.
+*
+* \param pst_Task   pointer to task structure (ESOS_TASK_HANDLE) of the subscriber
+* \param u8_Topic   topic number
+* \retval TRUE      if the task is now subscribed
+* \retval FALSE     if the topic number is out of range, or the task is
+*                   not a user task (child tasks cannot subscribe)
+* \sa ESOS_TASK_SUBSCRIBE_TOPIC
+*/
+uint8_t esos_SubscribeTopic(ESOS_TASK_HANDLE pst_Task, uint8_t u8_Topic) {
+  if ((u8_Topic >= ESOS_NUM_TOPICS) || !__ESOS_IS_USER_TASK_HANDLE(pst_Task))
+    return FALSE;
+  __au32_TopicSubscribers[u8_Topic] |= __TOPIC_SLOT_MASK(pst_Task);
+  return TRUE;
+} // endof esos_SubscribeTopic()
+
+/**
+* Unsubscribes a task from a topic.  Messages already in the task's
+* mailbox are not affected.
+*
+* \param pst_Task   pointer to task structure (ESOS_TASK_HANDLE) of the subscriber
+* \param u8_Topic   topic number
+* \retval TRUE      if the task is no longer subscribed
+* \retval FALSE     if the topic number is out of range, or the task is not a user task
+*/
+uint8_t esos_UnsubscribeTopic(ESOS_TASK_HANDLE pst_Task, uint8_t u8_Topic) {
+  if ((u8_Topic >= ESOS_NUM_TOPICS) || !__ESOS_IS_USER_TASK_HANDLE(pst_Task))
+    return FALSE;
+  __au32_TopicSubscribers[u8_Topic] &= ~__TOPIC_SLOT_MASK(pst_Task);
+  return TRUE;
+} // endof esos_UnsubscribeTopic()
+
+/**
+* \retval TRUE      if the task is subscribed to the topic
+* \retval FALSE     otherwise
+*/
+uint8_t esos_IsSubscribedTopic(ESOS_TASK_HANDLE pst_Task, uint8_t u8_Topic) {
+  if ((u8_Topic >= ESOS_NUM_TOPICS) || !__ESOS_IS_USER_TASK_HANDLE(pst_Task))
+    return FALSE;
+  return (__au32_TopicSubscribers[u8_Topic] & __TOPIC_SLOT_MASK(pst_Task)) ? TRUE : FALSE;
+} // endof esos_IsSubscribedTopic()
+
+/**
+* Publishes the contents of a mail block to every subscriber of a topic.
+* Each subscriber whose mailbox has room gets a message that refers to
+* the block and holds a reference to it.  Subscribers whose mailboxes are
+* full miss this publication.  The publisher's own reference is given up,
+* so the block returns to the pool once every subscriber has released it
+* (or immediately, if no subscriber received it).
+*
+* \param pst_From   pointer to task structure (ESOS_TASK_HANDLE) of the publisher
+* \param u8_Topic   topic number
+* \param h_Block    handle of the mail block holding the payload
+* \param u16_Len    number of valid bytes in the block
+* \retval N         number of subscribers that received the block
+* \sa ESOS_TASK_PUBLISH_TOPIC
+*/
+uint8_t esos_PublishTopic(ESOS_TASK_HANDLE pst_From, uint8_t u8_Topic, ESOS_MAILBLOCK_HANDLE h_Block, uint16_t u16_Len) {
+  uint8_t               u8_i;
+  uint8_t               u8_cnt = 0;
+  uint32_t              u32_subs;
+  MAILMESSAGE           st_Msg;
+
+  if (u8_Topic < ESOS_NUM_TOPICS) {
+    st_Msg.u8_flags = ESOS_MAILMESSAGE_BLOCK | ESOS_MAILMESSAGE_TOPIC;
+    st_Msg.u16_FromTaskID = pst_From->u16_taskID;
+    st_Msg.u16_DataLength = u16_Len;
+    st_Msg.au8_Contents[0] = h_Block;
+    st_Msg.au8_Contents[1] = u8_Topic;
+    u32_subs = __au32_TopicSubscribers[u8_Topic];
+    for (u8_i=0; (u8_i<MAX_NUM_USER_TASKS) && u32_subs; u8_i++) {
+      // take the subscriber's reference before the message can be read
+      if ((u32_subs & 1) && (__astUserTaskPool[u8_i].pfn != NULLPTR) && esos_RetainMailBlock(h_Block)) {
+        if (__esos_SendMailMessage(&__astUserTaskPool[u8_i], &st_Msg)) {
+          u8_cnt++;
+        } else {
+          esos_ReleaseMailBlock(h_Block);
+        }
+      } // end if
+      u32_subs >>= 1;
+    } // end for
+  } // end if
+  // drop the publisher's reference
+  esos_ReleaseMailBlock(h_Block);
+  return u8_cnt;
+} // endof esos_PublishTopic()
@@ -200,3 +200,28 @@ inline uint16_t esos_hash_u32_to_u16(uint32_t u32_hash) {
   return  (uint16_t) ((u32_hash>>16) ^ (u32_hash&0xFFFF));
 }
 
+
+/**
+ * Updates a CRC-16/CCITT (polynomial 0x1021, not reflected) over a
+ * buffer.  Start a new CRC with \ref ESOS_CRC16_INIT; a long buffer may
+ * be fed in pieces by passing each result back in.  Uses a 16-entry
+ * table, four bits at a time, to keep the flash cost small.
+ * \param u16_crc the CRC so far
+ * \param buf pointer to a buffer of voids
+ * \param len length of the buffer of voids
+ * \retval uint16_t the updated CRC
+*/
+uint16_t esos_buffer_crc16(uint16_t u16_crc, void *buf, uint16_t len) {
+  static const uint16_t au16_Nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+  };
+  uint8_t   *pu8_b = (uint8_t *)buf;
+
+  while (len--) {
+    u16_crc = (u16_crc << 4) ^ au16_Nibble[(u16_crc >> 12) ^ (*pu8_b >> 4)];
+    u16_crc = (u16_crc << 4) ^ au16_Nibble[(u16_crc >> 12) ^ (*pu8_b & 0x0F)];
+    pu8_b++;
+  }
+  return u16_crc;
+}
@@ -170,7 +170,7 @@ void __esos_hw_initCommSystem( uint32_t u32_baudRate ) {
 
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxInDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxInDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -191,12 +191,12 @@ void __esos_hw_initCommSystem( uint32_t u32_baudRate ) {
  *                  it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxInDataLen(void) {
+uint16_t esos_GetCommSystemMaxInDataLen(void) {
   return ESOS_SERIAL_OUT_EP_SIZE;
 } //end esos_GetCommSystemMaxInDataLen()
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxOutDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxOutDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -219,7 +219,7 @@ uint8_t esos_GetCommSystemMaxInDataLen(void) {
  *                  if it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxOutDataLen(void) {
+uint16_t esos_GetCommSystemMaxOutDataLen(void) {
   return  ESOS_SERIAL_IN_EP_SIZE;
 } //end esos_GetCommSystemMaxOutDataLen()
 
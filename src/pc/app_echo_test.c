@@ -0,0 +1,85 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/*
+ * Echo test of the console.  Each line read from the console is sent
+ * straight back out of the "in" ring (as a view), until a line that is
+ * just "END".  SConstruct also builds it with the mock DMA transmit and
+ * receive engines (ESOS_USE_DMA_TX and ESOS_USE_DMA_RX) as
+ * app-echotest-dma.  The echo must match the input:
+ *
+ *    ./app-echotest-dma < input.txt | tail -n +2 | cmp - input.txt
+ *
+ * where input.txt ends with the "END" line, and its lines are shorter
+ * than the console's "in" ring.  (tail drops the "Hello from ESOS" line
+ * printed before ESOS starts.)
+ */
+
+// INCLUDEs go here  (First include the main esos.h file)
+//      After that, the user can include what they need
+#include    "esos.h"
+#include    "esos_pc.h"
+
+#include <stdlib.h>
+
+/*
+ * PROTOTYPEs go here
+ *
+ */
+ESOS_USER_TASK( echo );
+
+ESOS_USER_TASK( echo ) {
+  static SPSCVIEW     st_View;
+  static uint8_t      u8_Done;
+
+  ESOS_TASK_BEGIN();
+  ESOS_TASK_WAIT_ON_AVAILABLE_IN_COMM();
+  ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM();
+  while (!u8_Done) {
+    ESOS_TASK_WAIT_ON_GET_LINE( &st_View );
+    u8_Done = (st_View.u16_Len == 4) && (__ESOS_SPSC_VIEW_BYTE( &st_View, 0 ) == 'E')
+              && (__ESOS_SPSC_VIEW_BYTE( &st_View, 1 ) == 'N') && (__ESOS_SPSC_VIEW_BYTE( &st_View, 2 ) == 'D');
+    ESOS_TASK_WAIT_ON_SEND_U8BUFFER( st_View.pu8_Span1, st_View.u16_Len1 );
+    ESOS_TASK_WAIT_ON_SEND_U8BUFFER( st_View.pu8_Span2, st_View.u16_Len2 );
+    ESOS_COMM_RELEASE_IN_VIEW( &st_View );
+  }
+  // let the last of the echo go out
+  ESOS_TASK_WAIT_UNTIL( __ESOS_SPSC_IS_EMPTY( &ESOS_COMM_CONSOLE->st_Tx ) );
+  ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM();
+  ESOS_TASK_SIGNAL_AVAILABLE_IN_COMM();
+  exit(0);
+  ESOS_TASK_END();
+} // end echo()
+
+/****************************************************
+ *  user_init()
+ ****************************************************
+ */
+void user_init(void) {
+  esos_RegisterTask( echo );
+} // end user_init()
@@ -0,0 +1,129 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/*
+ * Benchmark of the ESOS formatted output engine (esos_format.c) against
+ * the C library's snprintf().  Each case is first checked to give the
+ * same text both ways, and then timed.  The formatter does not need
+ * the rest of ESOS, so this is a plain program.  Build it optimized:
+ *
+ *    gcc -O2 -I../../include -I../../include/pc ../esos_format.c app_format_bench.c
+ */
+
+// INCLUDEs go here  (First include the main esos.h file)
+//      After that, the user can include what they need
+#include    "esos.h"
+#include    "esos_format.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// DEFINEs go here
+#define   NUM_LOOPS       200000
+#define   NUM_VALUES      16
+
+// GLOBALs go here
+static char           ac_Libc[128];
+static char           ac_Esos[128];
+static int32_t        ai32_Values[NUM_VALUES];
+volatile uint16_t     u16_Sink;
+
+/*
+ * One benchmark case per format.  BENCH_CASE runs the same call through
+ * both formatters, so the two are fed exactly the same arguments.
+ */
+#define   BENCH_CASE(psz_name, ...)                                           \
+  do {                                                                        \
+    uint32_t    u32_i;                                                        \
+    uint64_t    u64_Libc, u64_Esos;                                           \
+    for (u32_i=0; u32_i<NUM_VALUES; u32_i++) {                                \
+      int32_t i32_v = ai32_Values[u32_i];                                     \
+      (void) i32_v;                                                           \
+      snprintf(ac_Libc, sizeof(ac_Libc), __VA_ARGS__);                        \
+      esos_FormatString(ac_Esos, sizeof(ac_Esos), __VA_ARGS__);               \
+      if (strcmp(ac_Libc, ac_Esos)) {                                         \
+        printf("MISMATCH in %s:  libc \"%s\"  esos \"%s\"\n", psz_name, ac_Libc, ac_Esos); \
+        u8_Failed = TRUE;                                                     \
+      }                                                                       \
+    }                                                                         \
+    u64_Libc = getNanoseconds();                                              \
+    for (u32_i=0; u32_i<NUM_LOOPS; u32_i++) {                                 \
+      int32_t i32_v = ai32_Values[u32_i % NUM_VALUES];                        \
+      (void) i32_v;                                                           \
+      u16_Sink += snprintf(ac_Libc, sizeof(ac_Libc), __VA_ARGS__);            \
+    }                                                                         \
+    u64_Libc = getNanoseconds() - u64_Libc;                                   \
+    u64_Esos = getNanoseconds();                                              \
+    for (u32_i=0; u32_i<NUM_LOOPS; u32_i++) {                                 \
+      int32_t i32_v = ai32_Values[u32_i % NUM_VALUES];                        \
+      (void) i32_v;                                                           \
+      u16_Sink += esos_FormatString(ac_Esos, sizeof(ac_Esos), __VA_ARGS__);   \
+    }                                                                         \
+    u64_Esos = getNanoseconds() - u64_Esos;                                   \
+    printf("%-24s  snprintf %7.1f ns   esos %7.1f ns   x%.2f\n", psz_name,    \
+           (double) u64_Libc/NUM_LOOPS, (double) u64_Esos/NUM_LOOPS,          \
+           (double) u64_Libc/u64_Esos);                                       \
+  } while(0)
+
+/*
+ * PROTOTYPEs go here
+ *
+ */
+uint64_t    getNanoseconds(void);
+
+uint64_t    getNanoseconds(void) {
+  struct timespec   st_ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &st_ts);
+  return (uint64_t) st_ts.tv_sec * 1000000000ULL + st_ts.tv_nsec;
+} // end getNanoseconds()
+
+int main(void) {
+  uint8_t     u8_i;
+  uint8_t     u8_Failed = FALSE;
+  int32_t     i32_x = 1;
+
+  // a spread of magnitudes and signs
+  for (u8_i=0; u8_i<NUM_VALUES; u8_i++) {
+    ai32_Values[u8_i] = (u8_i & 1) ? -i32_x : i32_x;
+    i32_x = i32_x*7 + 3;
+  }
+
+  BENCH_CASE("decimal", "%d", (int) i32_v);
+  BENCH_CASE("padded decimal", "%08d|%-6d|", (int) i32_v, (int) (i32_v/1000));
+  BENCH_CASE("unsigned 32-bit", "%lu", (unsigned long) (uint32_t) i32_v);
+  BENCH_CASE("hex", "0x%08lX", (unsigned long) (uint32_t) i32_v);
+  BENCH_CASE("64-bit decimal", "%lld", (long long) i32_v * 1000003LL);
+  BENCH_CASE("8/16-bit", "%hhu %hd %hx", (unsigned) i32_v, (int) i32_v, (unsigned) i32_v);
+  BENCH_CASE("string", "[%-10s] %s", "name", "value");
+  BENCH_CASE("log line", "t=%lu ch%u %s=%d (0x%04x)\n", (unsigned long) (uint32_t) i32_v, (unsigned) (i32_v & 7),
+             "temp", (int) (i32_v % 1000), (unsigned) (i32_v & 0xFFFF));
+
+  return u8_Failed;
+} // end main()
@@ -0,0 +1,168 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/*
+ * Test of the ESOS framed binary protocol (esos_frame.c).  A task sends
+ * 60 frames of pseudo-random types, lengths and data on a loopback
+ * channel, whose "out" ring is copied straight into its own "in" ring.
+ * Every 7th frame gets one byte changed on the way.  Each good frame
+ * must reach the handler for its type with the data it was sent with,
+ * and each changed one (and one frame too big for the decoder) must be
+ * counted as an error instead.  The program prints PASS or FAIL and
+ * exits with 0 or 1.
+ */
+
+// INCLUDEs go here  (First include the main esos.h file)
+//      After that, the user can include what they need
+#include    "esos.h"
+#include    "esos_pc.h"
+#include    "esos_frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// DEFINEs go here
+#define   NUM_FRAMES        60
+#define   MAX_DATA_LEN      400
+#define   LOOP_RING_LEN     1024
+#define   TYPE_ECHO         0x10
+#define   TYPE_SUM          0x20
+#define   TYPE_OTHER        0x33
+
+/*
+ * PROTOTYPEs go here
+ *
+ */
+ESOS_USER_TASK( frame_test );
+void loopback_StartTx(ESOS_COMM_HANDLE h_Chan);
+void check_frame(uint8_t u8_Type, uint8_t* pau8_Data, uint16_t u16_Len);
+
+// GLOBALs go here
+ESOS_DECLARE_COMM_CHANNEL( st_Loop, LOOP_RING_LEN, LOOP_RING_LEN );
+
+static uint8_t                  au8_Sent[MAX_DATA_LEN+1];
+static uint16_t                 u16_SentLen;
+static uint8_t                  u8_SentType;
+static uint8_t                  u8_Corrupt;
+static uint16_t                 u16_Received, u16_Bad;
+static uint8_t                  au8_DecBuf[MAX_DATA_LEN+ESOS_FRAME_OVERHEAD];
+static ESOS_FRAME_DECODER       st_Dec;
+static const ESOS_FRAME_HANDLER ast_Handlers[] = {
+  { TYPE_ECHO, check_frame },
+  { TYPE_SUM,  check_frame },
+};
+static const uint16_t           au16_Lengths[] = { 0, 1, 5, 253, 254, 255, 300, 400 };
+
+/*
+ * Backend of the loopback channel:  moves everything sent into the
+ * "in" ring.  When u8_Corrupt is set, one byte in the middle of the
+ * frame is changed first (to another non-zero byte, so the frame still
+ * ends where it should).
+ */
+void loopback_StartTx(ESOS_COMM_HANDLE h_Chan) {
+  uint8_t*    pu8_x;
+
+  if (u8_Corrupt) {
+    pu8_x = &__ESOS_SPSC_PEEK( &h_Chan->st_Tx, __ESOS_SPSC_GET_COUNT( &h_Chan->st_Tx )/2 );
+    *pu8_x ^= (*pu8_x == 0x40) ? 0x20 : 0x40;
+    u8_Corrupt = FALSE;
+  }
+  __esos_SPSC_MoveUINT8Buffer( &h_Chan->st_Rx, &h_Chan->st_Tx, __ESOS_SPSC_GET_COUNT( &h_Chan->st_Tx ) );
+} // end loopback_StartTx()
+
+/*
+ * Handler (and default handler) of the decoder:  the frame must be the
+ * one just sent
+ */
+void check_frame(uint8_t u8_Type, uint8_t* pau8_Data, uint16_t u16_Len) {
+  u16_Received++;
+  if ((u8_Type != u8_SentType) || (u16_Len != u16_SentLen) || memcmp(pau8_Data, au8_Sent, u16_Len)) {
+    printf("frame %u:  type 0x%02X, %u bytes came back wrong\n", u16_Received, u8_Type, u16_Len);
+    u16_Bad++;
+  }
+} // end check_frame()
+
+ESOS_USER_TASK( frame_test ) {
+  static uint16_t     u16_Frame, u16_Corrupted, u16_Expected;
+  static uint16_t     u16_Errors;
+  uint16_t            u16_i;
+  uint32_t            u32_r;
+
+  ESOS_TASK_BEGIN();
+  esos_InitFrameDecoder( &st_Dec, au8_DecBuf, sizeof(au8_DecBuf), ast_Handlers,
+                         sizeof(ast_Handlers)/sizeof(ast_Handlers[0]), check_frame );
+  // line noise before the first frame must cost no more than an error
+  ESOS_TASK_WAIT_ON_CHANNEL_SEND_STRING( &st_Loop, "line noise \x01\x02" );
+  ESOS_TASK_WAIT_ON_CHANNEL_SEND_UINT8( &st_Loop, 0 );
+  esos_FrameDecode( &st_Dec, &st_Loop.st_Rx );
+  u16_Errors = st_Dec.u16_Errors;
+
+  for (u16_Frame=0; u16_Frame<NUM_FRAMES; u16_Frame++) {
+    u32_r = esos_GetRandomUint32();
+    u16_SentLen = au16_Lengths[u32_r % 8];
+    u8_SentType = (u32_r & 0x100) ? TYPE_ECHO : ((u32_r & 0x200) ? TYPE_SUM : TYPE_OTHER);
+    for (u16_i=0; u16_i<u16_SentLen; u16_i++) {
+      u32_r = esos_GetRandomUint32();
+      // plenty of zeros and 0xFF, which COBS must get right
+      au8_Sent[u16_i] = (u32_r & 3) ? 0 : ((u32_r & 4) ? 0xFF : (uint8_t) (u32_r >> 8));
+    }
+    u8_Corrupt = ((u16_Frame % 7) == 3);
+    if (u8_Corrupt) u16_Corrupted++;
+    else u16_Expected++;
+    ESOS_TASK_WAIT_ON_CHANNEL_SEND_FRAME( &st_Loop, u8_SentType, au8_Sent, u16_SentLen );
+    esos_FrameDecode( &st_Dec, &st_Loop.st_Rx );
+  }
+  // a frame too big for the decoder's buffer
+  u8_SentType = TYPE_ECHO;
+  u16_SentLen = MAX_DATA_LEN+1;
+  ESOS_TASK_WAIT_ON_CHANNEL_SEND_FRAME( &st_Loop, u8_SentType, au8_Sent, u16_SentLen );
+  esos_FrameDecode( &st_Dec, &st_Loop.st_Rx );
+
+  u16_Errors = st_Dec.u16_Errors - u16_Errors;
+  printf("%u frames sent, %u changed:  %u received (%u wrong), %u errors\n",
+         NUM_FRAMES+1, u16_Corrupted, u16_Received, u16_Bad, u16_Errors);
+  if (u16_Bad || (u16_Received != u16_Expected) || (st_Dec.u16_Frames != u16_Expected) || (u16_Errors != u16_Corrupted+1)) {
+    printf("FAIL\n");
+    exit(1);
+  }
+  printf("PASS\n");
+  exit(0);
+  ESOS_TASK_END();
+} // end frame_test()
+
+/****************************************************
+ *  user_init()
+ ****************************************************
+ */
+void user_init(void) {
+  ESOS_INIT_COMM_CHANNEL( st_Loop, LOOP_RING_LEN, LOOP_RING_LEN, loopback_StartTx );
+  // the same frames every run
+  __esos_hw_set_PRNG_Seed( 1 );
+  esos_RegisterTask( frame_test );
+} // end user_init()
@@ -0,0 +1,113 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/*
+ * Test of the ESOS deferred binary log (esos_log.c).  A task logs 1600
+ * messages of many formats, and writes the text each one should turn
+ * into (made with esos_FormatString()) to stderr.  Every 100 rounds it
+ * also sends plain text on the console, between the log records, for
+ * the decoder to pass through.  Check the decoded log against it with
+ *
+ *    ./app-logtest 2>expected.txt | ../../tools/esos_logdecode.py --no-ticks app-logtest | tail -n +2 | diff - expected.txt
+ *
+ * (tail drops the "Hello from ESOS" line printed before ESOS starts.)
+ * SConstruct builds it, and the ESOS files it uses, with ESOS_USE_LOG.
+ */
+
+// INCLUDEs go here  (First include the main esos.h file)
+//      After that, the user can include what they need
+#include    "esos.h"
+#include    "esos_pc.h"
+#include    "esos_format.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// DEFINEs go here
+#define   NUM_ROUNDS        400
+#define   TEXT_EVERY        100
+
+/*
+ * Logs a message, and writes the text it should decode to on stderr
+ */
+#define   LOG_AND_EXPECT(...)                                               \
+  do {                                                                      \
+    char    ac_Text[200];                                                   \
+    esos_FormatString( ac_Text, sizeof(ac_Text), __VA_ARGS__ );            \
+    fprintf( stderr, "%s\n", ac_Text );                                     \
+    ESOS_LOG( __VA_ARGS__ );                                                \
+  } while(0)
+
+/*
+ * PROTOTYPEs go here
+ *
+ */
+ESOS_USER_TASK( log_test );
+
+// GLOBALs go here
+static const char*    apsz_States[] = { "IDLE", "RUN", NULL, "ERR" };
+
+ESOS_USER_TASK( log_test ) {
+  static uint16_t     u16_Round;
+  int32_t             i32_mV;
+
+  ESOS_TASK_BEGIN();
+  for (u16_Round=0; u16_Round<NUM_ROUNDS; u16_Round++) {
+    i32_mV = -5000 + 37*(int32_t) u16_Round;
+    LOG_AND_EXPECT( "adc ch%u = %ld mV", u16_Round & 7, (long) i32_mV );
+    LOG_AND_EXPECT( "state %s -> %s (%c) t=%.3lq", apsz_States[u16_Round & 3], apsz_States[(u16_Round+1) & 3],
+                    'A'+(u16_Round % 26), (long) i32_mV );
+    LOG_AND_EXPECT( "w[%*d] p[%-8.*s] h=%hhd %hu x=%#06x %lX %lld", 6, -(int) u16_Round, 3, "abcdef",
+                    300+(int) u16_Round, (unsigned) (70000+u16_Round), u16_Round*13,
+                    0xDEAD0000UL+u16_Round, -123456789012LL*u16_Round );
+    LOG_AND_EXPECT( "%%lit %05d %+i % d %.0d|%#x", -(int) u16_Round, (int) u16_Round, (int) u16_Round, 0, 0 );
+    if ((u16_Round % TEXT_EVERY) == TEXT_EVERY-1) {
+      // plain text between the records:  send it once the log is out,
+      //   so it lands in the same place in both outputs
+      ESOS_TASK_WAIT_ON_LOG_FLUSHED();
+      ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM();
+      ESOS_TASK_WAIT_ON_SEND_STRING( "plain text, not a log record\n" );
+      ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM();
+      fprintf( stderr, "plain text, not a log record\n" );
+    }
+    ESOS_TASK_YIELD();
+  }
+  ESOS_TASK_WAIT_ON_LOG_FLUSHED();
+  ESOS_TASK_WAIT_UNTIL( __ESOS_SPSC_IS_EMPTY( &ESOS_COMM_CONSOLE->st_Tx ) );
+  if (esos_GetLogDropped()) fprintf( stderr, "%u log records dropped\n", esos_GetLogDropped() );
+  exit(0);
+  ESOS_TASK_END();
+} // end log_test()
+
+/****************************************************
+ *  user_init()
+ ****************************************************
+ */
+void user_init(void) {
+  esos_RegisterTask( log_test );
+} // end user_init()
@@ -0,0 +1,214 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/*
+ * Test of the ESOS typed message queues (esos_queue.c).  A task first
+ * checks an empty and a full queue, and that elements come back out in
+ * the order they went in.  Then a producer task sends 1000 elements,
+ * every other one through a slot reserved and filled in place, while a
+ * consumer task takes them out, every other one peeked at in place,
+ * and checks each of them.  The program prints PASS or FAIL and exits
+ * with 0 or 1.
+ */
+
+// INCLUDEs go here  (First include the main esos.h file)
+//      After that, the user can include what they need
+#include    "esos.h"
+#include    "esos_pc.h"
+#include    "esos_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// DEFINEs go here
+#define   QUEUE_LEN         8
+#define   NUM_ELEMS         1000
+
+typedef struct {
+  uint16_t    u16_Seq;
+  uint32_t    u32_Value;
+  char        ac_Tag[5];
+} ELEM;
+
+/*
+ * PROTOTYPEs go here
+ *
+ */
+ESOS_USER_TASK( basics );
+ESOS_USER_TASK( producer );
+ESOS_USER_TASK( consumer );
+void make_elem(uint16_t u16_Seq, ELEM* pst_Elem);
+void check_elem(uint16_t u16_Seq, const ELEM* pst_Elem, const char* psz_Where);
+
+// GLOBALs go here
+ESOS_DECLARE_QUEUE( st_Q, ELEM, QUEUE_LEN );
+static uint8_t        u8_BasicsDone;
+
+/*
+ * Fills in element number u16_Seq (the same one each time)
+ */
+void make_elem(uint16_t u16_Seq, ELEM* pst_Elem) {
+  pst_Elem->u16_Seq = u16_Seq;
+  pst_Elem->u32_Value = u16_Seq * 2654435761UL;
+  snprintf(pst_Elem->ac_Tag, sizeof(pst_Elem->ac_Tag), "%04u", u16_Seq % 10000);
+} // end make_elem()
+
+void check_elem(uint16_t u16_Seq, const ELEM* pst_Elem, const char* psz_Where) {
+  ELEM      st_Expect;
+
+  make_elem(u16_Seq, &st_Expect);
+  if ((pst_Elem->u16_Seq != st_Expect.u16_Seq) || (pst_Elem->u32_Value != st_Expect.u32_Value)
+      || memcmp(pst_Elem->ac_Tag, st_Expect.ac_Tag, sizeof(st_Expect.ac_Tag))) {
+    printf("%s:  expected element %u, got %u\nFAIL\n", psz_Where, u16_Seq, pst_Elem->u16_Seq);
+    exit(1);
+  }
+} // end check_elem()
+
+#define   CHECK(x)                                                          \
+  do {                                                                      \
+    if (!(x)) {                                                             \
+      printf("line %u:  %s is not true\nFAIL\n", __LINE__, #x);             \
+      exit(1);                                                              \
+    }                                                                       \
+  } while(0)
+
+/*
+ * Empty and full queues, and order, all without blocking
+ */
+ESOS_USER_TASK( basics ) {
+  ELEM          st_Elem;
+  ELEM*         pst_Slot;
+  uint16_t      u16_i;
+
+  ESOS_TASK_BEGIN();
+  CHECK( ESOS_QUEUE_IS_EMPTY(&st_Q) );
+  CHECK( ESOS_QUEUE_GET_CAPACITY(&st_Q) == QUEUE_LEN );
+  CHECK( ESOS_QUEUE_GET_ELEM_SIZE(&st_Q) == sizeof(ELEM) );
+  CHECK( !esos_QueueReceive(&st_Q, &st_Elem) );
+  CHECK( esos_QueuePeek(&st_Q) == NULLPTR );
+  // fill it:  half copied in, half filled in place
+  for (u16_i=0; u16_i<QUEUE_LEN; u16_i++) {
+    CHECK( ESOS_QUEUE_GET_AVAILABLE(&st_Q) == QUEUE_LEN-u16_i );
+    if (u16_i & 1) {
+      pst_Slot = esos_QueueReserve(&st_Q);
+      CHECK( pst_Slot != NULLPTR );
+      make_elem(u16_i, pst_Slot);
+      // a reserved slot is not the consumer's until it is committed
+      CHECK( ESOS_QUEUE_GET_COUNT(&st_Q) == u16_i );
+      esos_QueueCommit(&st_Q);
+    } else {
+      make_elem(u16_i, &st_Elem);
+      CHECK( esos_QueueSend(&st_Q, &st_Elem) );
+    }
+  }
+  CHECK( ESOS_QUEUE_IS_FULL(&st_Q) );
+  make_elem(QUEUE_LEN, &st_Elem);
+  CHECK( !esos_QueueSend(&st_Q, &st_Elem) );
+  CHECK( esos_QueueReserve(&st_Q) == NULLPTR );
+  // empty it, in order
+  for (u16_i=0; u16_i<QUEUE_LEN; u16_i++) {
+    if (u16_i & 1) {
+      pst_Slot = esos_QueuePeek(&st_Q);
+      CHECK( pst_Slot != NULLPTR );
+      check_elem(u16_i, pst_Slot, "peek");
+      // a peeked element stays until it is released
+      CHECK( ESOS_QUEUE_GET_COUNT(&st_Q) == QUEUE_LEN-u16_i );
+      esos_QueueRelease(&st_Q);
+    } else {
+      CHECK( esos_QueueReceive(&st_Q, &st_Elem) );
+      check_elem(u16_i, &st_Elem, "receive");
+    }
+  }
+  CHECK( ESOS_QUEUE_IS_EMPTY(&st_Q) );
+  CHECK( !esos_QueueReceive(&st_Q, &st_Elem) );
+  // flushing empties a queue
+  CHECK( esos_QueueSend(&st_Q, &st_Elem) );
+  esos_FlushQueue(&st_Q);
+  CHECK( ESOS_QUEUE_IS_EMPTY(&st_Q) );
+  // now the producer and consumer (the queue is left part way around)
+  CHECK( esos_QueueSend(&st_Q, &st_Elem) && esos_QueueReceive(&st_Q, &st_Elem) );
+  u8_BasicsDone = TRUE;
+  ESOS_TASK_END();
+} // end basics()
+
+ESOS_USER_TASK( producer ) {
+  static uint16_t     u16_Seq;
+  static ELEM         st_Elem;
+  static ELEM*        pst_Slot;
+
+  ESOS_TASK_BEGIN();
+  ESOS_TASK_WAIT_UNTIL( u8_BasicsDone );
+  for (u16_Seq=0; u16_Seq<NUM_ELEMS; u16_Seq++) {
+    if (u16_Seq & 1) {
+      ESOS_TASK_WAIT_ON_QUEUE_RESERVE( &st_Q, pst_Slot );
+      make_elem(u16_Seq, pst_Slot);
+      esos_QueueCommit(&st_Q);
+    } else {
+      make_elem(u16_Seq, &st_Elem);
+      ESOS_TASK_WAIT_ON_QUEUE_SEND( &st_Q, &st_Elem );
+    }
+    // vary the pace, so the queue runs both full and empty
+    if ((u16_Seq % 50) < 25) ESOS_TASK_YIELD();
+  }
+  ESOS_TASK_END();
+} // end producer()
+
+ESOS_USER_TASK( consumer ) {
+  static uint16_t     u16_Seq;
+  static ELEM         st_Elem;
+  static ELEM*        pst_Slot;
+
+  ESOS_TASK_BEGIN();
+  ESOS_TASK_WAIT_UNTIL( u8_BasicsDone );
+  for (u16_Seq=0; u16_Seq<NUM_ELEMS; u16_Seq++) {
+    if (u16_Seq % 3) {
+      ESOS_TASK_WAIT_ON_QUEUE_RECEIVE( &st_Q, &st_Elem );
+      check_elem(u16_Seq, &st_Elem, "receive");
+    } else {
+      ESOS_TASK_WAIT_ON_QUEUE_PEEK( &st_Q, pst_Slot );
+      check_elem(u16_Seq, pst_Slot, "peek");
+      esos_QueueRelease(&st_Q);
+    }
+    if ((u16_Seq % 50) >= 25) ESOS_TASK_YIELD();
+  }
+  CHECK( ESOS_QUEUE_IS_EMPTY(&st_Q) );
+  printf("%u elements through a %u element queue in order\nPASS\n", NUM_ELEMS, QUEUE_LEN);
+  exit(0);
+  ESOS_TASK_END();
+} // end consumer()
+
+/****************************************************
+ *  user_init()
+ ****************************************************
+ */
+void user_init(void) {
+  ESOS_INIT_QUEUE( st_Q, ELEM, QUEUE_LEN );
+  esos_RegisterTask( basics );
+  esos_RegisterTask( producer );
+  esos_RegisterTask( consumer );
+} // end user_init()
@@ -0,0 +1,201 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+
+/*
+ * Test of the zero-copy record reads on the comm "in" ring.  A task
+ * sends 800 lines of pseudo-random text on a loopback channel, and a
+ * "wire" task moves them to the channel's "in" ring a few bytes at a
+ * time, so lines arrive in pieces and wrap around the ring.  The
+ * receiver reads most lines as views (ESOS_TASK_WAIT_ON_CHANNEL_GET_LINE),
+ * checks them, and echoes them straight out of the view on a second
+ * channel, whose backend checks the echo.  Every third line is read
+ * with ESOS_TASK_WAIT_ON_CHANNEL_GET_STRING instead, which also ends at
+ * the '\r' some lines have, right after a look for a whole line with
+ * esos_ChannelGetRecord().  The program prints PASS or FAIL and exits
+ * with 0 or 1.
+ */
+
+// INCLUDEs go here  (First include the main esos.h file)
+//      After that, the user can include what they need
+#include    "esos.h"
+#include    "esos_pc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// DEFINEs go here
+#define   NUM_LINES         800
+#define   MAX_LINE_LEN      200
+#define   LOOP_RING_LEN     256
+
+/*
+ * PROTOTYPEs go here
+ *
+ */
+ESOS_USER_TASK( sender );
+ESOS_USER_TASK( wire );
+ESOS_USER_TASK( receiver );
+void echo_StartTx(ESOS_COMM_HANDLE h_Chan);
+uint16_t make_line(uint16_t u16_Line, uint8_t* pau8_Line);
+void fail(const char* psz_What);
+
+// GLOBALs go here
+ESOS_DECLARE_COMM_CHANNEL( st_Loop, LOOP_RING_LEN, LOOP_RING_LEN );
+ESOS_DECLARE_COMM_CHANNEL( st_Echo, LOOP_RING_LEN, LOOP_RING_LEN );
+
+static uint8_t          au8_Expect[MAX_LINE_LEN+1];
+static uint16_t         u16_ExpectLen, u16_EchoPos;
+static uint16_t         u16_Line, u16_Viewed, u16_Strings;
+
+/*
+ * Makes line u16_Line (the same one each time):  up to MAX_LINE_LEN
+ * letters and spaces, with a '\r' somewhere in every 5th line, and a
+ * '\n' at the end.
+ * \retval N   length of the line, '\n' included
+ */
+uint16_t make_line(uint16_t u16_Line, uint8_t* pau8_Line) {
+  uint32_t    u32_r;
+  uint16_t    u16_Len, u16_i;
+
+  u32_r = (u16_Line+1) * 2654435761UL;
+  u16_Len = (u32_r >> 8) % MAX_LINE_LEN;
+  for (u16_i=0; u16_i<u16_Len; u16_i++) {
+    u32_r = u32_r*1664525UL + 1013904223UL;
+    pau8_Line[u16_i] = "abcdefghijklmno "[u32_r >> 28];
+  }
+  if (((u16_Line % 5) == 0) && u16_Len) pau8_Line[(u32_r >> 4) % u16_Len] = '\r';
+  pau8_Line[u16_Len] = '\n';
+  return u16_Len+1;
+} // end make_line()
+
+void fail(const char* psz_What) {
+  printf("line %u:  %s\nFAIL\n", u16_Line, psz_What);
+  exit(1);
+} // end fail()
+
+/*
+ * Backend of the echo channel:  each byte sent must be the next byte
+ * of the line being checked
+ */
+void echo_StartTx(ESOS_COMM_HANDLE h_Chan) {
+  while (__ESOS_SPSC_IS_NOT_EMPTY( &h_Chan->st_Tx )) {
+    if ((u16_EchoPos >= u16_ExpectLen) || (__esos_SPSC_ReadUINT8( &h_Chan->st_Tx ) != au8_Expect[u16_EchoPos]))
+      fail("echo does not match");
+    u16_EchoPos++;
+  }
+} // end echo_StartTx()
+
+ESOS_USER_TASK( sender ) {
+  static uint8_t      au8_Line[MAX_LINE_LEN+1];
+  static uint16_t     u16_Sent, u16_Len;
+
+  ESOS_TASK_BEGIN();
+  for (u16_Sent=0; u16_Sent<NUM_LINES; u16_Sent++) {
+    u16_Len = make_line( u16_Sent, au8_Line );
+    ESOS_TASK_WAIT_ON_CHANNEL_SEND_U8BUFFER( &st_Loop, au8_Line, u16_Len );
+  }
+  ESOS_TASK_END();
+} // end sender()
+
+/*
+ * Moves 1 to 37 bytes at a time from the "out" to the "in" ring of the
+ * loopback channel
+ */
+ESOS_USER_TASK( wire ) {
+  static uint32_t     u32_r = 12345;
+  uint16_t            u16_n;
+
+  ESOS_TASK_BEGIN();
+  while (TRUE) {
+    ESOS_TASK_WAIT_UNTIL( __ESOS_SPSC_IS_NOT_EMPTY( &st_Loop.st_Tx ) && !__ESOS_SPSC_IS_FULL( &st_Loop.st_Rx ) );
+    u32_r = u32_r*1664525UL + 1013904223UL;
+    u16_n = 1 + (u32_r >> 16) % 37;
+    if (u16_n > __ESOS_SPSC_GET_AVAILABLE( &st_Loop.st_Rx )) u16_n = __ESOS_SPSC_GET_AVAILABLE( &st_Loop.st_Rx );
+    __esos_SPSC_MoveUINT8Buffer( &st_Loop.st_Rx, &st_Loop.st_Tx, u16_n );
+    ESOS_TASK_YIELD();
+  }
+  ESOS_TASK_END();
+} // end wire()
+
+ESOS_USER_TASK( receiver ) {
+  static SPSCVIEW     st_View;
+  static char         ac_Str[LOOP_RING_LEN];
+  static uint8_t*     pu8_Cr;
+  static uint16_t     u16_Part;
+  uint16_t            u16_i;
+
+  ESOS_TASK_BEGIN();
+  for (u16_Line=0; u16_Line<NUM_LINES; u16_Line++) {
+    u16_ExpectLen = make_line( u16_Line, au8_Expect );
+    if ((u16_Line % 3) == 0) {
+      // look for the line with one set of delimiters, then read it with another
+      ESOS_TASK_WAIT_WHILE( __ESOS_SPSC_IS_EMPTY( &st_Loop.st_Rx ) );
+      esos_ChannelGetRecord( &st_Loop, '\n', &st_View );
+      pu8_Cr = memchr( au8_Expect, '\r', u16_ExpectLen );
+      u16_Part = pu8_Cr ? (uint16_t) (pu8_Cr-au8_Expect) : u16_ExpectLen-1;
+      ESOS_TASK_WAIT_ON_CHANNEL_GET_STRING( &st_Loop, ac_Str );
+      if ((strlen(ac_Str) != u16_Part) || memcmp(ac_Str, au8_Expect, u16_Part)) fail("string does not end at the first delimiter");
+      if (pu8_Cr) {
+        ESOS_TASK_WAIT_ON_CHANNEL_GET_STRING( &st_Loop, ac_Str );
+        u16_Part++;
+        if ((strlen(ac_Str) != u16_ExpectLen-1-u16_Part) || memcmp(ac_Str, &au8_Expect[u16_Part], u16_ExpectLen-1-u16_Part))
+          fail("string after the '\\r' is wrong");
+      }
+      u16_Strings++;
+    } else {
+      ESOS_TASK_WAIT_ON_CHANNEL_GET_LINE( &st_Loop, &st_View );
+      if (st_View.u16_Len != u16_ExpectLen) fail("view has the wrong length");
+      for (u16_i=0; u16_i<u16_ExpectLen; u16_i++) {
+        if (__ESOS_SPSC_VIEW_BYTE( &st_View, u16_i ) != au8_Expect[u16_i]) fail("view does not match");
+      }
+      // echo the line straight out of the ring
+      u16_EchoPos = 0;
+      ESOS_TASK_WAIT_ON_CHANNEL_SEND_U8BUFFER( &st_Echo, st_View.pu8_Span1, st_View.u16_Len1 );
+      ESOS_TASK_WAIT_ON_CHANNEL_SEND_U8BUFFER( &st_Echo, st_View.pu8_Span2, st_View.u16_Len2 );
+      if (u16_EchoPos != u16_ExpectLen) fail("echo is short");
+      ESOS_CHANNEL_RELEASE_IN_VIEW( &st_Loop, &st_View );
+      u16_Viewed++;
+    }
+  }
+  printf("%u lines:  %u read as views and echoed, %u read as strings\nPASS\n", NUM_LINES, u16_Viewed, u16_Strings);
+  exit(0);
+  ESOS_TASK_END();
+} // end receiver()
+
+/****************************************************
+ *  user_init()
+ ****************************************************
+ */
+void user_init(void) {
+  ESOS_INIT_COMM_CHANNEL( st_Loop, LOOP_RING_LEN, LOOP_RING_LEN, NULLPTR );
+  ESOS_INIT_COMM_CHANNEL( st_Echo, LOOP_RING_LEN, LOOP_RING_LEN, echo_StartTx );
+  esos_RegisterTask( sender );
+  esos_RegisterTask( wire );
+  esos_RegisterTask( receiver );
+} // end user_init()
@@ -60,32 +60,140 @@
 
 /*** G L O B A L S *************************************************/
 struct termios stored_settings;
+#ifdef ESOS_USE_DMA_TX
+// mock DMA controller:  the transfer in flight, and how many were done
+uint8_t*            __pu8_PcDmaTxSrc;
+volatile uint16_t   __u16_PcDmaTxLen;
+uint32_t            __u32_PcDmaTxTransfers;
+#endif
+#ifdef ESOS_USE_DMA_RX
+// mock DMA controller:  the circular RX buffer, and its count register
+uint8_t*            __pu8_PcDmaRxBuf;
+uint16_t            __u16_PcDmaRxLen;
+volatile uint16_t   __u16_PcDmaRxRemaining;
+#endif
 
 /*** T H E   C O D E *************************************************/
 
 /*********************************************************
  * Public functions intended to be called by other files *
  *********************************************************/
+#ifdef ESOS_USE_DMA_TX
 void    __esos_hw_signal_start_tx(void) {
-  while (__st_TxBuffer.u16_Head != __st_TxBuffer.u16_Tail) {
-    __st_TxBuffer.u16_Tail++;      //increment tail pointer
-    if (__st_TxBuffer.u16_Tail == ESOS_SERIAL_IN_EP_SIZE)
-      __st_TxBuffer.u16_Tail = 0;  //wrap if needed
-    //transfer character from software buffer to transmit buffer
+  __esos_DmaTxKick();
+}
+
+/*
+** Mock DMA controller.  A "transfer" is recorded here and carried out
+** later by the __Linux_dma_tx task, which then plays the part of the
+** transfer-complete ISR.  So the DMA TX engine sees the same
+** start/complete sequence it does on the real hardware.
+*/
+void    __esos_hw_dma_tx_start(uint8_t* pu8_Data, uint16_t u16_Len) {
+  __pu8_PcDmaTxSrc = pu8_Data;
+  __u16_PcDmaTxLen = u16_Len;
+}
+
+ESOS_USER_TASK( __Linux_dma_tx ) {
+  ESOS_TASK_BEGIN();
+  while (TRUE) {
+    ESOS_TASK_WAIT_UNTIL( __u16_PcDmaTxLen != 0 );
+    fwrite( __pu8_PcDmaTxSrc, 1, __u16_PcDmaTxLen, stdout );
+    fflush(stdout);
+    __u16_PcDmaTxLen = 0;
+    __u32_PcDmaTxTransfers++;
+    __esos_DmaTxComplete();
+  } // endof while(TRUE)
+  ESOS_TASK_END();
+} // endof TASK
+#else
+void    __esos_hw_signal_start_tx(void) {
+  uint16_t    u16_Begin, u16_Span;
+#ifdef USE_NCURSES
+  uint16_t    u16_i;
+#else
+  ssize_t     s_Sent;
+#endif
+
+  // we are the consumer of the TX ring.  Drain it to the terminal
+  // a contiguous span at a time (two spans when the data wraps).
+  while (__ESOS_SPSC_IS_NOT_EMPTY( __pst_CB_Tx )) {
+    u16_Begin = __ESOS_SPSC_INDEX( __pst_CB_Tx, __pst_CB_Tx->u16_Tail );
+    u16_Span = __ESOS_SPSC_GET_COUNT( __pst_CB_Tx );
+    if (u16_Span > __ESOS_SPSC_GET_LENGTH( __pst_CB_Tx ) - u16_Begin)
+      u16_Span = __ESOS_SPSC_GET_LENGTH( __pst_CB_Tx ) - u16_Begin;
 #ifdef USE_NCURSES
-    waddch( __st_TxBuffer.pau8_Data[__st_TxBuffer.u16_Tail] );
+    for (u16_i=0; u16_i<u16_Span; u16_i++)
+      waddch( __pst_CB_Tx->pau8_Data[u16_Begin+u16_i] );
 #else
-    printf("%c", __st_TxBuffer.pau8_Data[__st_TxBuffer.u16_Tail]);
-    // make the stdout do its thing right away
+    // anything printf()-ed directly must come out first
     fflush(stdout);
+    s_Sent = write( STDOUT_FILENO, &__pst_CB_Tx->pau8_Data[u16_Begin], u16_Span );
+    if (s_Sent <= 0) break;
+    u16_Span = (uint16_t) s_Sent;
 #endif
+    __ESOS_SPSC_RELEASE( __pst_CB_Tx, u16_Span );
   }
 }
+#endif    // ESOS_USE_DMA_TX
 
 void    __esos_hw_signal_stop_tx(void) {
 
 }
 
+#ifdef ESOS_USE_DMA_RX
+/*
+** Mock circular DMA reception.  __esos_PcDmaRxFeed() stores each byte
+** the way the DMA controller would, counting the transfer register
+** down and reloading it at zero.  It raises the half-transfer,
+** transfer-complete and (at the end of the stream) idle-line events
+** at the points the hardware would.
+*/
+void    __esos_hw_dma_rx_start(uint8_t* pu8_Data, uint16_t u16_Len) {
+  __pu8_PcDmaRxBuf = pu8_Data;
+  __u16_PcDmaRxLen = u16_Len;
+  __u16_PcDmaRxRemaining = u16_Len;
+}
+
+void    __esos_PcDmaRxFeed(uint8_t* pu8_Data, uint16_t u16_Len) {
+  while (u16_Len--) {
+    __pu8_PcDmaRxBuf[__u16_PcDmaRxLen - __u16_PcDmaRxRemaining] = *pu8_Data++;
+    __u16_PcDmaRxRemaining--;
+    if (__u16_PcDmaRxRemaining == __u16_PcDmaRxLen/2) {
+      __esos_DmaRxUpdate( __u16_PcDmaRxRemaining );       // half transfer
+    } else if (__u16_PcDmaRxRemaining == 0) {
+      __u16_PcDmaRxRemaining = __u16_PcDmaRxLen;
+      __esos_DmaRxUpdate( __u16_PcDmaRxRemaining );       // transfer complete
+    }
+  } // endof while()
+  __esos_DmaRxUpdate( __u16_PcDmaRxRemaining );           // line is idle
+}
+
+ESOS_USER_TASK( __Linux_check_keyboard ) {
+  static uint8_t      au8_burst[32];
+  static uint16_t     u16_n;
+
+  ESOS_TASK_BEGIN();
+  set_keypress();
+  while (TRUE) {
+    ESOS_TASK_WAIT_UNTIL(  kbhit() );
+    // take everything typed (or piped) so far as one burst.  A real
+    // UART would overrun the ring if the tasks fell behind;  stdin can
+    // wait, so never send more than the ring has room for.
+    ESOS_TASK_WAIT_WHILE( __ESOS_SPSC_IS_FULL( __pst_CB_Rx ) );
+    u16_n = 0;
+    while ((u16_n < sizeof(au8_burst)) && (u16_n < __ESOS_SPSC_GET_AVAILABLE( __pst_CB_Rx )) && kbhit()) {
+      if (read(0, &au8_burst[u16_n], 1) != 1) break;
+      u16_n++;
+    }
+    __esos_PcDmaRxFeed( au8_burst, u16_n );
+    // piped input is always "ready" (even at its end), so let the other
+    //   tasks run between bursts
+    ESOS_TASK_YIELD();
+  } // endof while(TRUE)
+  ESOS_TASK_END();
+} // endof TASK
+#else
 ESOS_USER_TASK( __Linux_check_keyboard ) {
   static uint8_t      u8_c;
 
@@ -94,14 +202,12 @@ ESOS_USER_TASK( __Linux_check_keyboard ) {
   while (TRUE) {
     ESOS_TASK_WAIT_UNTIL(  kbhit() );
     u8_c = getchar();             //read character
-    __st_RxBuffer.u16_Head++;     //increment head pointer
-    if (__st_RxBuffer.u16_Head == ESOS_SERIAL_OUT_EP_SIZE)
-      __st_RxBuffer.u16_Head = 0; //wrap if needed
-
-    __st_RxBuffer.pau8_Data[__st_RxBuffer.u16_Head] = u8_c;   //place in buffer
+    // we are the producer of the RX ring (just like the UART ISR)
+    __esos_SPSC_WriteUINT8( __pst_CB_Rx, u8_c );
   } // endof while(TRUE)
   ESOS_TASK_END();
 } // endof TASK
+#endif    // ESOS_USE_DMA_RX
 
 
 /*
@@ -193,12 +299,16 @@ void __esos_hw_InitCommSystem(void) {
   //     run very well.  When stepping, try to structure the application
   //     to run without input from stdin and COMMENT OUT THE FOLLOWING LINE!
   esos_RegisterTask( __Linux_check_keyboard );
+#ifdef ESOS_USE_DMA_TX
+  // the mock DMA controller runs as a task, too
+  esos_RegisterTask( __Linux_dma_tx );
+#endif
 
 }  // end __esos_hw_InitCommSystem()
 
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxInDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxInDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -219,12 +329,12 @@ void __esos_hw_InitCommSystem(void) {
  *                  it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxInDataLen(void) {
+uint16_t esos_GetCommSystemMaxInDataLen(void) {
   return ESOS_SERIAL_OUT_EP_SIZE;
 } //end esos_GetCommSystemMaxInDataLen()
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxOutDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxOutDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -247,7 +357,7 @@ uint8_t esos_GetCommSystemMaxInDataLen(void) {
  *                  if it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxOutDataLen(void) {
+uint16_t esos_GetCommSystemMaxOutDataLen(void) {
   return  ESOS_SERIAL_IN_EP_SIZE;
 } //end esos_GetCommSystemMaxOutDataLen()
 
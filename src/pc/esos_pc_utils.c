@@ -0,0 +1,67 @@
+/*
+ * "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+ * All rights reserved.
+ * (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+ *
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without written agreement is
+ * hereby granted, provided that the above copyright notice, the following
+ * two paragraphs and the authors appear in all copies of this software.
+ *
+ * IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+ * OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+ * HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+ *
+ * Please maintain this header in its entirety when copying/modifying
+ * these files.
+ *
+ *
+ */
+
+/**
+ * \addtogroup ESOS32_Utility_Functions
+ * @{
+ */
+
+// Documentation for this file. If the \file tag isn't present,
+// this file won't be documented.
+/**
+* \file
+* \brief PC (linux) versions of the hardware-specific ESOS32 utilities.
+*
+* The PC has no PRNG hardware, so it uses the ESOS software PRNG.
+*/
+
+#include    "esos.h"
+
+/*
+ * User must provide the HW-specific routine to return a 32-bit
+ *   pseudo-random number.  The PC uses the ESOS software PRNG.
+ */
+uint32_t   __esos_hw_PRNG_u32(void) {
+  return __esos_get_PRNG_RandomUint32();
+} // end __esos_hw_PRNG_u32()
+
+/*
+ * User must provide the HW-specific routine to set up the PRNG
+ *   hardware.  The PC has none, so there is nothing to do.
+ */
+void   __esos_hw_config_PRNG(void) {
+
+} // end __esos_hw_config_PRNG()
+
+/*
+ * User must provide the HW-specific routine to seed the PRNG.
+ */
+void   __esos_hw_set_PRNG_Seed(uint32_t u32_seed) {
+  __esos_set_PRNG_U32Seed(u32_seed);
+} // end __esos_hw_set_PRNG_Seed()
+
+/** @} */
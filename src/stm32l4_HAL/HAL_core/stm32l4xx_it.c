@@ -63,6 +63,9 @@
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN PFP */
 extern	void __esos_tmrSvcsExecute(void);
+#ifdef ESOS_USE_DMA_RX
+extern	void __esos_hw_uart_rx_idle(void);
+#endif
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -210,7 +213,9 @@ void SysTick_Handler(void) {
 */
 void USART2_IRQHandler(void) {
   /* USER CODE BEGIN USART2_IRQn 0 */
-
+#ifdef ESOS_USE_DMA_RX
+  __esos_hw_uart_rx_idle();
+#endif
   /* USER CODE END USART2_IRQn 0 */
   HAL_UART_IRQHandler(&st_huart2);
   /* USER CODE BEGIN USART2_IRQn 1 */
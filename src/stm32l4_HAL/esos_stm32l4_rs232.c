@@ -46,6 +46,12 @@
 uint8_t         u8_uartRXbuf;
 uint8_t         u8_uartTXbuf;
 UART_HandleTypeDef    st_huart2;
+#ifdef ESOS_USE_DMA_TX
+DMA_HandleTypeDef     st_hdma_usart2_tx;
+#endif
+#ifdef ESOS_USE_DMA_RX
+DMA_HandleTypeDef     st_hdma_usart2_rx;
+#endif
 
 /*** T H E   C O D E *************************************************/
 // probably need to define a flag for this so ISRs can start/stop
@@ -56,6 +62,21 @@ UART_HandleTypeDef    st_huart2;
 /*********************************************************
  * Public functions intended to be called by other files *
  *********************************************************/
+#ifdef ESOS_USE_DMA_TX
+inline void    __esos_hw_signal_start_tx(void) {
+  __esos_DmaTxKick();
+}
+
+void    __esos_hw_dma_tx_start(uint8_t* pu8_Data, uint16_t u16_Len) {
+  // the span lives in the TX ring and stays put until
+  // __esos_DmaTxComplete() releases it, so the HAL can have the pointer
+  HAL_UART_Transmit_DMA(&st_huart2, pu8_Data, u16_Len);
+}
+
+void DMA1_Channel7_IRQHandler(void) {
+  HAL_DMA_IRQHandler(&st_hdma_usart2_tx);
+}
+#else
 inline void    __esos_hw_signal_start_tx(void) {
   if __esos_IsSystemFlagClear(__ESOS_SYS_COMM_TX_ONGOING) {
     // no TX is currently ongoing, so kick it off.
@@ -65,11 +86,41 @@ inline void    __esos_hw_signal_start_tx(void) {
     //  address to the HAL_UART_Transmit_IT.  The ESOS CB don't
     //  have a routine that returns a pointer to data, and I
     //  don't trust the HAL enough to pass an address into my CB.
-    u8_uartTXbuf = __esos_CB_ReadUINT8(  __pst_CB_Tx );
+    u8_uartTXbuf = __esos_SPSC_ReadUINT8(  __pst_CB_Tx );
     HAL_UART_Transmit_IT(&st_huart2, &u8_uartTXbuf, 1);
     //HAL_UART_Transmit_IT(&st_huart2, &__st_TxBuffer.pau8_Data[__st_TxBuffer.u16_Tail], 1);
   }
 }
+#endif    // ESOS_USE_DMA_TX
+
+#ifdef ESOS_USE_DMA_RX
+void    __esos_hw_dma_rx_start(uint8_t* pu8_Data, uint16_t u16_Len) {
+  // st_hdma_usart2_rx is in circular mode, so this never stops
+  HAL_UART_Receive_DMA(&st_huart2, pu8_Data, u16_Len);
+  __HAL_UART_ENABLE_IT(&st_huart2, UART_IT_IDLE);
+}
+
+/*
+** This HAL does not report the UART idle-line event, so
+** USART2_IRQHandler calls us before handing over to the HAL.
+*/
+void    __esos_hw_uart_rx_idle(void) {
+  if (__HAL_UART_GET_FLAG(&st_huart2, UART_FLAG_IDLE)) {
+    // the line went quiet:  publish the burst the DMA has received
+    __HAL_UART_CLEAR_IDLEFLAG(&st_huart2);
+    __esos_DmaRxUpdate( __HAL_DMA_GET_COUNTER(&st_hdma_usart2_rx) );
+  }
+}
+
+void DMA1_Channel6_IRQHandler(void) {
+  HAL_DMA_IRQHandler(&st_hdma_usart2_rx);
+}
+
+void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *UartHandle) {
+  // half of the ring has been filled.  Publish it.
+  __esos_DmaRxUpdate( __HAL_DMA_GET_COUNTER(&st_hdma_usart2_rx) );
+}
+#endif    // ESOS_USE_DMA_RX
 
 inline void    __esos_hw_signal_stop_tx(void) {
   __esos_ClearSystemFlag(__ESOS_SYS_COMM_TX_ONGOING);
@@ -91,6 +142,10 @@ inline void    __esos_hw_signal_stop_tx(void) {
 
 
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle) {
+#ifdef ESOS_USE_DMA_RX
+  // all of the ring has been filled (and the DMA has wrapped).  Publish it.
+  __esos_DmaRxUpdate( __HAL_DMA_GET_COUNTER(&st_hdma_usart2_rx) );
+#else
   /* If this function is called, we have received a
    * byte into the UART.  The HAL UART handler has
    * called us, and the received data is in u8_uartRXbuf.
@@ -104,16 +159,22 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle) {
   //// place our new data into buffer
   //__st_RxBuffer.pau8_Data[__st_RxBuffer.u16_Head] = u8_uartRXbuf;
 
-  // call CB overwrite.... we can't block here in the ISR so
-  // if data comes in too fast, we will just overwrite existing
-  // data in the CBs
-  __esos_CB_OverwriteUINT8( __pst_CB_Rx, u8_uartRXbuf );
+  // we are the producer of the lock-free RX ring.... we can't
+  // block here in the ISR so if data comes in too fast, the
+  // newest data is dropped.  (Overwriting the oldest data would
+  // require us to move the task-owned tail.)
+  __esos_SPSC_WriteUINT8( __pst_CB_Rx, u8_uartRXbuf );
   // request HAL UART handler to get ONE more byte
   HAL_UART_Receive_IT(UartHandle, &u8_uartRXbuf, 1);
+#endif
 }
 
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *UartHandle) {
-  if (__ESOS_CB_IS_EMPTY( __pst_CB_Tx)) {
+#ifdef ESOS_USE_DMA_TX
+  // retire the span just sent and start the next one (if any)
+  __esos_DmaTxComplete();
+#else
+  if (__ESOS_SPSC_IS_EMPTY( __pst_CB_Tx)) {
     //empty TX buffer, disable the interrupt, do not clear the flag
     __esos_hw_signal_stop_tx();
   } else {
@@ -126,14 +187,18 @@ void HAL_UART_TxCpltCallback(UART_HandleTypeDef *UartHandle) {
     // TODO: Once this gets working... change to have the HAL
     //       transmit all remining data in the circular buffer
     //       This will improve performance a little bit.
-    u8_uartTXbuf = __esos_CB_ReadUINT8(  __pst_CB_Tx );
+    u8_uartTXbuf = __esos_SPSC_ReadUINT8(  __pst_CB_Tx );
     HAL_UART_Transmit_IT(&st_huart2, &u8_uartTXbuf, 1);
   }
+#endif
 }
 
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *UartHandle) {
+#ifndef ESOS_USE_DMA_RX
+  // (circular DMA reception is set up to ride through UART errors)
   if(UartHandle->ErrorCode == HAL_UART_ERROR_ORE)
     HAL_UART_Receive_IT(UartHandle, &u8_uartRXbuf, 1);
+#endif
 }
 
 /** Configure the UART. Settings chosen:
@@ -159,10 +224,55 @@ void __esos_configUART1(uint32_t u32_baudRate) {
   st_huart2.Init.HwFlowCtl = UART_HWCONTROL_NONE;
   st_huart2.Init.OverSampling = UART_OVERSAMPLING_16;
   st_huart2.Init.OneBitSampling = UART_ONE_BIT_SAMPLE_DISABLE;
+#ifdef ESOS_USE_DMA_RX
+  // keep the circular RX DMA running through overrun and RX errors
+  st_huart2.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_RXOVERRUNDISABLE_INIT | UART_ADVFEATURE_DMADISABLEONERROR_INIT;
+  st_huart2.AdvancedInit.OverrunDisable = UART_ADVFEATURE_OVERRUN_DISABLE;
+  st_huart2.AdvancedInit.DMADisableonRxError = UART_ADVFEATURE_DMA_ENABLEONRXERROR;
+#else
   st_huart2.AdvancedInit.AdvFeatureInit = UART_ADVFEATURE_NO_INIT;
+#endif
   if (HAL_UART_Init(&st_huart2) != HAL_OK) {
     Error_Handler();
   }
+#ifdef ESOS_USE_DMA_TX
+  // USART2_TX is DMA1 channel 7, request 2, on the STM32L4
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  st_hdma_usart2_tx.Instance = DMA1_Channel7;
+  st_hdma_usart2_tx.Init.Request = DMA_REQUEST_2;
+  st_hdma_usart2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  st_hdma_usart2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+  st_hdma_usart2_tx.Init.MemInc = DMA_MINC_ENABLE;
+  st_hdma_usart2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  st_hdma_usart2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  st_hdma_usart2_tx.Init.Mode = DMA_NORMAL;
+  st_hdma_usart2_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+  if (HAL_DMA_Init(&st_hdma_usart2_tx) != HAL_OK) {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&st_huart2, hdmatx, st_hdma_usart2_tx);
+  HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
+#endif
+#ifdef ESOS_USE_DMA_RX
+  // USART2_RX is DMA1 channel 6, request 2, on the STM32L4
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  st_hdma_usart2_rx.Instance = DMA1_Channel6;
+  st_hdma_usart2_rx.Init.Request = DMA_REQUEST_2;
+  st_hdma_usart2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  st_hdma_usart2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+  st_hdma_usart2_rx.Init.MemInc = DMA_MINC_ENABLE;
+  st_hdma_usart2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  st_hdma_usart2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  st_hdma_usart2_rx.Init.Mode = DMA_CIRCULAR;
+  st_hdma_usart2_rx.Init.Priority = DMA_PRIORITY_HIGH;
+  if (HAL_DMA_Init(&st_hdma_usart2_rx) != HAL_OK) {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&st_huart2, hdmarx, st_hdma_usart2_rx);
+  HAL_NVIC_SetPriority(DMA1_Channel6_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+#endif
 #else
 #error Can not configUART1() since target hardware has not been defined.
 #endif
@@ -171,11 +281,14 @@ void __esos_configUART1(uint32_t u32_baudRate) {
   HAL_NVIC_SetPriority(USART2_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(USART2_IRQn);
 
+#ifndef ESOS_USE_DMA_RX
   // Kick off RX on UART via call to HAL.  Upon receipt of data
   //  the call back should kick off another one.  In the current
   //  specificaiton of ESOS, we always are "receiving", so RX is
-  //  never disabled.
+  //  never disabled.  (With ESOS_USE_DMA_RX, the comm system
+  //  starts the circular DMA instead.)
   HAL_UART_Receive_IT(&st_huart2, &u8_uartRXbuf, 1);
+#endif
 
 }
 
@@ -203,7 +316,7 @@ void __esos_hw_InitCommSystem(void) {
 
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxInDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxInDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -224,12 +337,12 @@ void __esos_hw_InitCommSystem(void) {
  *                  it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxInDataLen(void) {
+uint16_t esos_GetCommSystemMaxInDataLen(void) {
   return ESOS_SERIAL_OUT_EP_SIZE;
 } //end esos_GetCommSystemMaxInDataLen()
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxOutDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxOutDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -252,7 +365,7 @@ uint8_t esos_GetCommSystemMaxInDataLen(void) {
  *                  if it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxOutDataLen(void) {
+uint16_t esos_GetCommSystemMaxOutDataLen(void) {
   return  ESOS_SERIAL_IN_EP_SIZE;
 } //end esos_GetCommSystemMaxOutDataLen()
 
@@ -42,8 +42,6 @@
 /*** I N C L U D E S *************************************************/
 #include "esos_stm32l4_i2c.h"
 
-#include	<stdio.h>
-
 
 /*** D E F I N E S *************************************************/
 #define DEBUG(str)			__esos_unsafe_PutString(str)
@@ -110,7 +108,7 @@ void __esos_i2c_hw_config(uint32_t u32_i2cbps) {
 	//i2c_enable_interrupt(I2C1, I2C_CR1_TXIE);
 	//i2c_enable_interrupt(I2C1, I2C_CR1_RXIE);
 	i2c_peripheral_enable(I2C1);
-	//sprintf(ac_debug,"   4: 0x%08lx 0x%08lx 0x%08lx 0x%08lx", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_TXDR);   DEBUG(ac_debug);
+	//esos_FormatString(ac_debug, sizeof(ac_debug),"   4: 0x%08lx 0x%08lx 0x%08lx 0x%08lx", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_TXDR);   DEBUG(ac_debug);
 }
 
 /**
@@ -144,13 +142,13 @@ ESOS_CHILD_TASK( __esos_i2c_hw_writeN, uint8_t u8_addr, uint8_t* pu8_d, uint8_t
 
 	
   ESOS_TASK_BEGIN();
-  //sprintf(ac_debug,"i2c_hw_writeN 1: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
+  //esos_FormatString(ac_debug, sizeof(ac_debug),"i2c_hw_writeN 1: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
   ESOS_TASK_WAIT_WHILE( __ESOS_I2C_STM32L4_IS_BUSY() );
   CLEAR_REGISTER_BITS(I2C1_CR2, I2C_CR2_SADD_7BIT_MASK | I2C_CR2_NBYTES_MASK | I2C_CR2_RELOAD | I2C_CR2_AUTOEND | I2C_CR2_START | I2C_CR2_STOP );
 
 
   // __ESOS_I2C_STM32L4_RESET_CR2();
-  //sprintf(ac_debug,"   2: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
+  //esos_FormatString(ac_debug, sizeof(ac_debug),"   2: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
   
   u8_tempAddr=u8_addr;
   pu8_tempPtr=pu8_d;
@@ -161,21 +159,21 @@ ESOS_CHILD_TASK( __esos_i2c_hw_writeN, uint8_t u8_addr, uint8_t* pu8_d, uint8_t
   __ESOS_I2C_STM32L4_SET_WRITE_DIR();
   __ESOS_I2C_STM32L4_SET_NUM_BYTES(u8_cnt);  
   __ESOS_I2C_STM32L4_SET_AUTOEND();
-  //sprintf(ac_debug,"   3: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
+  //esos_FormatString(ac_debug, sizeof(ac_debug),"   3: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
   
 	//i2c_peripheral_enable(I2C1);
 	//i2c_send_start(I2C1);
 	  I2C1_CR2 |= I2C_CR2_START;
 
 
-  //sprintf(ac_debug,"   4: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
+  //esos_FormatString(ac_debug, sizeof(ac_debug),"   4: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_ICR);   DEBUG(ac_debug);
   while (u8_tempCnt--) {
 			/*ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM();
 			ESOS_TASK_WAIT_ON_SEND_STRING("TX NOT EMPTY \n");
 			ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM();*/
 	  
 	  //ESOS_TASK_WAIT_WHILE( __ESOS_I2C_STM32L4_IS_NACK_RECEIVED());
-	 // sprintf(ac_debug,"   5: 0x%08lx 0x%08lx 0x%08lx 0x%08lx", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_TXDR);   DEBUG(ac_debug);
+	 // esos_FormatString(ac_debug, sizeof(ac_debug),"   5: 0x%08lx 0x%08lx 0x%08lx 0x%08lx", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_TXDR);   DEBUG(ac_debug);
 	  ESOS_TASK_WAIT_UNTIL( __ESOS_I2C_STM32L4_IS_TX_EMPTY() );
 	  
 			ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM();
@@ -184,7 +182,7 @@ ESOS_CHILD_TASK( __esos_i2c_hw_writeN, uint8_t u8_addr, uint8_t* pu8_d, uint8_t
 	  
 	  //i2c_send_data(I2C1, *pu8_tempPtr++);
 	  
-	  //sprintf(ac_debug,"   6: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n\r", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_TXDR);   DEBUG(ac_debug);
+	  //esos_FormatString(ac_debug, sizeof(ac_debug),"   6: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n\r", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_TXDR);   DEBUG(ac_debug);
 	  I2C1_TXDR = *pu8_tempPtr;
 	  pu8_tempPtr++;
 	  
@@ -234,7 +232,7 @@ ESOS_CHILD_TASK( __esos_i2c_hw_readN, uint8_t u8_addr, uint8_t* pu8_d, uint8_t u
   // enable AUTOEND after the START to get REPEATED START
   __ESOS_I2C_STM32L4_SET_AUTOEND();   
   for (u8_i=0; u8_i < u8_tempCnt; u8_i++) {
-	  	//sprintf(ac_debug,"   6: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n\r", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_RXDR);   DEBUG(ac_debug);
+	  	//esos_FormatString(ac_debug, sizeof(ac_debug),"   6: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n\r", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_RXDR);   DEBUG(ac_debug);
 	  
 		/*ESOS_TASK_WAIT_ON_AVAILABLE_OUT_COMM();
 		ESOS_TASK_WAIT_ON_SEND_STRING("RX EMPTY \n\r ");
@@ -246,7 +244,7 @@ ESOS_CHILD_TASK( __esos_i2c_hw_readN, uint8_t u8_addr, uint8_t* pu8_d, uint8_t u
 		ESOS_TASK_WAIT_ON_SEND_STRING("RX NOT EMPTY \n\r ");
 		ESOS_TASK_SIGNAL_AVAILABLE_OUT_COMM();*/
 	  
-		  	//sprintf(ac_debug,"   7: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n\r", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_RXDR);   DEBUG(ac_debug);
+		  	//esos_FormatString(ac_debug, sizeof(ac_debug),"   7: 0x%08lx 0x%08lx 0x%08lx 0x%08lx\n\r", I2C1_CR1, I2C1_CR2, I2C1_ISR, I2C1_RXDR);   DEBUG(ac_debug);
     *pu8_tempD = I2C1_RXDR;
     pu8_tempD++;
 	//I2C1_RXDR = 0;
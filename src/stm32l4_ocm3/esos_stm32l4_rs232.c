@@ -41,6 +41,9 @@
 
 /*** I N C L U D E S *************************************************/
 #include "esos_stm32l4_rs232.h"
+#if defined(ESOS_USE_DMA_TX) || defined(ESOS_USE_DMA_RX)
+#include <libopencm3/stm32/dma.h>
+#endif
 
 /*** G L O B A L S *************************************************/
 uint8_t         u8_uartRXbuf;
@@ -56,6 +59,33 @@ uint8_t         u8_uartTXbuf;
 /*********************************************************
  * Public functions intended to be called by other files *
  *********************************************************/
+#ifdef ESOS_USE_DMA_TX
+// USART2_TX is DMA1 channel 7, request 2, on the STM32L4
+#define   __ESOS_DMA_TX           DMA1
+#define   __ESOS_DMA_TX_CHANNEL   DMA_CHANNEL7
+#define   __ESOS_DMA_TX_REQUEST   2
+
+inline void    __esos_hw_signal_start_tx(void) {
+  __esos_DmaTxKick();
+}
+
+void    __esos_hw_dma_tx_start(uint8_t* pu8_Data, uint16_t u16_Len) {
+  dma_disable_channel(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL);
+  dma_set_memory_address(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, (uint32_t) pu8_Data);
+  dma_set_number_of_data(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, u16_Len);
+  dma_enable_channel(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL);
+}
+
+void dma1_channel7_isr(void)
+{
+	if (dma_get_interrupt_flag(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, DMA_TCIF)) {
+		dma_clear_interrupt_flags(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, DMA_TCIF);
+		dma_disable_channel(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL);
+		// retire the span just sent and start the next one (if any)
+		__esos_DmaTxComplete();
+	}
+}
+#else
 inline void    __esos_hw_signal_start_tx(void) {
   if __esos_IsSystemFlagClear(__ESOS_SYS_COMM_TX_ONGOING) {
     // no TX is currently ongoing, so kick it off.
@@ -66,13 +96,40 @@ inline void    __esos_hw_signal_start_tx(void) {
     //  address to the HAL_UART_Transmit_IT.  The ESOS CB don't
     //  have a routine that returns a pointer to data, and I
     //  don't trust the HAL enough to pass an address into my CB.
-	u8_uartTXbuf = __esos_CB_ReadUINT8(  __pst_CB_Tx );
+	u8_uartTXbuf = __esos_SPSC_ReadUINT8(  __pst_CB_Tx );
 	  
 	usart_send(USART_CONSOLE, u8_uartTXbuf);
 	usart_enable_tx_interrupt(USART_CONSOLE);
 	//HAL_UART_Transmit_IT(&st_huart2, &u8_uartTXbuf, 1);
   }
 }
+#endif    // ESOS_USE_DMA_TX
+
+#ifdef ESOS_USE_DMA_RX
+// USART2_RX is DMA1 channel 6, request 2, on the STM32L4
+#define   __ESOS_DMA_RX           DMA1
+#define   __ESOS_DMA_RX_CHANNEL   DMA_CHANNEL6
+#define   __ESOS_DMA_RX_REQUEST   2
+
+void    __esos_hw_dma_rx_start(uint8_t* pu8_Data, uint16_t u16_Len) {
+  dma_disable_channel(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+  dma_set_memory_address(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, (uint32_t) pu8_Data);
+  dma_set_number_of_data(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, u16_Len);
+  dma_enable_channel(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+}
+
+void dma1_channel6_isr(void)
+{
+	if (dma_get_interrupt_flag(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, DMA_HTIF)) {
+		dma_clear_interrupt_flags(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, DMA_HTIF);
+	}
+	if (dma_get_interrupt_flag(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, DMA_TCIF)) {
+		dma_clear_interrupt_flags(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, DMA_TCIF);
+	}
+	// half or all of the ring has been filled.  Publish it.
+	__esos_DmaRxUpdate( dma_get_number_of_data(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL) );
+}
+#endif    // ESOS_USE_DMA_RX
 
 inline void    __esos_hw_signal_stop_tx(void) {
   __esos_ClearSystemFlag(__ESOS_SYS_COMM_TX_ONGOING);
@@ -98,6 +155,13 @@ void usart2_isr(void)
 	 * has been fired. We will need to determine which one it is
 	 * and handle it appropriately.
 	 */
+#ifdef ESOS_USE_DMA_RX
+	if ((USART_ISR(USART_CONSOLE) & USART_ISR_IDLE) != 0) {
+		// the line went quiet:  publish the burst the DMA has received
+		USART_ICR(USART_CONSOLE) = USART_ICR_IDLECF;
+		__esos_DmaRxUpdate( dma_get_number_of_data(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL) );
+	}
+#endif
 	if(((USART_CR1(USART_CONSOLE) & USART_CR1_RXNEIE) != 0) &&
 	   ((USART_ISR(USART_CONSOLE) & USART_ISR_RXNE) != 0 ))
 	{
@@ -105,11 +169,12 @@ void usart2_isr(void)
 		 * byte into the UART.
 		 */
 		
-		// call CB overwrite.... we can't block here in the ISR so
-  		// if data comes in too fast, we will just overwrite existing
-  		// data in the CBs
+		// we are the producer of the lock-free RX ring.... we can't
+		// block here in the ISR so if data comes in too fast, the
+		// newest data is dropped.  (Overwriting the oldest data would
+		// require us to move the task-owned tail.)
 		u8_uartRXbuf = usart_recv(USART_CONSOLE);
-		__esos_CB_OverwriteUINT8( __pst_CB_Rx, u8_uartRXbuf );
+		__esos_SPSC_WriteUINT8( __pst_CB_Rx, u8_uartRXbuf );
 		// request HAL UART handler to get ONE more byte
 		//enable the error condition flags (overrun, noise, framing)
 		//usart_enable_error_interrupt(USART_CONSOLE);
@@ -120,7 +185,7 @@ void usart2_isr(void)
 	{
 		/* If the code reaches here, the HW transmit buffer is empty
 		 */
-		if (__ESOS_CB_IS_EMPTY( __pst_CB_Tx)) {
+		if (__ESOS_SPSC_IS_EMPTY( __pst_CB_Tx)) {
     		//empty TX buffer, disable the interrupt, do not clear the flag
     		usart_disable_tx_interrupt(USART_CONSOLE);
 			__esos_hw_signal_stop_tx();
@@ -132,7 +197,7 @@ void usart2_isr(void)
 			//  address to the HAL_UART_Transmit_IT.  The ESOS CB don't
 			//  have a routine that returns a pointer to data, and I
 			//  don't trust the HAL enough to pass an address into my CB.
-			u8_uartTXbuf = __esos_CB_ReadUINT8(  __pst_CB_Tx );
+			u8_uartTXbuf = __esos_SPSC_ReadUINT8(  __pst_CB_Tx );
 			usart_send(USART_CONSOLE, u8_uartTXbuf);
 			usart_enable_tx_interrupt(USART_CONSOLE);
 		}
@@ -181,8 +246,46 @@ void __esos_configUART1(uint32_t u32_baudRate) {
 	// This interrupt will happen if the transmit buffer is empty
     usart_disable_tx_interrupt(USART_CONSOLE);
 	//usart_enable_error_interrupt(USART_CONSOLE);
+#ifdef ESOS_USE_DMA_RX
+	// RX goes straight into the RX ring by circular DMA.  Interrupt
+	// only on half/full ring and when the line goes idle.
+	usart_disable_rx_interrupt(USART_CONSOLE);
+	USART_CR1(USART_CONSOLE) |= USART_CR1_IDLEIE;
+	rcc_periph_clock_enable(RCC_DMA1);
+	dma_channel_reset(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+	dma_set_channel_request(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, __ESOS_DMA_RX_REQUEST);
+	dma_set_peripheral_address(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, (uint32_t) &USART_RDR(USART_CONSOLE));
+	dma_set_read_from_peripheral(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+	dma_enable_memory_increment_mode(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+	dma_set_peripheral_size(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, DMA_CCR_PSIZE_8BIT);
+	dma_set_memory_size(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, DMA_CCR_MSIZE_8BIT);
+	dma_set_priority(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL, DMA_CCR_PL_HIGH);
+	dma_enable_circular_mode(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+	dma_enable_half_transfer_interrupt(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+	dma_enable_transfer_complete_interrupt(__ESOS_DMA_RX, __ESOS_DMA_RX_CHANNEL);
+	nvic_enable_irq(NVIC_DMA1_CHANNEL6_IRQ);
+	usart_enable_rx_dma(USART_CONSOLE);
+#else
 	usart_enable_rx_interrupt(USART_CONSOLE);
 	// usart_disable_rx_interrupt(USART_CONSOLE);
+#endif
+
+#ifdef ESOS_USE_DMA_TX
+	// TX is fed straight from the TX ring by DMA:  memory-to-peripheral,
+	// bytes, memory address incrementing, interrupt on transfer complete
+	rcc_periph_clock_enable(RCC_DMA1);
+	dma_channel_reset(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL);
+	dma_set_channel_request(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, __ESOS_DMA_TX_REQUEST);
+	dma_set_peripheral_address(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, (uint32_t) &USART_TDR(USART_CONSOLE));
+	dma_set_read_from_memory(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL);
+	dma_enable_memory_increment_mode(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL);
+	dma_set_peripheral_size(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, DMA_CCR_PSIZE_8BIT);
+	dma_set_memory_size(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, DMA_CCR_MSIZE_8BIT);
+	dma_set_priority(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL, DMA_CCR_PL_MEDIUM);
+	dma_enable_transfer_complete_interrupt(__ESOS_DMA_TX, __ESOS_DMA_TX_CHANNEL);
+	nvic_enable_irq(NVIC_DMA1_CHANNEL7_IRQ);
+	usart_enable_tx_dma(USART_CONSOLE);
+#endif
 
 	/* Finally enable the USART. */
 	usart_enable(USART_CONSOLE);
@@ -224,7 +327,7 @@ void __esos_hw_InitCommSystem(void) {
 
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxInDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxInDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -245,12 +348,12 @@ void __esos_hw_InitCommSystem(void) {
  *                  it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxInDataLen(void) {
+uint16_t esos_GetCommSystemMaxInDataLen(void) {
   return ESOS_SERIAL_OUT_EP_SIZE;
 } //end esos_GetCommSystemMaxInDataLen()
 
 /******************************************************************************
- * Function:        uint8_t esos_GetCommSystemMaxOutDataLen(void)
+ * Function:        uint16_t esos_GetCommSystemMaxOutDataLen(void)
  *
  * PreCondition:    None.
  *
@@ -273,7 +376,7 @@ uint8_t esos_GetCommSystemMaxInDataLen(void) {
  *                  if it chooses to be.
  *
  *****************************************************************************/
-uint8_t esos_GetCommSystemMaxOutDataLen(void) {
+uint16_t esos_GetCommSystemMaxOutDataLen(void) {
   return  ESOS_SERIAL_IN_EP_SIZE;
 } //end esos_GetCommSystemMaxOutDataLen()
 
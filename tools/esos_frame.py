@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+# All rights reserved.
+# (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+#
+# Permission to use, copy, modify, and distribute this software and its
+# documentation for any purpose, without fee, and without written agreement is
+# hereby granted, provided that the above copyright notice, the following
+# two paragraphs and the authors appear in all copies of this software.
+#
+# IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+# DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+# OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+# HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+# AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+# ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+# PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+#
+# Please maintain this header in its entirety when copying/modifying
+# these files.
+#
+"""Builds and reads ESOS frames (see include/esos_frame.h).
+
+On the wire a frame is COBS([type][data...][CRC-16/CCITT, little-endian])
+followed by a zero byte.  Use it as a module, e.g.
+
+    from esos_frame import encode_frame, FrameReader
+
+or from the command line to send one frame, or to print the frames that
+arrive, e.g.
+
+    esos_frame.py send /dev/ttyACM0 0x10 01020304
+    esos_frame.py listen /dev/ttyACM0
+
+(The serial port must already be set up, e.g. with stty.)
+"""
+
+import argparse
+import os
+import sys
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT (polynomial 0x1021, not reflected), as esos_buffer_crc16()."""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_pos, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+        if not b or code == 0xFF:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+    out[code_pos] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Returns the decoded bytes, or None if data is not valid COBS."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(frame_type, data=b""):
+    """Returns the bytes to send for a frame (closing zero included)."""
+    body = bytes([frame_type]) + bytes(data)
+    crc = crc16(body)
+    return cobs_encode(body + bytes([crc & 0xFF, crc >> 8])) + b"\0"
+
+
+class FrameReader:
+    """Turns a stream of bytes back into (type, data) frames."""
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.errors = 0
+
+    def feed(self, chunk):
+        """Adds received bytes and returns the list of good frames they complete."""
+        frames = []
+        self.buf += chunk
+        while True:
+            end = self.buf.find(b"\0")
+            if end < 0:
+                return frames
+            raw, self.buf = bytes(self.buf[:end]), self.buf[end + 1:]
+            if not raw:
+                continue
+            body = cobs_decode(raw)
+            if body is None or len(body) < 3 or crc16(body[:-2]) != body[-2] | (body[-1] << 8):
+                self.errors += 1
+                continue
+            frames.append((body[0], body[1:-2]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Send or receive ESOS frames.")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    send = sub.add_parser("send", help="send one frame")
+    send.add_argument("port", help="serial device or file ('-' for stdout)")
+    send.add_argument("type", type=lambda s: int(s, 0), help="frame type (0-255)")
+    send.add_argument("data", nargs="?", default="", help="the data, in hex")
+    listen = sub.add_parser("listen", help="print the frames that arrive")
+    listen.add_argument("port", help="serial device or file ('-' for stdin)")
+    args = parser.parse_args()
+
+    if args.cmd == "send":
+        frame = encode_frame(args.type, bytes.fromhex(args.data))
+        if args.port == "-":
+            sys.stdout.buffer.write(frame)
+        else:
+            with open(args.port, "wb", buffering=0) as f:
+                f.write(frame)
+        return
+    reader = FrameReader()
+    fd = sys.stdin.fileno() if args.port == "-" else os.open(args.port, os.O_RDONLY)
+    while True:
+        chunk = os.read(fd, 4096)
+        if not chunk:
+            break
+        for frame_type, data in reader.feed(chunk):
+            print("type 0x%02X  len %4u  %s" % (frame_type, len(data), data.hex()))
+            sys.stdout.flush()
+    if reader.errors:
+        print("%u bad frames" % reader.errors, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+#
+# "Copyright (c) 2019 J. W. Bruce ("AUTHOR(S)")"
+# All rights reserved.
+# (J. W. Bruce, jwbruce_AT_tntech.edu, Tennessee Tech University)
+#
+# Permission to use, copy, modify, and distribute this software and its
+# documentation for any purpose, without fee, and without written agreement is
+# hereby granted, provided that the above copyright notice, the following
+# two paragraphs and the authors appear in all copies of this software.
+#
+# IN NO EVENT SHALL THE "AUTHORS" BE LIABLE TO ANY PARTY FOR
+# DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT
+# OF THE USE OF THIS SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE "AUTHORS"
+# HAS BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# THE "AUTHORS" SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+# INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+# AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+# ON AN "AS IS" BASIS, AND THE "AUTHORS" HAS NO OBLIGATION TO
+# PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS."
+#
+# Please maintain this header in its entirety when copying/modifying
+# these files.
+#
+"""Decodes the ESOS deferred binary log (see include/esos_log.h).
+
+The format strings are read from the "esos_log" section of the ELF file
+of the build that made the log.  The log is read from a file, or from
+stdin when no file is given, e.g.
+
+    esos_logdecode.py build/app.elf /dev/ttyACM0
+    ./app | esos_logdecode.py app
+
+Every record starts with the sync byte 0xFF, which never starts text.
+Bytes that are not log records (e.g. text written to the same channel,
+or a record that does not check out) are passed through unchanged, and
+decoding picks up again at the next sync byte.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SECTION = b"esos_log"
+SYNC = 0xFF
+CONVERSION = re.compile(r"%([-0+ #]*)(\*|\d+)?(?:\.(\*|\d*))?(hh|h|ll|l)?([diuxXcsq%])")
+
+
+def read_format_table(path):
+    """Returns {format id: format string} from the ELF file at path."""
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        sys.exit("%s: not an ELF file" % path)
+    is64 = elf[4] == 2
+    end = "<" if elf[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(end + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x3A)
+        shdr = end + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(end + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", elf, 0x2E)
+        shdr = end + "IIIIIIIIII"
+    sections = [struct.unpack_from(shdr, elf, shoff + i * shentsize) for i in range(shnum)]
+    names_off = sections[shstrndx][4]
+    for name, _, _, _, offset, size, _, _, _, _ in sections:
+        if elf[names_off + name:elf.index(b"\0", names_off + name)] == SECTION:
+            data = elf[offset:offset + size]
+            break
+    else:
+        sys.exit("%s: no %s section (was it built with ESOS_USE_LOG?)" % (path, SECTION.decode()))
+    # the strings are NUL-terminated, with (maybe) alignment padding between
+    table = {}
+    i = 0
+    while i < len(data):
+        if data[i] == 0:
+            i += 1
+            continue
+        j = data.index(b"\0", i)
+        table[i] = data[i:j].decode("latin-1")
+        i = j + 1
+    return table
+
+
+class Record(Exception):
+    """Raised when the bytes do not hold a valid record."""
+
+
+def get_varint(buf, pos):
+    value = shift = 0
+    while True:
+        if pos >= len(buf) or shift > 63:
+            raise Record()
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value, pos
+
+
+def get_signed(buf, pos):
+    value, pos = get_varint(buf, pos)
+    return (value >> 1) ^ -(value & 1), pos
+
+
+def render(fmt, body, pos):
+    """Rebuilds the text of a record from its argument bytes."""
+    out = []
+    last = 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width, pos = get_signed(body, pos)
+            if width < 0:
+                flags, width = flags + "-", -width
+        if prec == "*":
+            prec, pos = get_signed(body, pos)
+            prec = None if prec < 0 else prec
+        elif prec is not None:
+            prec = int(prec or 0)
+        width = int(width or 0)
+        if conv in "di":
+            value, pos = get_signed(body, pos)
+            if length in ("h", "hh"):
+                bits = 16 if length == "h" else 8
+                value = ((value + (1 << (bits - 1))) & ((1 << bits) - 1)) - (1 << (bits - 1))
+        elif conv in "uxX":
+            value, pos = get_varint(body, pos)
+            if length in ("h", "hh"):
+                value &= 0xFFFF if length == "h" else 0xFF
+        elif conv == "q":
+            value, pos = get_signed(body, pos)
+        elif conv == "c":
+            if pos >= len(body):
+                raise Record()
+            value = chr(body[pos])
+            pos += 1
+        else:
+            n, pos = get_varint(body, pos)
+            if pos + n > len(body):
+                raise Record()
+            value = body[pos:pos + n].decode("latin-1")
+            pos += n
+        if conv == "q":
+            frac = min(prec or 0, 9)
+            text = str(abs(value) // 10 ** frac)
+            if frac:
+                text += "." + str(abs(value) % 10 ** frac).zfill(frac)
+            sign = "-" if value < 0 else "+" if "+" in flags else " " if " " in flags else ""
+            if "0" in flags and "-" not in flags:
+                text = text.zfill(width - len(sign))
+            out.append(("%-*s" if "-" in flags else "%*s") % (width, sign + text))
+            continue
+        if conv in "xX" and value == 0:
+            flags = flags.replace("#", "")      # C prints no 0x in front of zero
+        if conv in "diuxX" and prec is not None:
+            flags = flags.replace("0", "")      # C ignores '0' when there is a precision
+            if prec == 0 and value == 0:
+                out.append(("%-*s" if "-" in flags else "%*s") % (width, ""))
+                continue
+        spec = "%" + flags + str(width) + ("" if prec is None else "." + str(prec)) + (conv if conv != "u" else "d")
+        out.append(spec % value)
+    out.append(fmt[last:])
+    if pos != len(body):
+        raise Record()
+    return "".join(out)
+
+
+def decode(table, stream, out, show_ticks=True):
+    buf = b""
+    tick = 0
+    while True:
+        chunk = os.read(stream.fileno(), 4096)
+        if not chunk:
+            break
+        buf += chunk
+        pos = 0
+        while pos < len(buf):
+            if buf[pos] != SYNC:
+                # text:  pass it through up to the next sync byte
+                end = buf.find(bytes([SYNC]), pos)
+                end = len(buf) if end < 0 else end
+                out.write(buf[pos:end].decode("latin-1"))
+                pos = end
+                continue
+            if pos + 2 > len(buf) or pos + 2 + buf[pos + 1] > len(buf):
+                break                   # wait for the rest of the record
+            length = buf[pos + 1]
+            body = buf[pos + 2:pos + 2 + length]
+            try:
+                if length < 3:
+                    raise Record()
+                fmt = table.get(body[0] | (body[1] << 8))
+                if fmt is None:
+                    raise Record()
+                delta, args = get_varint(body, 2)
+                text = render(fmt, body, args)
+            except Record:
+                # not a record:  pass the sync byte through and resync on the next
+                out.write(buf[pos:pos + 1].decode("latin-1"))
+                pos += 1
+                continue
+            tick += delta
+            if show_ticks:
+                out.write("[%10u] " % tick)
+            out.write(text.rstrip("\n") + "\n")
+            pos += 2 + length
+        buf = buf[pos:]
+        out.flush()
+    out.write(buf.decode("latin-1"))
+    out.flush()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode an ESOS binary log.")
+    parser.add_argument("elf", help="the ELF file of the build that made the log")
+    parser.add_argument("log", nargs="?", help="the log (a file or a serial device); stdin if left out")
+    parser.add_argument("--no-ticks", action="store_true", help="leave out the system tick in front of each message")
+    parser.add_argument("--dump", action="store_true", help="list the format strings and their ids, then quit")
+    args = parser.parse_args()
+
+    table = read_format_table(args.elf)
+    if args.dump:
+        for fid in sorted(table):
+            print("%5u  %r" % (fid, table[fid]))
+        return
+    stream = open(args.log, "rb", buffering=0) if args.log else sys.stdin.buffer
+    decode(table, stream, sys.stdout, not args.no_ticks)
+
+
+if __name__ == "__main__":
+    main()